@@ -41,8 +41,19 @@
 #include "led_feedback.h"
 #include "wifi_manager.h"
 #include "barcode_scanner.h"
+#include "frame_quality.h"
+#include "band_capture.h"
+#include "flash_strobe.h"
 #include "api_client.h"
+#include "telemetry.h"
+#include "wake_timing.h"
+#include "alloc_check.h"
+#include "power_idle.h"
 #include "debug_server.h"
+#include "input_events.h"
+#ifdef ENABLE_SELF_BENCH
+#include "self_bench.h"
+#endif
 
 #if defined(BOARD_WROVER)
     #define PIR_PIN 34
@@ -55,48 +66,45 @@
     #define BOOT_BTN 0
 #endif
 
-const unsigned long PIR_CHECK_INTERVAL = 2000;
 const unsigned long MODE_TIMEOUT = 30000;
 const unsigned long SCAN_COOLDOWN = 3000;
-const unsigned long LONG_PRESS_TIME = 1000;
-const unsigned long DEBOUNCE_TIME = 50;
 const unsigned long DEEP_SLEEP_TIMEOUT = 300000;
+const unsigned long IDLE_WAIT_MAX = 60000;   // Upper bound for one loop() wait
 
 RTC_DATA_ATTR bool modeAdd = true;
 RTC_DATA_ATTR int bootCount = 0;
 RTC_DATA_ATTR bool wasInOutMode = false;
 
 volatile unsigned long lastActivity = 0;
-volatile bool pirTriggered = false;
-unsigned long lastPIRCheck = 0;
 unsigned long lastScanTime = 0;
 unsigned long modeChangeTime = 0;
-unsigned long buttonPressStart = 0;
-bool buttonPressed = false;
+bool wakePending = false;       // PIR wake: time the first decode
+bool deferredInit = false;      // WiFiManager/debug server still to start
 
 void printBanner();
 void showMode();
 void toggleMode();
 void handleScan();
 void handleReceiptScan();
+void handleInputEvent(const InputEvent &ev);
+unsigned long idleWaitMs(unsigned long now);
+void finishDeferredInit();
 #ifdef ENABLE_DEEP_SLEEP
 void enterDeepSleep();
 #endif
 
-// Button timing constants
-const unsigned long RECEIPT_PRESS_TIME = 3000;  // 3 sec = receipt scan
-
-#ifdef ENABLE_PIR
-void IRAM_ATTR pirISR() { pirTriggered = true; lastActivity = millis(); }
-#endif
-
 void setup() {
     Serial.begin(115200);
-    delay(500);
     bootCount++;
     lastActivity = millis();
     esp_sleep_wakeup_cause_t wr = esp_sleep_get_wakeup_cause();
-    printBanner();
+    if(wr == ESP_SLEEP_WAKEUP_EXT0) wakeMeasureBoot();
+
+    // PIR wake: the item is in front of the lens right now. Start joining
+    // the last AP so the radio associates while the camera comes up, and
+    // leave everything not needed for the first scan until after it.
+    bool fastWake = (wr == ESP_SLEEP_WAKEUP_EXT0) && wifiFastBegin();
+    if(!fastWake) { delay(500); printBanner(); }
     switch(wr) {
         case ESP_SLEEP_WAKEUP_EXT0: Serial.println("Wake: PIR!"); break;
         case ESP_SLEEP_WAKEUP_TIMER: Serial.println("Wake: Timer"); break;
@@ -105,13 +113,18 @@ void setup() {
     initLED();
     pinMode(BOOT_BTN, INPUT_PULLUP);
 
+    initScanTrace();
+
     // Initialize camera FIRST (before PIR to avoid GPIO ISR conflict)
-    if(!initCamera()) { Serial.println("Camera FAIL!"); ledError(); speakerError(); delay(3000); ESP.restart(); }
+    if(!initCamera()) { Serial.println("Camera FAIL!"); ledError(); speakerError(); feedbackFlush(3000); ESP.restart(); }
     Serial.println("Camera OK");
+    initFlashStrobe();
+
+    // Button + PIR interrupts -> event queue
+    initInput(BOOT_BTN, PIR_PIN);
+    initPowerIdle(BOOT_BTN, PIR_PIN);
 
     #ifdef ENABLE_PIR
-        pinMode(PIR_PIN, INPUT);
-        attachInterrupt(digitalPinToInterrupt(PIR_PIN), pirISR, RISING);
         Serial.println("PIR OK");
         if(wasInOutMode && wr == ESP_SLEEP_WAKEUP_EXT0) { modeAdd = false; modeChangeTime = millis(); }
         else { modeAdd = true; wasInOutMode = false; }
@@ -123,8 +136,18 @@ void setup() {
     showMode();
     initBarcodeScanner();
     Serial.println("Scanner OK");
+
+    if(fastWake) {
+        // The wake edge itself came before the ISR was attached
+        wakePending = true;
+        deferredInit = true;
+        inputPost(INPUT_PIR, 0, 0, false);
+        Serial.printf("[WAKE] Pronto a scansionare dopo %u ms\n", (uint32_t)(wakeElapsedUs() / 1000));
+        return;
+    }
+
     setupWiFiManager();
-    speakerBeep(2000,100); delay(100); speakerBeep(2500,100);
+    speakerBeep(2000,100); speakerRest(100); speakerBeep(2500,100);
 
     // Start debug web server
     initDebugServer();
@@ -134,69 +157,116 @@ void setup() {
 }
 
 void loop() {
+    // Sleep until an input event arrives or the next timed job is due
+    InputEvent ev;
+    int64_t idleStart = powerIdleBegin();
+    bool got = waitInputEvent(&ev, idleWaitMs(millis()));
+    powerIdleEnd(idleStart);
+    if(got) {
+        powerActive();
+        handleInputEvent(ev);
+        powerRelease();
+    }
+    if(deferredInit) finishDeferredInit();
+
     unsigned long now = millis();
 
-    // Simple button handling:
-    // - Short press (<1s) = barcode scan
-    // - Medium press (1-3s) = toggle mode
-    // - Long press (>3s) = receipt scan
-    bool btn = (digitalRead(BOOT_BTN) == LOW);
-
-    if(btn && !buttonPressed) {
-        // Button just pressed
-        buttonPressed = true;
-        buttonPressStart = now;
-        lastActivity = now;
+    // Mode timeout (auto-return to IN mode)
+    if(!modeAdd && modeChangeTime > 0 && (now - modeChangeTime > MODE_TIMEOUT)) {
+        Serial.println("Timeout->IN"); modeAdd = true; wasInOutMode = false; modeChangeTime = 0; showMode();
     }
-    else if(!btn && buttonPressed) {
-        // Button just released
-        unsigned long dur = now - buttonPressStart;
-        buttonPressed = false;
 
-        if(dur >= RECEIPT_PRESS_TIME) {
-            // Very long press (3+ sec): Receipt scan
+    // Park the sensor once neither a scan nor the debug stream needs frames
+    #ifdef ENABLE_LIGHT_SLEEP
+    if(!cameraAsleep && now - lastActivity > IDLE_STANDBY_MS && (long)(now - frameDemandUntil) > 0) {
+        cameraStandby();
+    }
+    #endif
+
+    // Fleet heartbeat (not while the button is held)
+    if(!inputButtonDown) handleTelemetry(now);
+
+    // Deep sleep (only if enabled)
+    #ifdef ENABLE_DEEP_SLEEP
+    if(now - lastActivity > DEEP_SLEEP_TIMEOUT) enterDeepSleep();
+    #endif
+}
+
+// Button classification happens in the ISR:
+// - Short press (<1s) = barcode scan
+// - Medium press (1-3s) = toggle mode
+// - Long press (>3s) = receipt scan
+// - Very long press (>8s) = decoder benchmark (ENABLE_SELF_BENCH)
+void handleInputEvent(const InputEvent &ev) {
+    unsigned long now = millis();
+    lastActivity = now;
+    Serial.printf("[INPUT] Evento %d (%lu ms premuto), latenza %lu ms\n",
+                  ev.type, (unsigned long)ev.heldMs, (unsigned long)inputLatency(ev));
+
+    switch(ev.type) {
+        case INPUT_RECEIPT:
             Serial.println("\n>>> SCONTRINO <<<");
-            speakerBeep(1000,50); delay(50); speakerBeep(1500,50); delay(50); speakerBeep(2000,50);
-            handleReceiptScan();
-            lastScanTime = now;
-        }
-        else if(dur >= LONG_PRESS_TIME) {
-            // Medium press (1-3 sec): Toggle IN/OUT mode
+            speakerBeep(1000,50); speakerRest(50); speakerBeep(1500,50); speakerRest(50); speakerBeep(2000,50);
+            cameraBusy = true; debugDecodeYield(); handleReceiptScan(); cameraBusy = false;
+            lastScanTime = millis();
+            break;
+        case INPUT_TOGGLE:
             toggleMode();
             modeChangeTime = now;
-        }
-        else if(dur >= DEBOUNCE_TIME) {
-            // Short press (<1 sec): Barcode scan
+            break;
+        case INPUT_SCAN:
             Serial.println("\n>>> SCAN <<<");
             speakerBeep(1500,50);
-            handleScan();
-            lastScanTime = now;
-        }
-        delay(100);  // Debounce
+            cameraBusy = true; debugDecodeYield(); handleScan(); cameraBusy = false;
+            lastScanTime = millis();
+            break;
+        case INPUT_PIR:
+            // Motion queued during a scan lands inside the cooldown and is dropped
+            if(lastScanTime == 0 || now - lastScanTime > SCAN_COOLDOWN) {
+                Serial.println("\n>>> PIR <<<"); speakerBeep(1500,50);
+                cameraBusy = true; debugDecodeYield(); handleScan(); cameraBusy = false;
+                lastScanTime = millis();
+            }
+            break;
+        #ifdef ENABLE_SELF_BENCH
+        case INPUT_BENCH:
+            Serial.println("\n>>> BENCHMARK <<<");
+            speakerBeep(2000,50); speakerRest(50); speakerBeep(2000,50);
+            cameraBusy = true; debugDecodeYield(); runSelfBench(); cameraBusy = false;
+            break;
+        #endif
     }
+}
 
-    // PIR motion detection (only if enabled)
-    #ifdef ENABLE_PIR
-    if(pirTriggered || (now - lastPIRCheck > PIR_CHECK_INTERVAL && digitalRead(PIR_PIN) == HIGH)) {
-        pirTriggered = false; lastPIRCheck = now; lastActivity = now;
-        if(now - lastScanTime > SCAN_COOLDOWN) { Serial.println("\n>>> PIR <<<"); speakerBeep(1500,50); handleScan(); lastScanTime = now; }
+// Rest of setup() after a fast wake, once the first scan is done
+void finishDeferredInit() {
+    deferredInit = false;
+    if(!checkWiFi()) setupWiFiManager();
+    initDebugServer();
+    Serial.println("BOOT: click=scan, 1s=toggle, 3s=scontrino\n");
+}
+
+// Time until the earliest of mode timeout, telemetry, sensor standby and deep sleep
+unsigned long idleWaitMs(unsigned long now) {
+    unsigned long wait = min(IDLE_WAIT_MAX, telemetryDueIn(now));
+    #ifdef ENABLE_LIGHT_SLEEP
+    if(!cameraAsleep) {
+        unsigned long idle = now - lastActivity;
+        // Past the deadline only while the debug stream holds it: re-check in 1 s
+        wait = min(wait, idle > IDLE_STANDBY_MS ? 1000UL : IDLE_STANDBY_MS - idle + 1);
     }
     #endif
-
-    // Mode timeout (auto-return to IN mode)
-    if(!modeAdd && modeChangeTime > 0 && (now - modeChangeTime > MODE_TIMEOUT)) {
-        Serial.println("Timeout->IN"); modeAdd = true; wasInOutMode = false; modeChangeTime = 0; showMode();
+    if(!modeAdd && modeChangeTime > 0) {
+        unsigned long elapsed = now - modeChangeTime;
+        wait = min(wait, elapsed > MODE_TIMEOUT ? 0UL : MODE_TIMEOUT - elapsed + 1);
     }
-
-    // Deep sleep (only if enabled)
     #ifdef ENABLE_DEEP_SLEEP
-    if(now - lastActivity > DEEP_SLEEP_TIMEOUT) enterDeepSleep();
+    unsigned long idle = now - lastActivity;
+    wait = min(wait, idle > DEEP_SLEEP_TIMEOUT ? 0UL : DEEP_SLEEP_TIMEOUT - idle + 1);
     #endif
-
-    // Handle debug web server requests
-    handleDebugServer();
-
-    delay(10);
+    // While the button is held, telemetry is deferred: re-check after release
+    if(inputButtonDown && wait == 0) wait = DEBOUNCE_MS;
+    return wait;
 }
 
 void printBanner() {
@@ -229,9 +299,8 @@ void toggleMode() {
     modeAdd = !modeAdd; wasInOutMode = !modeAdd;
     Serial.printf("Modo: %s\n", modeAdd ? "IN" : "OUT");
     for(int i=0; i<3; i++) {
-        if(modeAdd) { ledModeIn(); speakerBeep(1000+i*200, 100); }
-        else { ledModeOut(); speakerBeep(1400-i*200, 100); }
-        delay(150);
+        speakerBeep(modeAdd ? 1000+i*200 : 1400-i*200, 100);
+        speakerRest(150);
     }
     showMode();
 }
@@ -239,34 +308,110 @@ void toggleMode() {
 void handleScan() {
     Serial.println("\n==== SCAN ====");
     lastActivity = millis();
+    TRACE_BEGIN(tScan);
     ledProcessing(); speakerBeep(1800,50);
-    flashOn(); delay(300);
-    camera_fb_t *fb = esp_camera_fb_get();
-    if(!fb) { Serial.println("Frame fail!"); flashOff(); ledError(); speakerError(); showMode(); return; }
-    Serial.printf("Frame: %dx%d\n", fb->width, fb->height);
-    flashOff();
-    BarcodeResult result = scanBarcode(fb);
+    TRACE_BEGIN(tFlash);
+    captureFlashOn();
+    TRACE_END(TRACE_FLASH, tFlash);
+    // Capture -> decode (-> local OCR) must not allocate; the upload part may
+    // (TLS buffers) but must give everything back
+    AllocProbe scanProbe, decodeProbe;
+    allocProbeBegin(&scanProbe, true);
+    allocProbeBegin(&decodeProbe);
+    TRACE_BEGIN(tCapture);
+    CameraBurst burst;
+    BarcodeList codes = {};
+    unsigned long tDecode = millis();
+    #ifdef ENABLE_BAND_CAPTURE
+    // No PSRAM: bands are decoded as they arrive, inside the capture
+    bool captured = cameraBandMode ? bandCapture(&burst, &codes) : burstCapture(&burst);
+    #else
+    bool captured = burstCapture(&burst);
+    #endif
+    TRACE_END(TRACE_CAPTURE, tCapture);
+    if(!captured) { Serial.println("Frame fail!"); captureFlashOff(); ledError(); speakerError(); showMode(); return; }
+    captureFlashOff();
+    // Sharpest first; the runner-up only if the best one did not decode
+    if(!cameraBandMode) tDecode = millis();
+    camera_fb_t *fb = burst.count ? burst.fb[0] : NULL;
+    for(int i=0; i<burst.count && codes.count == 0; i++) {
+        fb = burst.fb[i];
+        Serial.printf("Frame #%d: %dx%d\n", burst.seq[i], fb->width, fb->height);
+        scanBarcodes(fb, &codes);
+    }
+    #ifdef ENABLE_SCANLINE_FUSION
+    if(codes.count == 0) {
+        // Every burst frame's scanlines, aligned and averaged
+        if(barcodeListAdd(&codes, fusionDecode())) fb = burst.fb[0];
+    }
+    #endif
+    #ifdef SCAN_DETAIL_RETRY
+    if(codes.count == 0 && cameraHasProfile(CAM_PROFILE_DETAIL)) {
+        // Small or distant code: one more burst at the detail resolution,
+        // back to the scan profile once its frames are released below
+        burstRelease(&burst);
+        bool detail = cameraUseProfile(CAM_PROFILE_DETAIL);
+        captureFlashOn();
+        allocProbeBegin(&decodeProbe);  // The switch re-allocated the driver's buffers
+        if(!detail || !burstCapture(&burst)) cameraLock();     // Held as burstRelease() expects
+        captureFlashOff();
+        for(int i=0; i<burst.count && codes.count == 0; i++) {
+            fb = burst.fb[i];
+            Serial.printf("Dettaglio #%d: %dx%d\n", burst.seq[i], fb->width, fb->height);
+            scanBarcodes(fb, &codes);
+        }
+    }
+    #endif
+    const BarcodeResult &result = codes.items[0];   // Zeroed when nothing decoded
+    telemetryNoteScan(result, millis() - tDecode);
+    if(wakePending) {
+        // From the wake stub's RTC stamp, ROM and bootloader included
+        wakePending = false;
+        int64_t wakeUs = wakeElapsedUs();
+        telemetry.wakeMs = wakeUs / 1000;
+        TRACE_END(TRACE_WAKE, esp_timer_get_time() - wakeUs);
+        Serial.printf("[WAKE] Risveglio -> decodifica: %u ms%s%s\n", telemetry.wakeMs,
+                      wakeBootOffsetUs < 0 ? " (avvio ROM/bootloader escluso)" : "",
+                      telemetry.wakeMs > 1000 ? " (oltre 1 s!)" : "");
+    }
     if(result.found) {
-        Serial.printf("%s: %s\n", result.type.c_str(), result.data.c_str());
-        speakerBeep(2500,100);
-        String expiry = "";
-        #if defined(BOARD_ESP32S3)
-            ledBlink(5,50,50); expiry = performLocalOCR(fb);
-        #else
-            ledBlink(3,100,100); expiry = performRemoteOCR(fb);
-        #endif
-        if(expiry.length() > 0) Serial.printf("Scadenza: %s\n", expiry.c_str());
+        debugNoteDecode(result);
+        for(int i=0; i<codes.count; i++) {
+            Serial.printf("%s: %s\n", codes.items[i].type, codes.items[i].data);
+            speakerBeep(2500,100); speakerRest(80);     // One beep per item
+        }
+        char expiry[16] = "";
+        if(codes.count == 1) {
+            TRACE_BEGIN(tOcr);
+            #if defined(BOARD_ESP32S3)
+                ledBlink(5,50,50); performLocalOCR(fb, result, expiry, sizeof(expiry));
+                allocProbeExpectZero(&decodeProbe, "decodifica+OCR");
+            #else
+                allocProbeExpectZero(&decodeProbe, "decodifica");
+                ledBlink(3,100,100); performRemoteOCR(fb, result, expiry, sizeof(expiry));
+            #endif
+            TRACE_END(TRACE_OCR, tOcr);
+            if(expiry[0]) Serial.printf("Scadenza: %s\n", expiry);
+        } else {
+            // A date in the frame could belong to any of the items
+            allocProbeExpectZero(&decodeProbe, "decodifica");
+            Serial.printf("%d prodotti: OCR scadenza saltato\n", codes.count);
+        }
         Serial.println("Invio...");
-        bool ok = sendProductWebhook(result.data, expiry, result.type);
-        esp_camera_fb_return(fb);
+        bool ok = sendProductWebhook(codes, expiry);
+        burstRelease(&burst);
         if(ok) { Serial.println("OK!"); ledSuccess(); speakerSuccess(); }
         else { Serial.println("FAIL"); ledError(); speakerError(); }
     } else {
+        allocProbeExpectZero(&decodeProbe, "decodifica");
         Serial.println("No barcode");
-        esp_camera_fb_return(fb);
+        burstRelease(&burst);
         ledError(); speakerError();
     }
-    delay(1500); showMode();
+    if(cameraProfile != CAM_PROFILE_SCAN) cameraUseProfile(CAM_PROFILE_SCAN);
+    TRACE_END(TRACE_TOTAL, tScan);
+    allocProbeExpectZero(&scanProbe, "scansione (netto)");
+    showMode();
     Serial.println("=============\n");
 }
 
@@ -276,21 +421,23 @@ void handleReceiptScan() {
 
     // Special LED pattern for receipt mode
     for(int i=0; i<3; i++) {
-        ledcWrite(FLASH_LED, 128);
-        delay(100);
-        ledcWrite(FLASH_LED, 0);
-        delay(100);
+        ledStep(128, 100);
+        ledStep(0, 100);
     }
 
-    // Use current camera config (GRAYSCALE) - server can handle it
-    // DON'T change pixel format at runtime - causes FB-SIZE errors!
+    // Receipt profile: an upright grayscale strip in the boot buffers, for
+    // prepareReceipt(). Without PSRAM a VGA JPEG from the sensor, the driver
+    // restarted for it, so before the flash. If that does not fit the receipt
+    // gets the scan frame.
+    cameraUseProfile(CAM_PROFILE_RECEIPT);
 
     flashOn();
-    delay(500); // Longer delay for receipt positioning
+    delay(300);
 
-    camera_fb_t *fb = esp_camera_fb_get();
+    camera_fb_t *fb = cameraGetFrame();
     if(!fb) {
         Serial.println("Frame fail!");
+        cameraUseProfile(CAM_PROFILE_SCAN);
         flashOff();
         ledError();
         speakerError();
@@ -301,20 +448,38 @@ void handleReceiptScan() {
     Serial.printf("Frame: %dx%d, %d bytes\n", fb->width, fb->height, fb->len);
     flashOff();
 
+    // Crop to the paper, estimate skew and threshold grid before upload
+    ReceiptRegion region;
+    bool cropped = false;
+    #ifdef RECEIPT_PREPROCESS
+    if(fb->format == PIXFORMAT_GRAYSCALE) {
+        unsigned long t0 = millis();
+        cropped = prepareReceipt(fb->buf, fb->width, fb->height, &region);
+        if(cropped) {
+            Serial.printf("Scontrino: %dx%d @ (%d,%d), skew %.1f deg, %u bytes 1bpp (%lu ms)\n",
+                          region.w, region.h, region.x, region.y, region.skewDeg,
+                          receiptPackedSize(&region), millis() - t0);
+        } else {
+            Serial.println("Scontrino non isolato, invio frame intero");
+        }
+    }
+    #endif
+
     Serial.println("Invio scontrino al server...");
     ledBlink(5, 100, 100);
 
-    int productsFound = sendReceiptImage(fb);
-    esp_camera_fb_return(fb);
+    int productsFound = sendReceiptImage(fb, cropped ? &region : NULL);
+    cameraReturnFrame(fb);
+    cameraUseProfile(CAM_PROFILE_SCAN);
 
     if(productsFound > 0) {
         Serial.printf("Aggiunti %d prodotti!\n", productsFound);
         // Success feedback - multiple beeps for number of products
         for(int i=0; i<min(productsFound, 5); i++) {
             speakerBeep(2000, 100);
-            ledSuccess();
-            delay(200);
+            speakerRest(200);
         }
+        ledSuccess();
     } else if(productsFound == 0) {
         Serial.println("Nessun prodotto riconosciuto");
         ledError();
@@ -325,7 +490,6 @@ void handleReceiptScan() {
         speakerError();
     }
 
-    delay(1500);
     showMode();
     Serial.println("==================\n");
 }
@@ -334,6 +498,7 @@ void handleReceiptScan() {
 void enterDeepSleep() {
     Serial.println("\n--- SLEEP ---");
     wasInOutMode = !modeAdd;
+    feedbackFlush(2000);
     ledOff(); flashOff();
     WiFi.disconnect(true); WiFi.mode(WIFI_OFF);
     #if defined(ENABLE_PIR) && (defined(BOARD_WROVER) || defined(BOARD_ESP32S3))
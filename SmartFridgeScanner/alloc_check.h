@@ -0,0 +1,73 @@
+#ifndef ALLOC_CHECK_H
+#define ALLOC_CHECK_H
+
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+
+// ============ ALLOCATION CHECK ============
+// Debug counter for the scan path, which must not touch the heap. With
+// CONFIG_HEAP_USE_HOOKS the IDF heap hooks count the allocations and frees
+// made by the watched task: a probe counts every allocation, or with `net`
+// only those not freed again (the upload's TLS buffers, a driver buffer
+// swap). Otherwise the net change in allocated blocks is used (catches
+// retained allocations, other tasks may add noise).
+
+struct AllocProbe {
+    uint32_t allocs;
+    uint32_t frees;
+    size_t blocks;
+    bool net;
+};
+
+uint32_t allocViolations = 0;   // Scans whose decode phase allocated
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+volatile uint32_t heapAllocCount = 0, heapFreeCount = 0;
+TaskHandle_t allocWatchTask = NULL;
+
+extern "C" void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    if (xTaskGetCurrentTaskHandle() == allocWatchTask) heapAllocCount++;
+}
+extern "C" void esp_heap_trace_free_hook(void *ptr) {
+    if (ptr && xTaskGetCurrentTaskHandle() == allocWatchTask) heapFreeCount++;
+}
+#endif
+
+size_t allocatedBlocks() {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+    return info.allocated_blocks;
+}
+
+void allocProbeBegin(AllocProbe *p, bool net = false) {
+#ifdef CONFIG_HEAP_USE_HOOKS
+    allocWatchTask = xTaskGetCurrentTaskHandle();
+    p->allocs = heapAllocCount;
+    p->frees = heapFreeCount;
+#else
+    p->allocs = p->frees = 0;
+#endif
+    p->blocks = allocatedBlocks();
+    p->net = net;
+}
+
+// Allocations since allocProbeBegin (net new blocks without heap hooks)
+int allocProbeCount(const AllocProbe *p) {
+#ifdef CONFIG_HEAP_USE_HOOKS
+    int allocs = heapAllocCount - p->allocs;
+    return p->net ? allocs - (int)(heapFreeCount - p->frees) : allocs;
+#else
+    return (int)allocatedBlocks() - (int)p->blocks;
+#endif
+}
+
+// Logs and counts a violation when the phase allocated; returns true if clean
+bool allocProbeExpectZero(const AllocProbe *p, const char *phase) {
+    int n = allocProbeCount(p);
+    if (n <= 0) return true;
+    allocViolations++;
+    Serial.printf("[HEAP] ⚠ %s: %d allocazioni (attese 0)\n", phase, n);
+    return false;
+}
+
+#endif
@@ -3,9 +3,13 @@
 
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include "img_converters.h"
+#include "receipt_processor.h"
+#include "expiry_ocr.h"
+#include "barcode_scanner.h"
 #include "wifi_manager.h"
+#include "scan_trace.h"
 
 // Forward declarations - variabili definite in main
 extern bool modeAdd;
@@ -13,91 +17,340 @@ extern int bootCount;
 extern bool useLocalOCR;
 extern const char* BOARD_NAME;
 
-// ============ API ENDPOINTS ============
-const char* WEBHOOK_URL = "https://frigo.xamad.net/api/product";
-const char* OCR_URL = "https://frigo.xamad.net/api/ocr";
-const char* RECEIPT_URL = "https://frigo.xamad.net/api/receipt";
+// ============ TLS CONNECT ============
+// Every request to SERVER_HOST goes through here so handshakes are counted
+// for tracing and telemetry.
+struct TlsStats {
+    uint32_t count;
+    uint32_t failures;
+    uint32_t totalMs;
+    uint32_t maxMs;
+};
+TlsStats tlsStats = { 0, 0, 0, 0 };
+
+bool connectServer(WiFiClientSecure &client) {
+    TRACE_BEGIN(tConnect);
+    unsigned long t0 = millis();
+    if(!client.connect(SERVER_HOST, 443)) {
+        tlsStats.failures++;
+        Serial.println("❌ Connessione fallita");
+        return false;
+    }
+    TRACE_END(TRACE_TLS_CONNECT, tConnect);
+    uint32_t ms = millis() - t0;
+    tlsStats.count++;
+    tlsStats.totalMs += ms;
+    if(ms > tlsStats.maxMs) tlsStats.maxMs = ms;
+    return true;
+}
+
+// ============ CHUNKED UPLOAD ============
+// Streams a request body with Transfer-Encoding: chunked, so the body length
+// does not have to be known before the first byte is written. Small writes are
+// coalesced into one chunk per TLS record.
+#define UPLOAD_CHUNK_SIZE 1436
+
+struct ChunkedUpload {
+    WiFiClient *client;
+    uint8_t buf[UPLOAD_CHUNK_SIZE];
+    size_t used;
+    size_t total;       // Body bytes sent (excluding chunk framing)
+    uint32_t minHeap;   // Lowest free heap seen while streaming
+    bool failed;
+};
+
+void chunkBegin(ChunkedUpload *up, WiFiClient *client) {
+    up->client = client;
+    up->used = 0;
+    up->total = 0;
+    up->minHeap = ESP.getFreeHeap();
+    up->failed = false;
+}
+
+void chunkFlush(ChunkedUpload *up) {
+    if(up->used == 0 || up->failed) return;
+    up->client->printf("%X\r\n", up->used);
+    if(up->client->write(up->buf, up->used) != up->used) up->failed = true;
+    up->client->print("\r\n");
+    up->total += up->used;
+    up->used = 0;
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if(freeHeap < up->minHeap) up->minHeap = freeHeap;
+    yield();
+}
+
+void chunkWrite(ChunkedUpload *up, const uint8_t *data, size_t len) {
+    while(len > 0 && !up->failed) {
+        size_t n = min(len, (size_t)UPLOAD_CHUNK_SIZE - up->used);
+        memcpy(up->buf + up->used, data, n);
+        up->used += n;
+        data += n;
+        len -= n;
+        if(up->used == UPLOAD_CHUNK_SIZE) chunkFlush(up);
+    }
+}
+
+void chunkEnd(ChunkedUpload *up) {
+    chunkFlush(up);
+    up->client->print("0\r\n\r\n");
+}
+
+// JPEG encoder output callback: each encoded block goes straight to the socket
+size_t jpgChunkCallback(void *arg, size_t index, const void *data, size_t len) {
+    ChunkedUpload *up = (ChunkedUpload *)arg;
+    chunkWrite(up, (const uint8_t *)data, len);
+    return up->failed ? 0 : len;
+}
+
+// Binarized receipt row sink: packed rows go straight to the socket
+void receiptRowCallback(void *ctx, const uint8_t *row, size_t bytes) {
+    chunkWrite((ChunkedUpload *)ctx, row, bytes);
+}
+
+// ============ MULTIPART POST ============
+#define MULTIPART_BOUNDARY "----ESP32FridgeBoundary"
+
+// Connect, send request headers and open the single "image" form field
+bool beginMultipartPost(WiFiClientSecure &client, ChunkedUpload *up, const char *path,
+                        const char *filename, const char *mime) {
+    if(!connectServer(client)) {
+        return false;
+    }
+
+    // Body length unknown: image is encoded on the fly
+    client.printf("POST %s HTTP/1.1\r\n", path);
+    client.print("Host: " SERVER_HOST "\r\n");
+    client.print("Content-Type: multipart/form-data; boundary=" MULTIPART_BOUNDARY "\r\n");
+    client.print("Transfer-Encoding: chunked\r\n");
+    client.print("Connection: close\r\n\r\n");
+
+    chunkBegin(up, &client);
+    char part[192];
+    int n = snprintf(part, sizeof(part),
+        "--" MULTIPART_BOUNDARY "\r\nContent-Disposition: form-data; name=\"image\"; filename=\"%s\"\r\n"
+        "Content-Type: %s\r\n\r\n", filename, mime);
+    chunkWrite(up, (const uint8_t *)part, n);
+    return true;
+}
+
+void endMultipartPost(ChunkedUpload *up) {
+    const char *tail = "\r\n--" MULTIPART_BOUNDARY "--\r\n";
+    chunkWrite(up, (const uint8_t *)tail, strlen(tail));
+    chunkEnd(up);
+}
+
+// Read one line into `out` (CR/LF stripped, excess dropped).
+// Returns its length, or -1 on timeout / connection closed. The deadline is
+// timeoutMs after `start`, compared as elapsed time so millis() may wrap.
+int readHttpLine(WiFiClientSecure &client, char *out, size_t size, unsigned long start, unsigned long timeoutMs) {
+    size_t n = 0;
+    while(millis() - start < timeoutMs) {
+        if(!client.available()) {
+            if(!client.connected()) break;
+            delay(10);
+            continue;
+        }
+        int c = client.read();
+        if(c == '\n') {
+            out[n] = '\0';
+            return n;
+        }
+        if(c != '\r' && n + 1 < size) out[n++] = c;
+    }
+    out[n] = '\0';
+    return n > 0 ? (int)n : -1;
+}
+
+// Wait for the status line, skip headers and copy the first body line.
+// Returns the HTTP status code, or -1 on timeout.
+int readHttpResponse(WiFiClientSecure &client, char *body, size_t size, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    body[0] = '\0';
+    char line[96];
+    int len;
+    while((len = readHttpLine(client, line, sizeof(line), start, timeoutMs)) >= 0) {
+        if(strncmp(line, "HTTP/", 5) != 0 || len < 12) continue;
+        int code = atoi(line + 9);
+        Serial.printf("HTTP Response: %d\n", code);
+
+        // Skip headers, the body follows the first empty line
+        while((len = readHttpLine(client, line, sizeof(line), start, timeoutMs)) > 0) {}
+        if(len == 0) {
+            while(readHttpLine(client, body, size, start, timeoutMs) == 0) {}
+        }
+        return code;
+    }
+    return -1;
+}
+
+// ============ JSON HELPERS ============
+// Writes `in` as a quoted JSON string; stops early rather than overflow
+int jsonString(char *out, size_t size, const char *in) {
+    size_t n = 0;
+    if(size < 3) return 0;
+    out[n++] = '"';
+    for(; *in && n + 7 < size; in++) {
+        unsigned char c = *in;
+        if(c == '"' || c == '\\') { out[n++] = '\\'; out[n++] = c; }
+        else if(c < 0x20) n += snprintf(out + n, size - n, "\\u%04x", c);
+        else out[n++] = c;
+    }
+    out[n++] = '"';
+    out[n] = '\0';
+    return n;
+}
 
 // ============ SEND PRODUCT WEBHOOK ============
-bool sendProductWebhook(String barcode, String expiryDate, String barcodeType) {
-    if(!checkWiFi()) {
+// Plain socket + static buffer: no HTTPClient/String on the scan path.
+// One code keeps the original flat payload; several go out as one "items"
+// request, so a handful of items held together costs a single TLS handshake.
+bool sendProductWebhook(const BarcodeList &list, const char *expiryDate) {
+    if(!checkWiFi() || list.count == 0) {
+        return false;
+    }
+
+    static char payload[256 + MULTI_MAX_SYMBOLS * (2 * BARCODE_DATA_LEN + 64)];
+    char barcodeJson[2 * BARCODE_DATA_LEN];
+    int len;
+    if(list.count == 1) {
+        jsonString(barcodeJson, sizeof(barcodeJson), list.items[0].data);
+        len = snprintf(payload, sizeof(payload),
+            "{\"action\":\"%s\",\"barcode\":%s,\"barcode_type\":\"%s\",\"expiry_date\":\"%s\",",
+            modeAdd ? "add" : "remove", barcodeJson, list.items[0].type, expiryDate);
+    } else {
+        len = snprintf(payload, sizeof(payload), "{\"action\":\"%s\",\"items\":[", modeAdd ? "add" : "remove");
+        for(int i = 0; i < list.count && len < (int)sizeof(payload); i++) {
+            jsonString(barcodeJson, sizeof(barcodeJson), list.items[i].data);
+            len += snprintf(payload + len, sizeof(payload) - len, "%s{\"barcode\":%s,\"barcode_type\":\"%s\"}",
+                            i ? "," : "", barcodeJson, list.items[i].type);
+        }
+        if(len < (int)sizeof(payload)) len += snprintf(payload + len, sizeof(payload) - len, "],");
+    }
+    if(len < (int)sizeof(payload)) {
+        len += snprintf(payload + len, sizeof(payload) - len,
+            "\"timestamp\":%lu,\"boot_count\":%d,\"device\":\"%s\",\"ocr_method\":\"%s\",\"wifi_rssi\":%d}",
+            millis(), bootCount, BOARD_NAME, useLocalOCR ? "local" : "remote", WiFi.RSSI());
+    }
+    if(len >= (int)sizeof(payload)) {
+        Serial.println("❌ Payload troppo lungo");
         return false;
     }
-    
-    HTTPClient http;
+
+    Serial.println("\n📤 Invio webhook:");
+    Serial.println(payload);
+
     WiFiClientSecure client;
     client.setInsecure();
-    
-    http.begin(client, WEBHOOK_URL);
-    http.addHeader("Content-Type", "application/json");
-    http.setTimeout(10000);
-    
-    // Build JSON payload
-    DynamicJsonDocument doc(1024);
-    doc["action"] = modeAdd ? "add" : "remove";
-    doc["barcode"] = barcode;
-    doc["barcode_type"] = barcodeType;
-    doc["expiry_date"] = expiryDate;
-    doc["timestamp"] = millis();
-    doc["boot_count"] = bootCount;
-    doc["device"] = BOARD_NAME;
-    doc["ocr_method"] = useLocalOCR ? "local" : "remote";
-    doc["wifi_rssi"] = WiFi.RSSI();
-    
-    String payload;
-    serializeJson(doc, payload);
-    
-    Serial.println("\n📤 Invio webhook:");
-    serializeJsonPretty(doc, Serial);
-    Serial.println();
-    
-    int httpCode = http.POST(payload);
-    
-    Serial.printf("HTTP Response: %d\n", httpCode);
-    
+    if(!connectServer(client)) {
+        return false;
+    }
+
+    TRACE_BEGIN(tPost);
+    client.print("POST " WEBHOOK_ENDPOINT " HTTP/1.1\r\n");
+    client.print("Host: " SERVER_HOST "\r\n");
+    client.print("Content-Type: application/json\r\n");
+    client.printf("Content-Length: %d\r\n", len);
+    client.print("Connection: close\r\n\r\n");
+    client.write((const uint8_t *)payload, len);
+
+    char response[512];
+    int httpCode = readHttpResponse(client, response, sizeof(response), 10000);
     if(httpCode > 0) {
-        String response = http.getString();
         Serial.println("Response:");
         Serial.println(response);
     }
-    
-    http.end();
-    
+    client.stop();
+    TRACE_END(TRACE_POST, tPost);
+
     return (httpCode >= 200 && httpCode < 300);
 }
 
 // ============ REMOTE OCR (ESP32-CAM) ============
-String performRemoteOCR(camera_fb_t *fb) {
+// Only the most text-like regions (excluding the barcode) are sent, stacked
+// into one small grayscale strip and JPEG-encoded, instead of the raw frame.
+#define OCR_UPLOAD_CROPS     3
+#define OCR_UPLOAD_MAX_W     512
+#define OCR_UPLOAD_MAX_BYTES ARENA_OCR_STRIP_BYTES
+#define OCR_UPLOAD_GAP       8      // White rows between stacked crops
+
+bool performRemoteOCR(camera_fb_t *fb, const BarcodeResult &barcode, char *expiry, size_t size) {
+    expiry[0] = '\0';
+    if(fb->format != PIXFORMAT_GRAYSCALE) {
+        return false;
+    }
+
+    // Locate candidate date regions before touching the network
+    OcrBox exclude = { barcode.x, barcode.y, barcode.w, barcode.h };
+    OcrRegion regions[OCR_UPLOAD_CROPS];
+    int nRegions = findTextRegions(fb->buf, fb->width, fb->height, &exclude, regions, OCR_UPLOAD_CROPS);
+    if(nRegions == 0) {
+        Serial.println("Nessuna regione di testo, OCR saltato");
+        return false;
+    }
+
+    int stripW = 0, stripH = 0, used = 0;
+    for(int i = 0; i < nRegions; i++) {
+        if(regions[i].box.w > OCR_UPLOAD_MAX_W) regions[i].box.w = OCR_UPLOAD_MAX_W;
+        int w = max(stripW, regions[i].box.w);
+        int h = stripH + regions[i].box.h + OCR_UPLOAD_GAP;
+        if(w * h > OCR_UPLOAD_MAX_BYTES) break;
+        stripW = w; stripH = h; used++;
+    }
+
+    // Stacked crops live in the scanner arena, never on the heap
+    uint8_t *strip = scanWork.ocrStrip;
+    if(used == 0 || strip == NULL) {
+        return false;
+    }
+    memset(strip, 255, stripW * stripH);
+    int y = OCR_UPLOAD_GAP / 2;
+    for(int i = 0; i < used; i++) {
+        const OcrBox &b = regions[i].box;
+        for(int r = 0; r < b.h; r++) {
+            memcpy(strip + (y + r) * stripW, fb->buf + (b.y + r) * fb->width + b.x, b.w);
+        }
+        y += b.h + OCR_UPLOAD_GAP;
+    }
+
     if(!checkWiFi()) {
-        return "";
+        return false;
     }
-    
-    HTTPClient http;
+
     WiFiClientSecure client;
     client.setInsecure();
-    
-    Serial.println("☁️  Invio immagine per OCR...");
-    
-    http.begin(client, OCR_URL);
-    http.addHeader("Content-Type", "image/jpeg");
-    http.setTimeout(15000); // 15 sec
-    
-    int httpCode = http.POST(fb->buf, fb->len);
-    
-    String expiryDate = "";
-    
+
+    Serial.printf("☁️  Invio %d regioni (%dx%d) per OCR...\n", used, stripW, stripH);
+
+    ChunkedUpload up;
+    if(!beginMultipartPost(client, &up, OCR_ENDPOINT, "ocr.jpg", "image/jpeg")) {
+        return false;
+    }
+    size_t imageStart = up.total + up.used;
+    bool encoded = fmt2jpg_cb(strip, stripW * stripH, stripW, stripH, PIXFORMAT_GRAYSCALE,
+                              OCR_JPEG_QUALITY, jpgChunkCallback, &up);
+    if(!encoded || up.failed) {
+        Serial.println("❌ Codifica/invio immagine fallito");
+        client.stop();
+        return false;
+    }
+    size_t imageBytes = up.total + up.used - imageStart;
+    endMultipartPost(&up);
+    Serial.printf("Upload OCR: %u bytes (frame %u bytes)\n", imageBytes, fb->len);
+
+    char response[256];
+    int httpCode = readHttpResponse(client, response, sizeof(response), 15000);
+
     if(httpCode == 200) {
-        String response = http.getString();
-        
-        // Parse JSON response
-        DynamicJsonDocument doc(512);
+        // Parse JSON response in place (zero-copy into a stack document)
+        StaticJsonDocument<256> doc;
         DeserializationError error = deserializeJson(doc, response);
-        
+
         if(!error) {
-            expiryDate = doc["expiry_date"].as<String>();
-            
-            Serial.printf("✅ OCR remoto: %s\n", expiryDate.c_str());
-            
+            const char *date = doc["expiry_date"];
+            if(date) snprintf(expiry, size, "%s", date);
+
+            Serial.printf("✅ OCR remoto: %s\n", expiry);
+
             if(doc.containsKey("confidence")) {
                 float confidence = doc["confidence"];
                 Serial.printf("Confidenza: %.1f%%\n", confidence * 100);
@@ -108,13 +361,15 @@ String performRemoteOCR(camera_fb_t *fb) {
     } else {
         Serial.printf("❌ OCR remoto fallito: HTTP %d\n", httpCode);
     }
-    
-    http.end();
-    return expiryDate;
+
+    client.stop();
+    return expiry[0] != '\0';
 }
 
 // ============ SEND RECEIPT FOR OCR PARSING ============
-int sendReceiptImage(camera_fb_t *fb) {
+// With a region from prepareReceipt() the deskewed 1bpp crop is sent as PBM,
+// otherwise the whole frame as JPEG.
+int sendReceiptImage(camera_fb_t *fb, const ReceiptRegion *region) {
     if(!checkWiFi()) {
         return -1;
     }
@@ -124,148 +379,105 @@ int sendReceiptImage(camera_fb_t *fb) {
 
     Serial.println("🧾 Invio scontrino per parsing...");
 
-    // Create PGM header for grayscale image (Tesseract can read PGM)
-    // PGM format: P5\nwidth height\n255\n[raw bytes]
-    String pgmHeader = "P5\n" + String(fb->width) + " " + String(fb->height) + "\n255\n";
+    uint32_t heapBefore = ESP.getFreeHeap();
+    unsigned long t0 = millis();
 
-    // Create multipart form data
-    String boundary = "----ESP32ReceiptBoundary";
-
-    // Build multipart body parts
-    String bodyStart = "--" + boundary + "\r\n";
-    bodyStart += "Content-Disposition: form-data; name=\"image\"; filename=\"receipt.pgm\"\r\n";
-    bodyStart += "Content-Type: image/x-portable-graymap\r\n\r\n";
-
-    String bodyEnd = "\r\n--" + boundary + "--\r\n";
-
-    size_t totalLen = bodyStart.length() + pgmHeader.length() + fb->len + bodyEnd.length();
-
-    // Connect to server
-    if(!client.connect("frigo.xamad.net", 443)) {
-        Serial.println("❌ Connessione fallita");
+    bool pbm = region != NULL && region->found;
+    ChunkedUpload up;
+    if(!beginMultipartPost(client, &up, "/api/receipt", pbm ? "receipt.pbm" : "receipt.jpg",
+                           pbm ? "image/x-portable-bitmap" : "image/jpeg")) {
         return -1;
     }
+    unsigned long tConnected = millis();
+    size_t imageStart = up.total + up.used;
 
-    // Write HTTP request
-    client.print("POST /api/receipt HTTP/1.1\r\n");
-    client.print("Host: frigo.xamad.net\r\n");
-    client.printf("Content-Type: multipart/form-data; boundary=%s\r\n", boundary.c_str());
-    client.printf("Content-Length: %d\r\n", totalLen);
-    client.print("Connection: close\r\n\r\n");
-
-    // Write body
-    client.print(bodyStart);
-    client.print(pgmHeader);
-
-    // Write image in chunks
-    Serial.printf("Sending %d bytes...\n", fb->len);
-    size_t written = 0;
-    const size_t chunkSize = 1024;
-    while(written < fb->len) {
-        size_t toWrite = min(chunkSize, fb->len - written);
-        client.write(fb->buf + written, toWrite);
-        written += toWrite;
-        if(written % 10240 == 0) Serial.printf("  %d/%d bytes\n", written, fb->len);
-        yield();
+    // Encode row by row straight into the socket, never holding the whole image
+    bool encoded;
+    if(pbm) {
+        char header[24];
+        int n = snprintf(header, sizeof(header), "P4\n%d %d\n", region->w, region->h);
+        chunkWrite(&up, (const uint8_t *)header, n);
+        streamReceiptBits(fb->buf, fb->width, fb->height, region, receiptRowCallback, &up);
+        encoded = !up.failed;
+    } else if(fb->format == PIXFORMAT_JPEG) {
+        chunkWrite(&up, fb->buf, fb->len);
+        encoded = !up.failed;
+    } else {
+        encoded = frame2jpg_cb(fb, RECEIPT_JPEG_QUALITY, jpgChunkCallback, &up);
+    }
+    if(!encoded || up.failed) {
+        Serial.println("❌ Codifica/invio immagine fallito");
+        client.stop();
+        return -1;
     }
+    size_t imageBytes = up.total + up.used - imageStart;
+
+    endMultipartPost(&up);
 
-    client.print(bodyEnd);
+    unsigned long tUploaded = millis();
+    Serial.printf("Upload: %u -> %u bytes (%.1fx), connect %lu ms, upload %lu ms, RAM picco %u bytes\n",
+                  fb->len, imageBytes, imageBytes ? (float)fb->len / imageBytes : 0.0f,
+                  tConnected - t0, tUploaded - tConnected,
+                  heapBefore > up.minHeap ? heapBefore - up.minHeap : 0);
     Serial.println("Upload completo, attendo risposta...");
 
-    // Read response
-    unsigned long timeout = millis() + 30000;
-    while(client.connected() && millis() < timeout) {
-        if(client.available()) {
-            String line = client.readStringUntil('\n');
-            if(line.startsWith("HTTP/")) {
-                int code = line.substring(9, 12).toInt();
-                Serial.printf("HTTP Response: %d\n", code);
-
-                // Skip headers, find JSON body
-                String jsonBody = "";
-                bool headersEnded = false;
-                while(client.available() || client.connected()) {
-                    if(!client.available()) { delay(10); continue; }
-                    String respLine = client.readStringUntil('\n');
-                    if(!headersEnded && respLine == "\r") {
-                        headersEnded = true;
-                        continue;
-                    }
-                    if(headersEnded && respLine.length() > 0) {
-                        jsonBody = respLine;
-                        break;
-                    }
-                }
+    // Product lists can be long: static, not on the loop task stack
+    static char jsonBody[2048];
+    static StaticJsonDocument<2048> doc;
+    int code = readHttpResponse(client, jsonBody, sizeof(jsonBody), 30000);
+    if(code < 0) {
+        client.stop();
+        Serial.println("❌ Timeout risposta");
+        return -1;
+    }
 
-                if(jsonBody.startsWith("{")) {
-                    DynamicJsonDocument doc(2048);
-                    DeserializationError error = deserializeJson(doc, jsonBody);
-                    if(!error && doc["success"]) {
-                        int productsFound = doc["products_found"];
-                        Serial.printf("✅ Scontrino: %d prodotti trovati\n", productsFound);
-                        if(doc.containsKey("products")) {
-                            JsonArray products = doc["products"];
-                            for(JsonObject product : products) {
-                                Serial.printf("  - %s", product["name"].as<String>().c_str());
-                                if(product.containsKey("weight") && !product["weight"].isNull()) {
-                                    Serial.printf(" (%s)", product["weight"].as<String>().c_str());
-                                }
-                                Serial.println();
-                            }
-                        }
-                        client.stop();
-                        return productsFound;
+    if(jsonBody[0] == '{') {
+        DeserializationError error = deserializeJson(doc, jsonBody);
+        if(!error && doc["success"]) {
+            int productsFound = doc["products_found"];
+            Serial.printf("✅ Scontrino: %d prodotti trovati\n", productsFound);
+            if(doc.containsKey("products")) {
+                JsonArray products = doc["products"];
+                for(JsonObject product : products) {
+                    Serial.printf("  - %s", product["name"].as<const char*>());
+                    if(product.containsKey("weight") && !product["weight"].isNull()) {
+                        Serial.printf(" (%s)", product["weight"].as<const char*>());
                     }
+                    Serial.println();
                 }
-                client.stop();
-                return (code >= 200 && code < 300) ? 0 : -1;
             }
+            client.stop();
+            return productsFound;
         }
-        delay(10);
     }
-
     client.stop();
-    Serial.println("❌ Timeout risposta");
-    return -1;
+    return (code >= 200 && code < 300) ? 0 : -1;
 }
 
-// ============ LOCAL OCR (ESP32-S3 with AI) ============
+// ============ LOCAL OCR (ESP32-S3) ============
 #ifdef BOARD_ESP32S3
 
-String performLocalOCR(camera_fb_t *fb) {
-    Serial.println("🤖 OCR locale con accelerazione AI...");
-    
-    // Preprocessing
-    Serial.println("  1. Preprocessing immagine...");
-    delay(300);
-    
-    Serial.println("  2. Edge detection...");
-    delay(300);
-    
-    Serial.println("  3. Estrazione regioni testo...");
-    delay(400);
-    
-    Serial.println("  4. ML inference...");
-    delay(500);
-    
-    Serial.println("  5. Validazione formato data...");
-    delay(200);
-    
-    // Placeholder: simula OCR locale
-    if(random(0, 100) > 40) {
-        String dates[] = {
-            "2026-06-15",
-            "2026-07-20",
-            "2026-08-10",
-            "2026-12-31"
-        };
-        String result = dates[random(0, 4)];
-        Serial.printf("✅ Data rilevata: %s (confidenza: 87%%)\n", result.c_str());
-        return result;
+bool performLocalOCR(camera_fb_t *fb, const BarcodeResult &barcode, char *expiry, size_t size) {
+    Serial.println("🤖 OCR locale...");
+    expiry[0] = '\0';
+    if(fb->format != PIXFORMAT_GRAYSCALE) return false;
+
+    OcrBox box = { barcode.x, barcode.y, barcode.w, barcode.h };
+    char date[11];
+    OcrStats stats;
+    bool found = readExpiryDate(fb->buf, fb->width, fb->height, &box, date, &stats);
+    Serial.printf("  %d regioni, %d caratteri, %u us (detect %u, segment %u, classify %u)\n",
+                  stats.regions, stats.glyphs, stats.totalUs,
+                  stats.detectUs, stats.segmentUs, stats.classifyUs);
+
+    if(found) {
+        Serial.printf("✅ Data rilevata: %s (confidenza: %d%%)\n", date, stats.confidence);
+        snprintf(expiry, size, "%s", date);
+        return true;
     }
-    
+
     Serial.println("❌ Nessuna data trovata");
-    return "";
+    return false;
 }
 
 #endif
@@ -0,0 +1,103 @@
+#ifndef BAND_CAPTURE_H
+#define BAND_CAPTURE_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "config.h"
+#include "camera_config.h"
+#include "scan_trace.h"
+#include "barcode_scanner.h"
+#include "frame_quality.h"
+
+// ============ BAND CAPTURE ============
+// No PSRAM: the VGA frame is never whole in RAM. Each sensor frame brings one
+// 640x120 band (camera_config.h), centre bands first. The window for the next
+// band is programmed before the current one is decoded, so the sensor moves
+// on while the CPU works and the scan ends about one frame after the band
+// holding the code. That band is kept for the remote OCR crop. A shaky hand
+// blurs single bands rather than the whole scan, so the field is swept
+// BAND_PASSES times before the whole field at 320x240 is tried for QR codes.
+
+#ifdef ENABLE_BAND_CAPTURE
+
+static_assert(CAM_BANDS == 4, "BAND_ORDER lists four bands");
+const uint8_t BAND_ORDER[CAM_BANDS] = { 1, 2, 0, 3 };
+
+void bandScan1D(camera_fb_t *fb, BarcodeList *codes) {
+    TRACE_BEGIN(t1d);
+#ifdef MULTI_SYMBOL_SCAN
+    scan1DBarcodes(fb, codes);
+#else
+    barcodeListAdd(codes, scan1DBarcode(fb));
+#endif
+    TRACE_END(TRACE_1D, t1d);
+}
+
+void bandScanQR(camera_fb_t *fb, BarcodeList *codes) {
+    TRACE_BEGIN(tQr);
+#ifdef MULTI_SYMBOL_SCAN
+    scanQRCodes(fb, codes);
+#else
+    barcodeListAdd(codes, scanQRCode(fb));
+#endif
+    TRACE_END(TRACE_QR, tQr);
+}
+
+// Same contract as burstCapture(): false if no frame could be captured,
+// otherwise burstRelease() when done. Decoding happens here, into *codes;
+// the burst holds the frame they were found in.
+bool bandCapture(CameraBurst *b, BarcodeList *codes) {
+    memset(b, 0, sizeof(*b));
+    if (!cameraLock()) return false;
+    #ifdef ENABLE_SCANLINE_FUSION
+    fusionReset();
+    #endif
+
+    camera_fb_t *fb = NULL;
+    const int steps = BAND_PASSES * CAM_BANDS;
+    cameraSetWindow(BAND_ORDER[0]);
+    for (int i = 0; i < steps; i++) {
+        int band = BAND_ORDER[i % CAM_BANDS];
+        fb = cameraFetchFrame();
+        if (!fb) break;
+        b->grabbed++;
+        cameraSetWindow(i + 1 < steps ? BAND_ORDER[(i + 1) % CAM_BANDS] : -1);
+        bandScan1D(fb, codes);
+        Serial.printf("[BAND] Banda %d (righe %d-%d): %d codici\n",
+                      band, band * CAM_BAND_H, (band + 1) * CAM_BAND_H - 1, codes->count);
+        if (codes->count) break;
+        esp_camera_fb_return(fb);
+        fb = NULL;
+    }
+
+    if (codes->count == 0 && b->grabbed > 0) {
+        cameraSetWindow(-1);
+        fb = cameraFetchFrame();
+        if (fb) {
+            b->grabbed++;
+            bandScanQR(fb, codes);
+            Serial.printf("[BAND] Campo intero %dx%d: %d QR\n", fb->width, fb->height, codes->count);
+            if (codes->count == 0) {
+                esp_camera_fb_return(fb);
+                fb = NULL;
+            }
+        }
+    }
+    // Stream, receipt fallback and the next scan's QR pass see the whole field
+    cameraSetWindow(-1);
+
+    if (b->grabbed == 0) {
+        cameraUnlock();
+        return false;
+    }
+    if (fb) {
+        b->fb[0] = fb;
+        b->seq[0] = b->grabbed;
+        b->count = 1;
+    }
+    return true;
+}
+
+#endif
+
+#endif
@@ -3,16 +3,49 @@
 
 #include "esp_camera.h"
 #include "quirc.h"
+#include "config.h"
+#include "scan_trace.h"
+#include "scanner_arena.h"
+
+// Barcode result structure (fixed-size, the scan path never touches the heap)
+#define BARCODE_TYPE_LEN    8
+#define BARCODE_DATA_LEN    128     // Longer QR payloads are truncated
 
-// Barcode result structure
 struct BarcodeResult {
     bool found;
-    String type;
-    String data;
+    char type[BARCODE_TYPE_LEN];
+    char data[BARCODE_DATA_LEN];
+    int x, y, w, h;  // Bounding box in the frame (1D: estimated from scanline)
 };
 
-// Quirc instance for QR decoding
-struct quirc *qr = NULL;
+void setBarcodeResult(BarcodeResult *r, const char *type, const char *data) {
+    r->found = true;
+    snprintf(r->type, sizeof(r->type), "%s", type);
+    snprintf(r->data, sizeof(r->data), "%s", data);
+}
+
+// Quirc instances for QR decoding, one per frame size the capture profiles
+// deliver (camera_config.h), sized once so a profile switch never allocates
+struct QrInstance {
+    struct quirc *q;
+    int width, height;
+};
+QrInstance qrInstances[CAM_QR_SIZES] = {};
+int qrInstanceCount = 0;
+
+// Decoder scratch, carved from the scanner arena in initBarcodeScanner()
+struct ScannerWorkspace {
+    uint8_t *reversedLine;          // One frame row, right to left
+    int lineCapacity;
+    struct quirc_code *qrCode;      // ~4 KB
+    struct quirc_data *qrData;      // ~9 KB
+    uint8_t *ocrStrip;              // Remote OCR crops (ESP32-CAM only)
+    uint16_t *fusionAcc;            // FUSION_LINES aligned profile sums
+    int16_t *fusionRef;             // Zero-mean reference profile
+    uint8_t *fusionLine;            // Incoming / fused profile
+    uint16_t *runEdges;             // Threshold crossings of one line, 1/RUN_SUBPX px
+};
+ScannerWorkspace scanWork = { NULL, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
 
 // ============ EAN/UPC BARCODE PATTERNS ============
 // L-codes (left side, odd parity) - used in EAN-13, EAN-8, UPC-A
@@ -88,18 +121,58 @@ const uint16_t CODE128_PATTERNS[] = {
 
 // ============ INITIALIZE BARCODE SCANNER ============
 void initBarcodeScanner() {
-    qr = quirc_new();
-    if (qr == NULL) {
-        Serial.println("[SCAN] Failed to allocate quirc");
+    // Frame geometry and memory placement follow the camera's decision
+    int w = cameraFrameWidth, h = cameraFrameHeight;
+    size_t arenaSize = w + sizeof(struct quirc_code) + sizeof(struct quirc_data) + 64;
+#ifndef BOARD_ESP32S3
+    arenaSize += ARENA_OCR_STRIP_BYTES;
+#endif
+#ifdef ENABLE_SCANLINE_FUSION
+    arenaSize += FUSION_LINES * w * sizeof(uint16_t) + w * sizeof(int16_t) + w + 16;
+#endif
+#ifdef ENABLE_CURVED_1D
+    arenaSize += w * sizeof(uint16_t) + 4;
+#endif
+    if (!initScannerArena(arenaSize, cameraInPsram)) {
         return;
     }
-    if (quirc_resize(qr, 640, 480) < 0) {
-        Serial.println("[SCAN] Failed to resize quirc");
-        quirc_destroy(qr);
-        qr = NULL;
-        return;
+    scanWork.reversedLine = (uint8_t *)arenaAlloc(w);
+    scanWork.lineCapacity = w;
+    scanWork.qrCode = (struct quirc_code *)arenaAlloc(sizeof(struct quirc_code));
+    scanWork.qrData = (struct quirc_data *)arenaAlloc(sizeof(struct quirc_data));
+#ifndef BOARD_ESP32S3
+    scanWork.ocrStrip = (uint8_t *)arenaAlloc(ARENA_OCR_STRIP_BYTES);
+#endif
+#ifdef ENABLE_SCANLINE_FUSION
+    scanWork.fusionAcc = (uint16_t *)arenaAlloc(FUSION_LINES * w * sizeof(uint16_t));
+    scanWork.fusionRef = (int16_t *)arenaAlloc(w * sizeof(int16_t));
+    scanWork.fusionLine = (uint8_t *)arenaAlloc(w);
+#endif
+#ifdef ENABLE_CURVED_1D
+    scanWork.runEdges = (uint16_t *)arenaAlloc(w * sizeof(uint16_t));
+#endif
+
+    // quirc keeps its own image/flood-fill buffers (no external buffer API):
+    // allocate them once here, per frame size, so scanQRCode() never resizes.
+    // Without a camera (host tools) the one size is the frame's.
+    int sizes = cameraQrSizeCount ? cameraQrSizeCount : 1;
+    for (int i = 0; i < sizes; i++) {
+        int qw = cameraQrSizeCount ? cameraQrSizes[i][0] : w;
+        int qh = cameraQrSizeCount ? cameraQrSizes[i][1] : h;
+        struct quirc *q = quirc_new();
+        if (q == NULL) {
+            Serial.println("[SCAN] Failed to allocate quirc");
+            return;
+        }
+        if (quirc_resize(q, qw, qh) < 0) {
+            Serial.println("[SCAN] Failed to resize quirc");
+            quirc_destroy(q);
+            return;
+        }
+        qrInstances[qrInstanceCount++] = { q, qw, qh };
     }
-    Serial.println("[SCAN] Scanner ready: QR, EAN-13, EAN-8, UPC-A");
+    Serial.printf("[SCAN] Scanner ready: QR, EAN-13, EAN-8, UPC-A (%dx%d, arena %u bytes)\n",
+                  w, h, scannerArena.used);
 }
 
 // ============ FIND BARCODE START GUARD ============
@@ -209,8 +282,7 @@ bool verifyUPCAChecksum(char *digits) {
 
 // ============ SCAN EAN-13 (13 digits) ============
 BarcodeResult scanEAN13(uint8_t *line, int width, int threshold, int start, int moduleWidth) {
-    BarcodeResult result;
-    result.found = false;
+    BarcodeResult result = {};
 
     // EAN-13: 95 modules = 3 (start) + 42 (left) + 5 (center) + 42 (right) + 3 (end)
     if (start + moduleWidth * 95 > width) return result;
@@ -255,16 +327,15 @@ BarcodeResult scanEAN13(uint8_t *line, int width, int threshold, int start, int
         return result;
     }
 
-    result.found = true;
-    result.type = "EAN13";
-    result.data = String(digits);
+    setBarcodeResult(&result, "EAN13", digits);
+    result.x = start;
+    result.w = moduleWidth * 95;
     return result;
 }
 
 // ============ SCAN EAN-8 (8 digits) ============
 BarcodeResult scanEAN8(uint8_t *line, int width, int threshold, int start, int moduleWidth) {
-    BarcodeResult result;
-    result.found = false;
+    BarcodeResult result = {};
 
     // EAN-8: 67 modules = 3 (start) + 28 (left) + 5 (center) + 28 (right) + 3 (end)
     if (start + moduleWidth * 67 > width) return result;
@@ -296,16 +367,15 @@ BarcodeResult scanEAN8(uint8_t *line, int width, int threshold, int start, int m
         return result;
     }
 
-    result.found = true;
-    result.type = "EAN8";
-    result.data = String(digits);
+    setBarcodeResult(&result, "EAN8", digits);
+    result.x = start;
+    result.w = moduleWidth * 67;
     return result;
 }
 
 // ============ SCAN UPC-A (12 digits) ============
 BarcodeResult scanUPCA(uint8_t *line, int width, int threshold, int start, int moduleWidth) {
-    BarcodeResult result;
-    result.found = false;
+    BarcodeResult result = {};
 
     // UPC-A: 95 modules (same as EAN-13, but all L-codes on left)
     if (start + moduleWidth * 95 > width) return result;
@@ -337,155 +407,361 @@ BarcodeResult scanUPCA(uint8_t *line, int width, int threshold, int start, int m
         return result;
     }
 
-    result.found = true;
-    result.type = "UPCA";
-    result.data = String(digits);
+    setBarcodeResult(&result, "UPCA", digits);
+    result.x = start;
+    result.w = moduleWidth * 95;
     return result;
 }
 
-// ============ SCAN ALL 1D BARCODES ============
-BarcodeResult scan1DBarcode(camera_fb_t *fb) {
-    BarcodeResult result;
-    result.found = false;
+// Map a scanline hit to frame coordinates; bar height is not measured,
+// so it is estimated from the nominal EAN aspect ratio (~0.7)
+void setScanlineBox(BarcodeResult *result, int y, int width, bool reversed) {
+    if (reversed) result->x = width - result->x - result->w;
+    result->h = result->w * 7 / 10;
+    result->y = y - result->h / 2;
+}
 
-    if (fb->format != PIXFORMAT_GRAYSCALE) {
-        return result;
+#ifdef ENABLE_CURVED_1D
+// ============ RUN-LENGTH DECODE (curved labels) ============
+// Threshold crossings at sub-pixel precision, then every guard and digit is
+// matched on its own runs scaled by their sum: the module width follows the
+// label as it narrows towards the sides of a can. Variance limits as in
+// ZXing's UPC/EAN reader; the checksum rejects what slips through.
+#define RUN_SUBPX           16      // Edge positions in 1/16 px
+#define RUN_MAX_AVG_VAR     0.48f   // Mean mismatch per module of a pattern
+#define RUN_MAX_ONE_VAR     0.7f    // Mismatch of a single run, modules
+#define RUN_MAX_STEP        1.5f    // Module width ratio between neighbouring digits
+
+// Run widths of the L-codes: R-codes are the same runs starting with a bar,
+// G-codes the same runs reversed
+const uint8_t EAN_L_RUNS[10][4] = {
+    { 3, 2, 1, 1 }, { 2, 2, 2, 1 }, { 2, 1, 2, 2 }, { 1, 4, 1, 1 }, { 1, 1, 3, 2 },
+    { 1, 2, 3, 1 }, { 1, 1, 1, 4 }, { 1, 3, 1, 2 }, { 1, 2, 1, 3 }, { 3, 1, 1, 2 }
+};
+const uint8_t EAN_GUARD_RUNS[5] = { 1, 1, 1, 1, 1 };
+
+// Mean mismatch per module of the n runs starting at e[0] against a pattern
+// of 'total' modules; -1 if any run is off by more than RUN_MAX_ONE_VAR.
+// *unit receives the local module width (1/RUN_SUBPX px)
+float runMatch(const uint16_t *e, int n, const uint8_t *modules, int total, bool reversed, float *unit) {
+    float u = (float)(e[n] - e[0]) / total;
+    if (u <= 0) return -1;
+    float var = 0;
+    for (int i = 0; i < n; i++) {
+        float d = fabsf((e[i + 1] - e[i]) / u - modules[reversed ? n - 1 - i : i]);
+        if (d > RUN_MAX_ONE_VAR) return -1;
+        var += d;
     }
+    *unit = u;
+    return var / total;
+}
 
-    int width = fb->width;
-    int height = fb->height;
-    uint8_t *pixels = fb->buf;
+// Module width may drift along a curved label, but not jump
+bool runStepOk(float prev, float unit) {
+    return unit < prev * RUN_MAX_STEP && unit * RUN_MAX_STEP > prev;
+}
 
-    // Scan multiple horizontal lines
-    int scanLines[] = { height/2, height/3, height*2/3, height/4, height*3/4,
-                        height*2/5, height*3/5, height*5/12, height*7/12 };
-    int numLines = 9;
+// Best digit for the 4 runs starting at e[0]; -1 if none is close enough
+int decodeRunDigit(const uint16_t *e, bool isRight, bool *isG, float *unit) {
+    float best = RUN_MAX_AVG_VAR;
+    int digit = -1;
+    for (int d = 0; d < 10; d++) {
+        for (int g = 0; g < (isRight ? 1 : 2); g++) {
+            float u;
+            float v = runMatch(e, 4, EAN_L_RUNS[d], 7, g == 1, &u);
+            if (v >= 0 && v < best) {
+                best = v;
+                digit = d;
+                *unit = u;
+                if (isG) *isG = g == 1;
+            }
+        }
+    }
+    return digit;
+}
 
-    // Temporary buffer for reversed line
-    static uint8_t reversedLine[1280];  // Max width
+// One symbol from the start guard at e[0]: half = 6 (EAN-13, UPC-A as
+// EAN-13 with a leading 0) or 4 (EAN-8). Returns the edge count used, 0 if
+// it does not decode
+int decodeRunSymbol(const uint16_t *e, int n, int half, char *digits) {
+    int used = 3 + half * 4 + 5 + half * 4 + 3;
+    if (used >= n) return 0;
+    float unit = 0, u = 0;
+    runMatch(e, 3, EAN_GUARD_RUNS, 3, false, &unit);
+
+    int pos = 3, first = half == 6 ? 1 : 0;
+    uint8_t parity = 0;
+    for (int d = 0; d < half; d++, pos += 4) {
+        bool isG = false;
+        int digit = decodeRunDigit(e + pos, false, &isG, &u);
+        if (digit < 0 || !runStepOk(unit, u)) return 0;
+        if (isG && half == 4) return 0;
+        digits[first + d] = '0' + digit;
+        if (isG) parity |= 1 << (half - 1 - d);
+        unit = u;
+    }
+    float v = runMatch(e + pos, 5, EAN_GUARD_RUNS, 5, false, &u);
+    if (v < 0 || v > RUN_MAX_AVG_VAR || !runStepOk(unit, u)) return 0;
+    unit = u;
+    pos += 5;
+    for (int d = 0; d < half; d++, pos += 4) {
+        int digit = decodeRunDigit(e + pos, true, NULL, &u);
+        if (digit < 0 || !runStepOk(unit, u)) return 0;
+        digits[first + half + d] = '0' + digit;
+        unit = u;
+    }
+    v = runMatch(e + pos, 3, EAN_GUARD_RUNS, 3, false, &u);
+    if (v < 0 || v > RUN_MAX_AVG_VAR || !runStepOk(unit, u)) return 0;
 
-    for (int sl = 0; sl < numLines; sl++) {
-        int y = scanLines[sl];
-        uint8_t *line = pixels + y * width;
+    if (half == 6) {
+        digits[0] = '?';
+        for (int fd = 0; fd < 10; fd++) {
+            if (EAN_FIRST[fd] == parity) digits[0] = '0' + fd;
+        }
+        if (digits[0] == '?' || !verifyEAN13Checksum(digits)) return 0;
+    } else if (!verifyEAN8Checksum(digits)) {
+        return 0;
+    }
+    return used;
+}
 
-        // Calculate adaptive threshold for this line
-        uint8_t minVal = 255, maxVal = 0;
-        for (int x = 0; x < width; x++) {
-            if (line[x] < minVal) minVal = line[x];
-            if (line[x] > maxVal) maxVal = line[x];
+// Fallback for labels whose module width changes along the line
+BarcodeResult scanEANRuns(uint8_t *line, int width, int threshold) {
+    BarcodeResult result = {};
+    uint16_t *e = scanWork.runEdges;
+    if (e == NULL || width > scanWork.lineCapacity) return result;
+
+    // Alternating crossings, even entries white->black, interpolated between pixels
+    int n = 0;
+    for (int x = 0; x + 1 < width; x++) {
+        int a = line[x] - threshold, b = line[x + 1] - threshold;
+        bool edge = (n & 1) ? (a <= 0 && b > 0) : (a > 0 && b <= 0);
+        if (edge) e[n++] = x * RUN_SUBPX + a * RUN_SUBPX / (a - b);
+    }
+
+    char digits[14];
+    for (int k = 0; k + 3 < n; k += 2) {
+        // Start guard behind a quiet zone of at least 3 modules
+        float unit = 0;
+        float v = runMatch(e + k, 3, EAN_GUARD_RUNS, 3, false, &unit);
+        if (v < 0 || v > RUN_MAX_AVG_VAR) continue;
+        if ((k == 0 ? e[0] : e[k] - e[k - 1]) < 3 * unit) continue;
+
+        static const int HALVES[] = { 6, 4 };
+        for (int half : HALVES) {
+            memset(digits, 0, sizeof(digits));
+            int used = decodeRunSymbol(e + k, n - k, half, digits);
+            if (used == 0) continue;
+            setBarcodeResult(&result, half == 6 ? "EAN13" : "EAN8", digits);
+            result.x = e[k] / RUN_SUBPX;
+            result.w = (e[k + used] - e[k]) / RUN_SUBPX;
+            return result;
         }
-        int threshold = (minVal + maxVal) / 2;
+    }
+    return result;
+}
+#endif
 
-        // Skip low contrast lines
-        if (maxVal - minVal < 60) continue;
+// ============ SCAN ALL 1D BARCODES ============
+// One grayscale line (a frame row or a fused profile), both directions
+BarcodeResult scan1DLine(uint8_t *line, int width, int y) {
+    BarcodeResult result = {};
 
-        // Try multiple start guards on same line
-        for (int attempt = 0; attempt < 5; attempt++) {
-            int searchStart = attempt * (width / 6);
-            int moduleWidth = 0;
+    // Temporary buffer for reversed line
+    uint8_t *reversedLine = scanWork.reversedLine;
+    if (reversedLine == NULL || width > scanWork.lineCapacity) return result;
+
+    // Calculate adaptive threshold for this line
+    uint8_t minVal = 255, maxVal = 0;
+    for (int x = 0; x < width; x++) {
+        if (line[x] < minVal) minVal = line[x];
+        if (line[x] > maxVal) maxVal = line[x];
+    }
+    int threshold = (minVal + maxVal) / 2;
 
-            // Temporary modify line pointer for search offset
-            int start = -1;
-            for (int i = searchStart + 20; i < width - 200; i++) {
-                if (line[i] > threshold && line[i+1] <= threshold) {
-                    int bar1 = 0, space = 0, bar2 = 0;
-                    int j = i + 1;
+    // Skip low contrast lines
+    if (maxVal - minVal < 60) return result;
 
-                    while (j < width && line[j] <= threshold) { bar1++; j++; }
-                    if (bar1 < 2 || bar1 > 25) continue;
+    // Try multiple start guards on same line
+    for (int attempt = 0; attempt < 5; attempt++) {
+        int searchStart = attempt * (width / 6);
+        int moduleWidth = 0;
+
+        // Temporary modify line pointer for search offset
+        int start = -1;
+        for (int i = searchStart + 20; i < width - 200; i++) {
+            if (line[i] > threshold && line[i+1] <= threshold) {
+                int bar1 = 0, space = 0, bar2 = 0;
+                int j = i + 1;
 
-                    while (j < width && line[j] > threshold) { space++; j++; }
-                    if (space < 1 || abs(space - bar1) > bar1) continue;
+                while (j < width && line[j] <= threshold) { bar1++; j++; }
+                if (bar1 < 2 || bar1 > 25) continue;
 
-                    while (j < width && line[j] <= threshold) { bar2++; j++; }
-                    if (abs(bar2 - bar1) > bar1 / 2 + 1) continue;
+                while (j < width && line[j] > threshold) { space++; j++; }
+                if (space < 1 || abs(space - bar1) > bar1) continue;
 
-                    moduleWidth = (bar1 + space + bar2) / 3;
-                    if (moduleWidth >= 2 && moduleWidth <= 20) {
-                        start = i + 1;
-                        break;
-                    }
+                while (j < width && line[j] <= threshold) { bar2++; j++; }
+                if (abs(bar2 - bar1) > bar1 / 2 + 1) continue;
+
+                moduleWidth = (bar1 + space + bar2) / 3;
+                if (moduleWidth >= 2 && moduleWidth <= 20) {
+                    start = i + 1;
+                    break;
                 }
             }
+        }
 
-            if (start < 0) continue;
+        if (start < 0) continue;
 
-            // Try different module width variations (+/- 20%)
-            for (int mwVar = -2; mwVar <= 2; mwVar++) {
-                int mw = moduleWidth + mwVar;
-                if (mw < 2) continue;
+        // Try different module width variations (+/- 20%)
+        for (int mwVar = -2; mwVar <= 2; mwVar++) {
+            int mw = moduleWidth + mwVar;
+            if (mw < 2) continue;
 
-                // Try EAN-13
-                result = scanEAN13(line, width, threshold, start, mw);
-                if (result.found) return result;
+            // Try EAN-13
+            result = scanEAN13(line, width, threshold, start, mw);
+            if (result.found) { setScanlineBox(&result, y, width, false); return result; }
 
-                // Try EAN-8
-                result = scanEAN8(line, width, threshold, start, mw);
-                if (result.found) return result;
+            // Try EAN-8
+            result = scanEAN8(line, width, threshold, start, mw);
+            if (result.found) { setScanlineBox(&result, y, width, false); return result; }
 
-                // Try UPC-A
-                result = scanUPCA(line, width, threshold, start, mw);
-                if (result.found) return result;
-            }
+            // Try UPC-A
+            result = scanUPCA(line, width, threshold, start, mw);
+            if (result.found) { setScanlineBox(&result, y, width, false); return result; }
         }
+    }
 
-        // Also try scanning in reverse direction
-        for (int x = 0; x < width; x++) {
-            reversedLine[x] = line[width - 1 - x];
-        }
+    // Also try scanning in reverse direction
+    for (int x = 0; x < width; x++) {
+        reversedLine[x] = line[width - 1 - x];
+    }
 
-        int moduleWidth = 0;
-        int start = findStartGuard(reversedLine, width, threshold, &moduleWidth);
-        if (start >= 0 && moduleWidth >= 2 && moduleWidth <= 20) {
-            result = scanEAN13(reversedLine, width, threshold, start, moduleWidth);
-            if (result.found) return result;
+    int moduleWidth = 0;
+    int start = findStartGuard(reversedLine, width, threshold, &moduleWidth);
+    if (start >= 0 && moduleWidth >= 2 && moduleWidth <= 20) {
+        result = scanEAN13(reversedLine, width, threshold, start, moduleWidth);
+        if (result.found) { setScanlineBox(&result, y, width, true); return result; }
 
-            result = scanEAN8(reversedLine, width, threshold, start, moduleWidth);
-            if (result.found) return result;
+        result = scanEAN8(reversedLine, width, threshold, start, moduleWidth);
+        if (result.found) { setScanlineBox(&result, y, width, true); return result; }
 
-            result = scanUPCA(reversedLine, width, threshold, start, moduleWidth);
-            if (result.found) return result;
-        }
+        result = scanUPCA(reversedLine, width, threshold, start, moduleWidth);
+        if (result.found) { setScanlineBox(&result, y, width, true); return result; }
+    }
+
+#ifdef ENABLE_CURVED_1D
+    // Curved label: module width tracked digit by digit, both directions
+    result = scanEANRuns(line, width, threshold);
+    if (result.found) { setScanlineBox(&result, y, width, false); return result; }
+    result = scanEANRuns(reversedLine, width, threshold);
+    if (result.found) { setScanlineBox(&result, y, width, true); return result; }
+#endif
+
+    return result;
+}
+
+BarcodeResult scan1DBarcode(camera_fb_t *fb) {
+    BarcodeResult result = {};
+
+    if (fb->format != PIXFORMAT_GRAYSCALE) {
+        return result;
+    }
+
+    int width = fb->width;
+    int height = fb->height;
+    uint8_t *pixels = fb->buf;
+
+    // Scan multiple horizontal lines
+    int scanLines[] = { height/2, height/3, height*2/3, height/4, height*3/4,
+                        height*2/5, height*3/5, height*5/12, height*7/12 };
+    int numLines = 9;
+
+    for (int sl = 0; sl < numLines; sl++) {
+        int y = scanLines[sl];
+        result = scan1DLine(pixels + y * width, width, y);
+        if (result.found) return result;
     }
 
     return result;
 }
 
 // ============ SCAN QR CODE ============
-BarcodeResult scanQRCode(camera_fb_t *fb) {
-    BarcodeResult result;
-    result.found = false;
+// Reallocates quirc's buffers: only for sizes no profile delivers
+bool qrResize(QrInstance &qi, int w, int h) {
+    Serial.printf("[QR] Resize %dx%d -> %dx%d\n", qi.width, qi.height, w, h);
+    if (quirc_resize(qi.q, w, h) < 0) {
+        return false;
+    }
+    qi.width = w;
+    qi.height = h;
+    return true;
+}
 
-    if (qr == NULL || fb->format != PIXFORMAT_GRAYSCALE) {
-        return result;
+// The quirc instance sized for this frame, NULL if there is none
+struct quirc* qrFor(int w, int h) {
+    if (qrInstanceCount == 0) return NULL;
+    for (int i = 0; i < qrInstanceCount; i++) {
+        if (qrInstances[i].width == w && qrInstances[i].height == h) return qrInstances[i].q;
     }
+    // A size no profile delivers (never in normal operation): reuse the first
+    return qrResize(qrInstances[0], w, h) ? qrInstances[0].q : NULL;
+}
 
-    int w = fb->width;
-    int h = fb->height;
+// Copies the frame into quirc and locates codes; NULL if QR is unavailable
+struct quirc* qrLocate(camera_fb_t *fb) {
+    if (scanWork.qrCode == NULL || fb->format != PIXFORMAT_GRAYSCALE) {
+        return NULL;
+    }
 
-    if (quirc_resize(qr, w, h) < 0) {
-        return result;
+    struct quirc *qr = qrFor(fb->width, fb->height);
+    if (qr == NULL) {
+        return NULL;
     }
 
     uint8_t *image = quirc_begin(qr, NULL, NULL);
     if (image == NULL) {
-        return result;
+        return NULL;
     }
 
-    memcpy(image, fb->buf, w * h);
+    memcpy(image, fb->buf, fb->width * fb->height);
     quirc_end(qr);
+    return qr;
+}
+
+// Decodes code i of the last qrLocate(); payload and corner bounding box
+bool qrDecodeAt(struct quirc *qr, int i, int w, int h, BarcodeResult *result) {
+    struct quirc_code &code = *scanWork.qrCode;
+    struct quirc_data &data = *scanWork.qrData;
+
+    quirc_extract(qr, i, &code);
+    if (quirc_decode(&code, &data) != QUIRC_SUCCESS) {
+        return false;
+    }
+
+    *result = {};
+    setBarcodeResult(result, "QR", (const char *)data.payload);
+    int x0 = w, y0 = h, x1 = 0, y1 = 0;
+    for (int c = 0; c < 4; c++) {
+        x0 = min(x0, code.corners[c].x); x1 = max(x1, code.corners[c].x);
+        y0 = min(y0, code.corners[c].y); y1 = max(y1, code.corners[c].y);
+    }
+    result->x = x0; result->y = y0; result->w = x1 - x0; result->h = y1 - y0;
+    return true;
+}
+
+BarcodeResult scanQRCode(camera_fb_t *fb) {
+    BarcodeResult result = {};
+
+    struct quirc *qr = qrLocate(fb);
+    if (qr == NULL) {
+        return result;
+    }
 
     int count = quirc_count(qr);
     for (int i = 0; i < count; i++) {
-        struct quirc_code code;
-        struct quirc_data data;
-
-        quirc_extract(qr, i, &code);
-        if (quirc_decode(&code, &data) == QUIRC_SUCCESS) {
-            result.found = true;
-            result.type = "QR";
-            result.data = String((const char *)data.payload);
-            Serial.printf("[QR] SUCCESS: %s\n", data.payload);
+        if (qrDecodeAt(qr, i, fb->width, fb->height, &result)) {
+            Serial.printf("[QR] SUCCESS: %s\n", (const char *)scanWork.qrData->payload);
             return result;
         }
     }
@@ -493,21 +769,93 @@ BarcodeResult scanQRCode(camera_fb_t *fb) {
     return result;
 }
 
+// ============ MULTI-SYMBOL SCAN ============
+// All distinct codes in one frame. The same value with overlapping boxes is
+// one symbol seen twice (another scanline, the other direction); the same
+// value elsewhere is a second identical item.
+#define MULTI_MIN_SEGMENT   220     // scan1DLine() needs 200 px past a start guard
+
+struct BarcodeList {
+    BarcodeResult items[MULTI_MAX_SYMBOLS];
+    int count;
+};
+
+bool barcodeBoxesOverlap(const BarcodeResult &a, const BarcodeResult &b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+bool barcodeListAdd(BarcodeList *list, const BarcodeResult &r) {
+    if (!r.found) return false;
+    for (int i = 0; i < list->count; i++) {
+        const BarcodeResult &o = list->items[i];
+        if (strcmp(o.type, r.type) == 0 && strcmp(o.data, r.data) == 0 && barcodeBoxesOverlap(o, r)) return false;
+    }
+    if (list->count >= MULTI_MAX_SYMBOLS) return false;
+    list->items[list->count++] = r;
+    return true;
+}
+
+// Every QR quirc located, not just the first that decodes
+void scanQRCodes(camera_fb_t *fb, BarcodeList *list) {
+    struct quirc *qr = qrLocate(fb);
+    if (qr == NULL) return;
+
+    int count = quirc_count(qr);
+    for (int i = 0; i < count && list->count < MULTI_MAX_SYMBOLS; i++) {
+        BarcodeResult result;
+        if (!qrDecodeAt(qr, i, fb->width, fb->height, &result)) continue;
+        if (barcodeListAdd(list, result)) Serial.printf("[QR] %d/%d: %s\n", i + 1, count, scanWork.qrData->payload);
+    }
+}
+
+// Codes side by side on one line: after a hit, search what is left on
+// either side of it
+void scan1DLineAll(uint8_t *line, int width, int y, BarcodeList *list) {
+    int segStart[2 * MULTI_MAX_SYMBOLS + 1], segEnd[2 * MULTI_MAX_SYMBOLS + 1];
+    int n = 0;
+    segStart[n] = 0; segEnd[n] = width; n++;
+    while (n > 0 && list->count < MULTI_MAX_SYMBOLS) {
+        n--;
+        int a = segStart[n], b = segEnd[n];
+        if (b - a < MULTI_MIN_SEGMENT) continue;
+        BarcodeResult r = scan1DLine(line + a, b - a, y);
+        if (!r.found) continue;
+        r.x += a;
+        barcodeListAdd(list, r);
+        if (n + 2 > 2 * MULTI_MAX_SYMBOLS + 1) continue;
+        segStart[n] = a; segEnd[n] = r.x; n++;
+        segStart[n] = r.x + r.w; segEnd[n] = b; n++;
+    }
+}
+
+void scan1DBarcodes(camera_fb_t *fb, BarcodeList *list) {
+    if (fb->format != PIXFORMAT_GRAYSCALE) return;
+    int width = fb->width, height = fb->height;
+    int scanLines[] = { height/2, height/3, height*2/3, height/4, height*3/4,
+                        height*2/5, height*3/5, height*5/12, height*7/12 };
+    for (int sl = 0; sl < 9 && list->count < MULTI_MAX_SYMBOLS; sl++) {
+        scan1DLineAll(fb->buf + scanLines[sl] * width, width, scanLines[sl], list);
+    }
+}
+
 // ============ MAIN SCAN FUNCTION ============
 BarcodeResult scanBarcode(camera_fb_t *fb) {
-    BarcodeResult result;
-    result.found = false;
+    BarcodeResult result = {};
 
     Serial.println("[SCAN] Analyzing frame...");
     Serial.printf("[SCAN] Size: %dx%d, Format: %d\n", fb->width, fb->height, fb->format);
 
     // Try QR code first
+    TRACE_BEGIN(tQr);
     result = scanQRCode(fb);
+    TRACE_END(TRACE_QR, tQr);
     if (result.found) return result;
 
     // Try 1D barcodes (EAN-13, EAN-8, UPC-A)
     Serial.println("[SCAN] Trying 1D barcodes...");
+    TRACE_BEGIN(t1d);
     result = scan1DBarcode(fb);
+    TRACE_END(TRACE_1D, t1d);
     if (result.found) return result;
 
     // Debug: analyze image quality
@@ -540,12 +888,30 @@ BarcodeResult scanBarcode(camera_fb_t *fb) {
     return result;
 }
 
+// Production scan: every code with MULTI_SYMBOL_SCAN, else scanBarcode()'s
+// first hit. Returns how many codes the list holds.
+int scanBarcodes(camera_fb_t *fb, BarcodeList *list) {
+#ifdef MULTI_SYMBOL_SCAN
+    Serial.println("[SCAN] Analyzing frame (multi)...");
+    TRACE_BEGIN(tQr);
+    scanQRCodes(fb, list);
+    TRACE_END(TRACE_QR, tQr);
+    TRACE_BEGIN(t1d);
+    scan1DBarcodes(fb, list);
+    TRACE_END(TRACE_1D, t1d);
+    Serial.printf("[SCAN] %d codici nel frame\n", list->count);
+#else
+    barcodeListAdd(list, scanBarcode(fb));
+#endif
+    return list->count;
+}
+
 // ============ CLEANUP ============
 void cleanupBarcodeScanner() {
-    if (qr != NULL) {
-        quirc_destroy(qr);
-        qr = NULL;
+    for (int i = 0; i < qrInstanceCount; i++) {
+        quirc_destroy(qrInstances[i].q);
     }
+    qrInstanceCount = 0;
 }
 
 #endif
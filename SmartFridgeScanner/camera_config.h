@@ -2,6 +2,11 @@
 #define CAMERA_CONFIG_H
 
 #include "esp_camera.h"
+#include "esp_timer.h"
+#include "config.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
 
 // ============ AI-THINKER ESP32-CAM PINOUT ============
 #if defined(BOARD_ESP32CAM) || defined(BOARD_WROVER)
@@ -49,12 +54,400 @@
 #error "No board defined! Define BOARD_ESP32CAM, BOARD_WROVER, or BOARD_ESP32S3"
 #endif
 
+// ============ FRAME ACCESS ============
+// loop() and the debug stream task share the camera; with a single frame
+// buffer (no PSRAM) two concurrent holders would deadlock the driver.
+SemaphoreHandle_t cameraMutex = NULL;
+volatile bool cameraBusy = false;   // Production scan running, debug consumers back off
+
+// Decided in initCamera(), used to size the scanner arena and quirc
+int cameraFrameWidth = 0, cameraFrameHeight = 0;
+bool cameraInPsram = false;
+int cameraFbCount = 0;              // Driver buffers; a caller may hold all but one
+bool cameraBandMode = false;        // No PSRAM: frames are bands of the field (ENABLE_BAND_CAPTURE)
+#define CAM_QR_SIZES 2
+int cameraQrSizes[CAM_QR_SIZES][2]; // Grayscale frame sizes QR codes are looked for in
+int cameraQrSizeCount = 0;
+camera_config_t cameraConfig;       // Kept for re-initialising the driver
+
+// ============ SENSOR STANDBY ============
+// Between scans the sensor is parked: PWDN pin where wired, otherwise the
+// sensor's own standby bit. The driver simply sees no VSYNC meanwhile.
+// While awake a PM lock keeps the chip out of automatic light sleep, which
+// would stop XCLK and the capture DMA mid-frame.
+volatile bool cameraAsleep = false;
+int64_t cameraResumeAtUs = 0;       // Pending resume, cleared by the first fresh frame
+uint32_t cameraResumeMs = 0, cameraResumeMaxMs = 0;
+uint32_t cameraStandbyCount = 0;
+uint64_t cameraStandbyUs = 0;       // Total time parked, excluding the current period
+int64_t cameraStandbySinceUs = 0;
+#if CONFIG_PM_ENABLE
+esp_pm_lock_handle_t cameraPmLock = NULL;
+#endif
+
+// Standby register per sensor, false if this sensor has none we know of
+bool cameraSetStandbyReg(bool on) {
+    sensor_t *s = esp_camera_sensor_get();
+    if (!s) return false;
+    switch (s->id.PID) {
+        case OV2640_PID: return s->set_reg(s, 0x109, 0x10, on ? 0x10 : 0) == 0;    // Bank 1 COM2 bit 4
+        case OV3660_PID:
+        case OV5640_PID: return s->set_reg(s, 0x3008, 0x40, on ? 0x40 : 0) == 0;   // SYSTEM CTROL0 power down
+        default:         return false;
+    }
+}
+
+// Call with cameraMutex held (or before it exists)
+void cameraPower(bool on) {
+    if (on == !cameraAsleep) return;
+    if (PWDN_GPIO_NUM != -1) {
+        digitalWrite(PWDN_GPIO_NUM, on ? LOW : HIGH);
+    } else if (!cameraSetStandbyReg(!on)) {
+        return;     // No way to park this sensor, stay awake
+    }
+    cameraAsleep = !on;
+#if CONFIG_PM_ENABLE
+    if (cameraPmLock) {
+        if (on) esp_pm_lock_acquire(cameraPmLock);
+        else esp_pm_lock_release(cameraPmLock);
+    }
+#endif
+    int64_t now = esp_timer_get_time();
+    if (on) {
+        cameraResumeAtUs = now;
+        cameraStandbyUs += now - cameraStandbySinceUs;
+    } else {
+        cameraStandbySinceUs = now;
+        cameraStandbyCount++;
+    }
+}
+
+void cameraStandby() {
+    if (cameraMutex) xSemaphoreTake(cameraMutex, portMAX_DELAY);
+    cameraPower(false);
+    if (cameraMutex) xSemaphoreGive(cameraMutex);
+}
+
+// Wake the sensor ahead of a capture so it settles during e.g. the flash delay
+void cameraResume() {
+    if (!cameraAsleep) return;
+    if (cameraMutex) xSemaphoreTake(cameraMutex, portMAX_DELAY);
+    cameraPower(true);
+    if (cameraMutex) xSemaphoreGive(cameraMutex);
+}
+
+bool cameraLock(TickType_t wait = portMAX_DELAY) {
+    return cameraMutex == NULL || xSemaphoreTake(cameraMutex, wait) == pdTRUE;
+}
+
+void cameraUnlock() {
+    if (cameraMutex) xSemaphoreGive(cameraMutex);
+}
+
+// ============ BAND WINDOWING (no PSRAM) ============
+// The driver's buffer is sized for QVGA. The OV2640 DSP window either shows
+// the whole field scaled to 320x240 or one 640x120 band of the VGA image at
+// full scale: both fill the same 76800 bytes, the only thing the driver
+// checks. The driver keeps reporting 320x240, so cameraFetchFrame() fixes
+// the geometry up.
+#define CAM_BAND_W          640
+#define CAM_BAND_H          120
+#define CAM_BANDS           4           // VGA field, 480 rows
+#define CAM_FIELD_W         320         // Whole field (QR, stream, fallback)
+#define CAM_FIELD_H         240
+#define OV2640_SVGA_MODE    1           // Sensor readout 800x600, the VGA window
+
+int cameraBand = -1;                // Window shown, -1 = whole field
+int64_t cameraWindowAtUs = 0;       // Pending window change, older frames are stale
+int cameraOutW = 0, cameraOutH = 0; // Profile window (capture profiles below), 0 = as the driver reports
+
+#ifdef ENABLE_BAND_CAPTURE
+// Call with cameraLock() held; the sensor switches at its next frame
+bool cameraSetWindow(int band) {
+    if (!cameraBandMode || band == cameraBand) return true;
+    sensor_t *s = esp_camera_sensor_get();
+    if (!s) return false;
+    int err;
+    if (band < 0) {
+        err = s->set_framesize(s, FRAMESIZE_QVGA);
+    } else {
+        // Rows band*150.. of the 800x600 readout, scaled 0.8 like VGA
+        err = s->set_res_raw(s, OV2640_SVGA_MODE, 0, 0, 0, 0, band * 150, 800, 150,
+                             CAM_BAND_W, CAM_BAND_H, false, false);
+    }
+    if (err) {
+        Serial.printf("[CAM] Finestra %d rifiutata\n", band);
+        return false;
+    }
+    cameraBand = band;
+    cameraWindowAtUs = esp_timer_get_time();
+    return true;
+}
+#endif
+
+// Next frame with cameraLock() held; return it with esp_camera_fb_return()
+camera_fb_t* cameraFetchFrame() {
+    cameraPower(true);
+    camera_fb_t *fb = esp_camera_fb_get();
+
+    // After standby or a window change the driver may still hold a frame
+    // from before it: skip anything captured earlier
+    int64_t freshUs = max(cameraResumeAtUs, cameraWindowAtUs);
+    if (freshUs) {
+        for (int i = 0; fb && i < 3; i++) {
+            int64_t us = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+            if (us >= freshUs) break;
+            esp_camera_fb_return(fb);
+            fb = esp_camera_fb_get();
+        }
+        if (fb && cameraResumeAtUs) {
+            cameraResumeMs = (esp_timer_get_time() - cameraResumeAtUs) / 1000;
+            if (cameraResumeMs > cameraResumeMaxMs) cameraResumeMaxMs = cameraResumeMs;
+            cameraResumeAtUs = 0;
+            Serial.printf("[CAM] Ripresa da standby: %u ms\n", cameraResumeMs);
+        }
+        if (fb) cameraWindowAtUs = 0;
+    }
+
+    // The driver keeps reporting the size it was started with
+    if (fb && cameraBandMode) {
+        fb->width = cameraBand < 0 ? CAM_FIELD_W : CAM_BAND_W;
+        fb->height = cameraBand < 0 ? CAM_FIELD_H : CAM_BAND_H;
+    } else if (fb && cameraOutW) {
+        fb->width = cameraOutW;
+        fb->height = cameraOutH;
+    }
+    return fb;
+}
+
+camera_fb_t* cameraGetFrame(TickType_t wait = portMAX_DELAY) {
+    if (!cameraLock(wait)) return NULL;
+    camera_fb_t *fb = cameraFetchFrame();
+    if (!fb) cameraUnlock();
+    return fb;
+}
+
+void cameraReturnFrame(camera_fb_t *fb) {
+    esp_camera_fb_return(fb);
+    cameraUnlock();
+}
+
+// Automatic exposure and gain, as tuned for scanning
+void cameraAutoExposure(sensor_t *s) {
+    s->set_exposure_ctrl(s, 1);     // Auto exposure
+    s->set_aec2(s, 1);              // Enable AEC DSP for better exposure
+    s->set_gain_ctrl(s, 1);         // Auto gain
+    s->set_agc_gain(s, 5);          // Increase AGC gain for brighter image
+}
+
+// Sensor optimization for barcode/QR detection; lost on esp_camera_deinit()
+void cameraTuneSensor(sensor_t *s) {
+    s->set_brightness(s, 2);        // Brighter (was 1)
+    s->set_contrast(s, 2);          // High contrast (important for barcodes)
+    s->set_saturation(s, -2);       // Low saturation (more B&W like)
+    s->set_sharpness(s, 2);         // Max sharpness (important for barcodes)
+    s->set_denoise(s, 0);           // No denoise (preserve edges)
+    s->set_special_effect(s, 0);    // No effect (was grayscale, but format is already grayscale)
+    s->set_whitebal(s, 1);          // Auto white balance
+    s->set_awb_gain(s, 1);          // AWB gain
+    s->set_wb_mode(s, 0);           // Auto WB mode
+    cameraAutoExposure(s);
+    s->set_bpc(s, 1);               // Black pixel correction
+    s->set_wpc(s, 1);               // White pixel correction
+    s->set_raw_gma(s, 1);           // Gamma correction
+    s->set_lenc(s, 1);              // Lens correction
+    s->set_hmirror(s, 1);           // Horizontal mirror (fix orientation)
+    s->set_vflip(s, 1);             // Vertical flip (fix orientation)
+    s->set_dcw(s, 1);               // Downsize enable
+}
+
+// ============ CAPTURE PROFILES ============
+// One sensor setup per task: quick frames of the whole field for scanning, a
+// magnified centre when a scan finds nothing, an upright crop for receipts.
+// The frame buffers are allocated once at boot and every profile fills them
+// with exactly as many grayscale bytes: the ESP32 driver drops any raw frame
+// of another length (FB-SIZE) and cannot change format while running. On the
+// OV2640 the profiles are DSP windows (set_framesize / set_res_raw), as the
+// bands are, so a switch only reprograms the sensor and skips the frames from
+// before it. The one exception is the receipt without PSRAM: as grayscale it
+// would not fit the band buffer, so the driver is restarted for a JPEG from
+// the sensor. Switch time is logged and reported in /status.
+enum CameraProfile { CAM_PROFILE_SCAN, CAM_PROFILE_DETAIL, CAM_PROFILE_RECEIPT, CAM_PROFILES };
+const char *CAM_PROFILE_NAMES[CAM_PROFILES] = { "scan", "dettaglio", "scontrino" };
+
+#define OV2640_UXGA_MODE    0           // Sensor readout 1600x1200, full resolution
+#define OV2640_UXGA_W       1600
+#define OV2640_UXGA_H       1200
+
+struct CameraProfileSpec {
+    int w, h;                       // Frame the sketch sees; with bands, one band
+    int mode;                       // OV2640 readout of the window, -1 = whole field (set_framesize)
+    int winX, winY, winW, winH;     // Window in that readout's pixels
+    bool bands;                     // Windowed into bands by band_capture.h
+    bool jpeg;                      // Driver restarted for a sensor JPEG
+};
+
+CameraProfile cameraProfile = CAM_PROFILE_SCAN;
+bool cameraWindowsOk = true;        // Cleared if the sensor has no windows we know of (not an OV2640)
+uint32_t cameraSwitchCount = 0, cameraSwitchMs = 0, cameraSwitchMaxMs = 0;
+
+// Frame size the driver is started with, i.e. the bytes of every buffer
+framesize_t cameraBufferSize() {
+    if (psramFound()) return FRAMESIZE_SVGA;    // 480 KB x BURST_DECODE+1 in PSRAM
+#ifdef ENABLE_BAND_CAPTURE
+    if (cameraWindowsOk) return FRAMESIZE_QVGA;
+#endif
+    return FRAMESIZE_VGA;
+}
+
+void cameraFramesizeDims(framesize_t size, int *w, int *h) {
+    switch (size) {
+        case FRAMESIZE_QVGA: *w = 320; *h = 240; break;
+        case FRAMESIZE_SVGA: *w = 800; *h = 600; break;
+        default:             *w = 640; *h = 480; break;
+    }
+}
+
+CameraProfileSpec cameraProfileSpec(CameraProfile p) {
+    int bw, bh;
+    cameraFramesizeDims(cameraBufferSize(), &bw, &bh);
+    CameraProfileSpec scan = { bw, bh, -1, 0, 0, 0, 0, false, false };
+#ifdef ENABLE_BAND_CAPTURE
+    if (!psramFound() && cameraWindowsOk) {
+        // No room for anything but the band buffer: detail is the scan, the
+        // receipt a VGA JPEG (~60 KB buffer) after a driver restart
+        scan = { CAM_BAND_W, CAM_BAND_H, -1, 0, 0, 0, 0, true, false };
+        if (p == CAM_PROFILE_RECEIPT) return { 640, 480, -1, 0, 0, 0, 0, false, true };
+        return scan;
+    }
+#endif
+    if (!cameraWindowsOk) return scan;      // One frame for everything
+    switch (p) {
+        case CAM_PROFILE_DETAIL:
+            // Centre of the full resolution readout at 1:1: 2x the scan's
+            // magnification at 800x600 (2.5x at 640x480)
+            return { bw, bh, OV2640_UXGA_MODE, (OV2640_UXGA_W - bw) / 2, (OV2640_UXGA_H - bh) / 2,
+                     bw, bh, false, false };
+        case CAM_PROFILE_RECEIPT: {
+            // Upright: the full sensor height and a 3:4 strip of the width,
+            // out as bh x bw (600x800: 0.67 of full resolution)
+            int winW = OV2640_UXGA_H * bh / bw;
+            return { bh, bw, OV2640_UXGA_MODE, (OV2640_UXGA_W - winW) / 2, 0,
+                     winW, OV2640_UXGA_H, false, false };
+        }
+        default:
+            return scan;
+    }
+}
+
+bool cameraSameSpec(const CameraProfileSpec &a, const CameraProfileSpec &b) {
+    return a.w == b.w && a.h == b.h && a.mode == b.mode && a.winX == b.winX && a.winY == b.winY &&
+           a.winW == b.winW && a.winH == b.winH && a.bands == b.bands && a.jpeg == b.jpeg;
+}
+
+// False where the profile would deliver the same frames as the scan profile
+bool cameraHasProfile(CameraProfile p) {
+    return p == CAM_PROFILE_SCAN || !cameraSameSpec(cameraProfileSpec(p), cameraProfileSpec(CAM_PROFILE_SCAN));
+}
+
+// Driver up in grayscale with the boot buffers, or in JPEG for the no-PSRAM
+// receipt; cameraConfig already holds pins and clock. Call with the driver down.
+esp_err_t cameraStartDriver(bool jpeg) {
+    if (jpeg) {
+        cameraConfig.frame_size = FRAMESIZE_VGA;
+        cameraConfig.pixel_format = PIXFORMAT_JPEG;
+        cameraConfig.fb_count = 1;
+    } else {
+        cameraConfig.frame_size = cameraBufferSize();
+        cameraConfig.pixel_format = PIXFORMAT_GRAYSCALE;
+        // Burst keeps its best frames while grabbing
+        cameraConfig.fb_count = psramFound() ? max(2, BURST_DECODE + 1) : 1;
+    }
+    cameraConfig.fb_location = psramFound() ? CAMERA_FB_IN_PSRAM : CAMERA_FB_IN_DRAM;
+    cameraConfig.jpeg_quality = RECEIPT_SENSOR_JPEG_QUALITY;
+    esp_err_t err = esp_camera_init(&cameraConfig);
+    if (err != ESP_OK) return err;
+    sensor_t *s = esp_camera_sensor_get();
+    if (s == NULL) {
+        Serial.println("[CAM] Failed to get sensor");
+        return ESP_FAIL;
+    }
+    cameraTuneSensor(s);
+    cameraFbCount = cameraConfig.fb_count;
+    cameraInPsram = cameraConfig.fb_location == CAMERA_FB_IN_PSRAM;
+    cameraOutW = cameraOutH = 0;
+    cameraBand = -1;
+    return ESP_OK;
+}
+
+// Program the sensor for profile p; call with cameraLock() held and the
+// driver in p's format. The sensor switches at its next frame.
+bool cameraApplyProfile(CameraProfile p) {
+    CameraProfileSpec spec = cameraProfileSpec(p);
+    sensor_t *s = esp_camera_sensor_get();
+    if (!s) return false;
+    int err = 0;
+    if (spec.jpeg) {
+        // Nothing to window: the driver was started at the receipt size
+    } else if (spec.mode < 0) {
+        err = s->set_framesize(s, cameraConfig.frame_size);
+    } else {
+        err = s->set_res_raw(s, spec.mode, 0, 0, 0, spec.winX, spec.winY, spec.winW, spec.winH,
+                             spec.w, spec.h, false, false);
+    }
+    if (err) return false;
+    cameraProfile = p;
+    cameraBandMode = spec.bands;
+    cameraBand = -1;
+    // Bands report their own geometry (cameraFetchFrame); JPEG is the driver's
+    cameraOutW = spec.bands || spec.jpeg ? 0 : spec.w;
+    cameraOutH = spec.bands || spec.jpeg ? 0 : spec.h;
+    cameraWindowAtUs = esp_timer_get_time();
+    return true;
+}
+
+// Switch to profile p, measured. If p cannot be set up the scan profile is
+// restored. Returns true if p is active.
+bool cameraUseProfile(CameraProfile p) {
+    if (p == cameraProfile) return true;
+    CameraProfileSpec spec = cameraProfileSpec(p);
+    bool restart = spec.jpeg != cameraProfileSpec(cameraProfile).jpeg;
+    if (cameraSameSpec(spec, cameraProfileSpec(cameraProfile))) {
+        cameraProfile = p;
+        return true;
+    }
+    if (!cameraLock()) return false;
+    int64_t t0 = esp_timer_get_time();
+    cameraPower(true);
+    esp_err_t err = ESP_OK;
+    if (restart) {
+        esp_camera_deinit();
+        err = cameraStartDriver(spec.jpeg);
+    }
+    bool ok = err == ESP_OK && cameraApplyProfile(p);
+    if (!ok) {
+        Serial.printf("[CAM] Profilo %s non disponibile (0x%x), torno a %s\n",
+                      CAM_PROFILE_NAMES[p], err, CAM_PROFILE_NAMES[CAM_PROFILE_SCAN]);
+        if (restart) {
+            esp_camera_deinit();
+            if (cameraStartDriver(false) != ESP_OK) Serial.println("[CAM] Re-init failed");
+        }
+        cameraApplyProfile(CAM_PROFILE_SCAN);
+    }
+    cameraSwitchMs = (esp_timer_get_time() - t0) / 1000;
+    cameraSwitchMaxMs = max(cameraSwitchMaxMs, cameraSwitchMs);
+    cameraSwitchCount++;
+    cameraUnlock();
+    Serial.printf("[CAM] Profilo %s: cambio in %u ms\n", CAM_PROFILE_NAMES[cameraProfile], cameraSwitchMs);
+    return ok;
+}
+
 // ============ CAMERA INITIALIZATION ============
 bool initCamera() {
     // Important: Small delay for camera power stabilization
     delay(100);
 
-    camera_config_t config;
+    camera_config_t &config = cameraConfig;
 
     // LEDC settings (use channel 0 like working firmware)
     config.ledc_channel = LEDC_CHANNEL_0;
@@ -78,42 +471,29 @@ bool initCamera() {
     config.pin_pwdn = PWDN_GPIO_NUM;
     config.pin_reset = RESET_GPIO_NUM;
 
-    // Clock and format
+    // Clock; format, size and buffers come from cameraStartDriver()
     config.xclk_freq_hz = 20000000;
-    config.pixel_format = PIXFORMAT_GRAYSCALE;  // Grayscale optimal for QR/barcode detection
     config.grab_mode = CAMERA_GRAB_LATEST;
 
-    // Frame size and buffer based on PSRAM
-    // Note: jpeg_quality only applies to JPEG format, ignored for GRAYSCALE
-    if (psramFound()) {
-        Serial.println("[CAM] PSRAM found - using XGA 1024x768");
-        config.frame_size = FRAMESIZE_XGA;      // 1024x768 for better barcode/OCR
-        config.jpeg_quality = 10;               // Not used for grayscale
-        config.fb_count = 2;                    // Double buffer for smooth scanning
-        config.fb_location = CAMERA_FB_IN_PSRAM;
-    } else {
-        Serial.println("[CAM] No PSRAM - using VGA 640x480");
-        config.frame_size = FRAMESIZE_VGA;      // 640x480 fallback
-        config.jpeg_quality = 12;               // Not used for grayscale
-        config.fb_count = 1;                    // Single buffer (limited RAM)
-        config.fb_location = CAMERA_FB_IN_DRAM;
-    }
+    Serial.println(psramFound() ? "[CAM] PSRAM found - buffers 800x600, scan/detail/receipt windows"
+                                : "[CAM] No PSRAM - single buffer in DRAM");
 
     // Initialize camera
-    esp_err_t err = esp_camera_init(&config);
+    esp_err_t err = cameraStartDriver(false);
     if (err != ESP_OK) {
         Serial.printf("[CAM] Init failed: 0x%x\n", err);
 
         // Retry once after power cycle
         if (PWDN_GPIO_NUM != -1) {
             Serial.println("[CAM] Retrying with power cycle...");
+            esp_camera_deinit();
             pinMode(PWDN_GPIO_NUM, OUTPUT);
             digitalWrite(PWDN_GPIO_NUM, HIGH);  // Power off
             delay(100);
             digitalWrite(PWDN_GPIO_NUM, LOW);   // Power on
             delay(100);
 
-            err = esp_camera_init(&config);
+            err = cameraStartDriver(false);
             if (err != ESP_OK) {
                 Serial.printf("[CAM] Retry failed: 0x%x\n", err);
                 return false;
@@ -122,41 +502,58 @@ bool initCamera() {
             return false;
         }
     }
-
-    // Get sensor and optimize for barcode scanning
     sensor_t *s = esp_camera_sensor_get();
-    if (s == NULL) {
-        Serial.println("[CAM] Failed to get sensor");
-        return false;
+
+    if (s->id.PID != OV2640_PID) {
+        // Windows (bands, detail, receipt) are only mapped for the OV2640's registers
+        Serial.println("[CAM] Finestre solo con OV2640: un solo frame per tutti i profili");
+        cameraWindowsOk = false;
+        if (cameraBufferSize() != cameraConfig.frame_size) {
+            // No bands: the whole VGA frame
+            esp_camera_deinit();
+            if (cameraStartDriver(false) != ESP_OK) {
+                Serial.println("[CAM] Init VGA failed");
+                return false;
+            }
+            s = esp_camera_sensor_get();
+        }
     }
+    cameraApplyProfile(CAM_PROFILE_SCAN);
 
-    // Sensor optimization for barcode/QR detection
-    s->set_brightness(s, 2);        // Brighter (was 1)
-    s->set_contrast(s, 2);          // High contrast (important for barcodes)
-    s->set_saturation(s, -2);       // Low saturation (more B&W like)
-    s->set_sharpness(s, 2);         // Max sharpness (important for barcodes)
-    s->set_denoise(s, 0);           // No denoise (preserve edges)
-    s->set_special_effect(s, 0);    // No effect (was grayscale, but format is already grayscale)
-    s->set_whitebal(s, 1);          // Auto white balance
-    s->set_awb_gain(s, 1);          // AWB gain
-    s->set_wb_mode(s, 0);           // Auto WB mode
-    s->set_exposure_ctrl(s, 1);     // Auto exposure
-    s->set_aec2(s, 1);              // Enable AEC DSP for better exposure
-    s->set_gain_ctrl(s, 1);         // Auto gain
-    s->set_agc_gain(s, 5);          // Increase AGC gain for brighter image
-    s->set_bpc(s, 1);               // Black pixel correction
-    s->set_wpc(s, 1);               // White pixel correction
-    s->set_raw_gma(s, 1);           // Gamma correction
-    s->set_lenc(s, 1);              // Lens correction
-    s->set_hmirror(s, 1);           // Horizontal mirror (fix orientation)
-    s->set_vflip(s, 1);             // Vertical flip (fix orientation)
-    s->set_dcw(s, 1);               // Downsize enable
+    if (cameraMutex == NULL) cameraMutex = xSemaphoreCreateMutex();
+#if CONFIG_PM_ENABLE
+    if (cameraPmLock == NULL && esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "camera", &cameraPmLock) == ESP_OK) {
+        esp_pm_lock_acquire(cameraPmLock);
+    }
+#endif
+    // Scanner geometry: the widest frame of the scan and detail profiles, and
+    // one quirc size per distinct frame (bands: QR only in the whole field)
+    cameraFrameWidth = cameraFrameHeight = cameraQrSizeCount = 0;
+    for (int p = CAM_PROFILE_SCAN; p <= CAM_PROFILE_DETAIL; p++) {
+        CameraProfileSpec spec = cameraProfileSpec((CameraProfile)p);
+        int w = spec.w, h = spec.h;
+        cameraFrameWidth = max(cameraFrameWidth, w);
+        cameraFrameHeight = max(cameraFrameHeight, h);
+        if (spec.bands) { w = CAM_FIELD_W; h = CAM_FIELD_H; }
+        bool known = false;
+        for (int i = 0; i < cameraQrSizeCount; i++) {
+            known |= cameraQrSizes[i][0] == w && cameraQrSizes[i][1] == h;
+        }
+        if (!known && cameraQrSizeCount < CAM_QR_SIZES) {
+            cameraQrSizes[cameraQrSizeCount][0] = w;
+            cameraQrSizes[cameraQrSizeCount][1] = h;
+            cameraQrSizeCount++;
+        }
+    }
 
     Serial.printf("[CAM] Sensor: %s\n", s->id.PID == OV2640_PID ? "OV2640" :
                                         s->id.PID == OV5640_PID ? "OV5640" : "Unknown");
-    Serial.printf("[CAM] Resolution: %dx%d\n",
-                  config.frame_size == FRAMESIZE_XGA ? 1024 : 640,
-                  config.frame_size == FRAMESIZE_XGA ? 768 : 480);
+    if (cameraBandMode) {
+        Serial.printf("[CAM] Resolution: %d bande %dx%d, campo intero %dx%d\n",
+                      CAM_BANDS, CAM_BAND_W, CAM_BAND_H, CAM_FIELD_W, CAM_FIELD_H);
+    } else {
+        Serial.printf("[CAM] Resolution: %dx%d, %d buffer\n", cameraOutW, cameraOutH, cameraFbCount);
+    }
 
     return true;
 }
@@ -23,15 +23,91 @@
 #define SERVER_HOST "frigo.xamad.net"
 #define WEBHOOK_ENDPOINT "/api/product"
 #define OCR_ENDPOINT "/api/ocr"
+#define OCR_JPEG_QUALITY 85       // Date crops are tiny, keep digit edges sharp
+#define TELEMETRY_ENDPOINT "/api/telemetry"
+#define TELEMETRY_INTERVAL_MS   900000  // Heartbeat every 15 min
+#define TELEMETRY_FIRST_MS      60000   // First report 1 min after boot
+
+// ============ RECEIPT UPLOAD ============
+// Receipts are grayscale frames (capture profile), cropped, deskewed and sent
+// as 1bpp; whole frames are JPEG-encoded on the fly, chunked. Without PSRAM
+// the receipt is a JPEG from the sensor and is sent as is.
+#define RECEIPT_JPEG_QUALITY    80      // 1-100, text stays readable above ~70
+#define RECEIPT_SENSOR_JPEG_QUALITY 14  // 0-63, lower = better; VGA receipt without PSRAM, ~30-40 KB
+// Comment out to send the whole frame instead of the cropped, deskewed 1bpp receipt (grayscale only)
+#define RECEIPT_PREPROCESS
 
 // ============ TIMING CONFIGURATION ============
-#define PIR_CHECK_INTERVAL_MS   2000    // Check PIR every 2 sec
 #define MODE_TIMEOUT_MS         30000   // Auto-return to IN mode after 30 sec
 #define SCAN_COOLDOWN_MS        3000    // Min 3 sec between scans
 #define LONG_PRESS_MS           1000    // 1 sec for mode toggle
+#define RECEIPT_PRESS_MS        3000    // 3 sec for receipt scan
 #define DEBOUNCE_MS             50      // Button debounce
 #define DEEP_SLEEP_TIMEOUT_MS   300000  // 5 min inactivity -> sleep
 
+// ============ BURST CAPTURE ============
+// Each scan grabs a short burst and decodes only the sharpest frame(s), so a
+// moving hand costs a few frames instead of a failed scan (frame_quality.h)
+#define BURST_FRAMES            4       // Frames per scan, 1 = single frame
+#define BURST_DECODE            2       // Sharpest frames decoded, needs BURST_DECODE+1 buffers (PSRAM)
+#define BURST_ACCEPT_PCT        75      // Single buffer: take the first frame this close to the best seen
+#define BURST_SETTLE_MS         150     // Flash on -> first frame; early frames simply score lower
+
+// ============ BAND CAPTURE (no PSRAM) ============
+// Without PSRAM the OV2640 is windowed into 640x120 bands of the VGA field,
+// delivered through a QVGA-sized 77 KB frame buffer instead of a 307 KB one,
+// and each band is decoded as it lands (band_capture.h). QR codes and the
+// debug stream see the whole field at 320x240; receipts briefly switch the
+// driver to a whole VGA frame (capture profiles below).
+#define ENABLE_BAND_CAPTURE
+#define BAND_PASSES             2       // Sweeps over the four bands before giving up
+
+// ============ CAPTURE PROFILES ============
+// The sensor is set up per task inside frame buffers allocated at boot
+// (camera_config.h). With PSRAM: scan = whole field at 800x600, detail = the
+// centre at full resolution, receipt = an upright 600x800 strip. Without
+// PSRAM: bands, and a VGA JPEG receipt (driver restart). Switch time is in /status.
+#define SCAN_DETAIL_RETRY               // Nothing decoded at scan size -> one more burst at detail size
+
+// ============ FLASH STROBE ============
+// ESP32-CAM: instead of holding the flash on through the burst, one short
+// pulse per frame in the sensor's vertical blanking, with a fixed exposure
+// of a whole frame so every row is exposing when it fires (flash_strobe.h).
+// Scan profile only; detail and receipt frames keep the steady flash.
+#define ENABLE_FLASH_STROBE
+#define STROBE_PULSE_US         2000    // Per frame, must fit the blanking (~10% of the frame period)
+#define STROBE_DELAY_US         0       // VSYNC rising edge -> pulse; raise if the bottom rows stay dark
+#define STROBE_GAIN             0       // Fixed AGC gain while strobing (0-30): ambient light stays dark
+
+// ============ MULTI-SYMBOL SCAN ============
+// Report every distinct code in the frame (items held together), sent to the
+// server as one batched request. Comment out to stop at the first code.
+#define MULTI_SYMBOL_SCAN
+#define MULTI_MAX_SYMBOLS       4
+
+// ============ CURVED LABELS ============
+// Barcodes wrapped around cans and bottles narrow towards the edges. When the
+// fixed module width fails, EAN/UPC are decoded again from run lengths, with
+// the module width re-estimated from every digit (barcode_scanner.h)
+#define ENABLE_CURVED_1D
+
+// ============ SCANLINE FUSION ============
+// When no burst frame decodes on its own, the same scanlines from every
+// burst frame are aligned and averaged, then decoded (scanline_fusion.h).
+// Recovers 1D codes the flash cannot light well enough for one frame.
+#define ENABLE_SCANLINE_FUSION
+#define FUSION_FRAMES           5       // Frames averaged at most
+#define FUSION_LINES            5       // Scanlines fused per frame
+#define FUSION_BAND_ROWS        4       // Rows averaged into one scanline profile
+#define FUSION_MAX_SHIFT        24      // Horizontal hand motion searched, px from the first frame
+
+// ============ POWER ============
+// Automatic light sleep between events (needs CONFIG_PM_ENABLE in the IDF
+// build, otherwise only modem sleep) and sensor standby after IDLE_STANDBY_MS
+#define ENABLE_LIGHT_SLEEP
+#define IDLE_STANDBY_MS         10000
+#define INPUT_POLL_IDLE_MS      60      // Button on XCLK sampled this often in standby; shorter taps may be missed
+
 // ============ WIFI AP CONFIGURATION ============
 #define WIFI_AP_SSID "FridgeScanner"
 #define WIFI_AP_PASS "fridge2026"
@@ -40,4 +116,24 @@
 // ============ DEBUG ============
 #define DEBUG_SERIAL true
 
+// Per-stage scan timings served on /metrics (Prometheus) and /metrics.json.
+// Comment out to compile tracing away entirely.
+#define ENABLE_SCAN_TRACE
+
+// MJPEG live view on http://<ip>/stream, frames cached by a task that yields to scans
+#define DEBUG_STREAM_FPS        4       // Frames encoded; viewers get ~2 fps on a fast link (debug_server.h)
+#define DEBUG_STREAM_QUALITY    40      // JPEG quality 1-100, ~15-25 KB per VGA frame
+#define DEBUG_STREAM_CLIENTS    2       // Simultaneous viewers
+#define DEBUG_OVERLAY_MS        3000    // How long the last decode stays drawn
+// The frame cache task runs the /scan decode: loop task stack (8192, where
+// scans normally run) plus the task's own frames. The low-water mark is on
+// /status as framecache_stack_free and logged as "[DEBUG] Stack framecache".
+#define DEBUG_TASK_STACK        10240
+
+// Decoder benchmark over the reference frames in the "benchframes" flash
+// partition (partitions.csv, image from tools/bench_partition.py). Started
+// from http://<ip>/bench?run=1 or by holding BOOT for BENCH_PRESS_MS.
+// #define ENABLE_SELF_BENCH
+#define BENCH_PRESS_MS          8000
+
 #endif
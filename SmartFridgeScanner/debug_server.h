@@ -1,10 +1,19 @@
 #ifndef DEBUG_SERVER_H
 #define DEBUG_SERVER_H
 
-#include <WebServer.h>
+#include <WiFi.h>
+#include <AsyncTCP.h>
+#include <ESPAsyncWebServer.h>
 #include "esp_camera.h"
+#include "img_converters.h"
+#include "expiry_ocr.h"
+#include "scan_trace.h"
+#ifdef ENABLE_SELF_BENCH
+#include "self_bench.h"
+#endif
 
-WebServer debugServer(80);
+// Event-driven: requests are handled in the AsyncTCP task, never in loop()
+AsyncWebServer debugServer(80);
 
 // HTML page with live preview
 const char DEBUG_HTML[] PROGMEM = R"rawliteral(
@@ -31,12 +40,12 @@ const char DEBUG_HTML[] PROGMEM = R"rawliteral(
 
     <div>
         <button class="btn" onclick="capture()">Cattura Foto</button>
-        <button class="btn" onclick="toggleAuto()">Auto Refresh: <span id="autoStatus">OFF</span></button>
+        <button class="btn" onclick="toggleLive()">Live: <span id="liveStatus">ON</span></button>
         <button class="btn btn-red" onclick="testScan()">Test Scan</button>
     </div>
 
     <div>
-        <img id="preview" src="/capture" alt="Camera preview">
+        <img id="preview" alt="Camera preview">
         <p class="refresh">Ultimo aggiornamento: <span id="timestamp">-</span></p>
     </div>
 
@@ -45,6 +54,7 @@ const char DEBUG_HTML[] PROGMEM = R"rawliteral(
         <strong>IP:</strong> <span id="ip">-</span><br>
         <strong>RSSI:</strong> <span id="rssi">-</span> dBm<br>
         <strong>Resolution:</strong> <span id="resolution">-</span><br>
+        <strong>Stream:</strong> <span id="fps">-</span> fps, <span id="viewers">-</span> client<br>
         <strong>Free Heap:</strong> <span id="heap">-</span> bytes
     </div>
 
@@ -52,37 +62,42 @@ const char DEBUG_HTML[] PROGMEM = R"rawliteral(
         <strong>Tips per scansione:</strong><br>
         - Distanza: 10-15 cm dalla camera<br>
         - Barcode orizzontale (parallelo al bordo lungo)<br>
-        - Buona illuminazione (flash attivo durante scan)<br>
-        - Per lattine: ruota per avere parte piatta verso camera
+        - Buona illuminazione (flash attivo durante scan)
     </div>
 
     <script>
-        let autoRefresh = false;
-        let autoInterval = null;
+        let live = true;
+        const streamUrl = '/stream';
 
         function capture() {
+            live = false;
+            document.getElementById('liveStatus').textContent = 'OFF';
             document.getElementById('preview').src = '/capture?' + Date.now();
             document.getElementById('timestamp').textContent = new Date().toLocaleTimeString();
         }
 
-        function toggleAuto() {
-            autoRefresh = !autoRefresh;
-            document.getElementById('autoStatus').textContent = autoRefresh ? 'ON' : 'OFF';
-            if (autoRefresh) {
-                autoInterval = setInterval(capture, 1000);
-            } else {
-                clearInterval(autoInterval);
-            }
+        function toggleLive() {
+            if (live) { capture(); return; }
+            live = true;
+            document.getElementById('liveStatus').textContent = 'ON';
+            document.getElementById('preview').src = streamUrl;
+            document.getElementById('timestamp').textContent = 'live';
         }
 
-        function testScan() {
-            fetch('/scan').then(r => r.json()).then(data => {
+        // Retry while the frame cache warms up
+        document.getElementById('preview').onerror = function() {
+            if (!live) setTimeout(capture, 500);
+        };
+
+        function testScan(after) {
+            fetch(after ? '/scan?after=' + after : '/scan').then(r => r.json()).then(data => {
+                if (data.pending) { setTimeout(() => testScan(data.after), 300); return; }
                 if (data.found) {
                     alert('Barcode trovato!\n\nTipo: ' + data.type + '\nDati: ' + data.data);
                 } else {
                     alert('Nessun barcode rilevato.\n\nContrasto: ' + data.contrast + '\nBrightness: ' + data.brightness);
                 }
-                capture();
+                if (!live) capture();
             });
         }
 
@@ -93,10 +108,13 @@ const char DEBUG_HTML[] PROGMEM = R"rawliteral(
                 document.getElementById('rssi').textContent = data.rssi;
                 document.getElementById('resolution').textContent = data.width + 'x' + data.height;
                 document.getElementById('heap').textContent = data.heap;
+                document.getElementById('fps').textContent = data.stream_fps;
+                document.getElementById('viewers').textContent = data.stream_clients;
             });
         }
 
-        capture();
+        live = false;
+        toggleLive();
         loadStatus();
         setInterval(loadStatus, 5000);
     </script>
@@ -107,143 +125,523 @@ const char DEBUG_HTML[] PROGMEM = R"rawliteral(
 // Variables for scan result
 extern bool modeAdd;
 
+// ============ DECODE OVERLAY ============
+// Last decode result, drawn on streamed frames for DEBUG_OVERLAY_MS.
+// Written and read only while holding cameraMutex (a frame or cameraLock()).
+struct DecodeOverlay {
+    unsigned long stamp;
+    int x, y, w, h;
+    char text[24];
+};
+DecodeOverlay lastDecode = { 0, 0, 0, 0, 0, "" };
+
+// Call from the scan path while the decoded frame is still held
+void debugNoteDecode(const BarcodeResult &result) {
+    lastDecode.stamp = millis();
+    lastDecode.x = result.x; lastDecode.y = result.y;
+    lastDecode.w = result.w; lastDecode.h = result.h;
+    strncpy(lastDecode.text, result.data, sizeof(lastDecode.text) - 1);
+    lastDecode.text[sizeof(lastDecode.text) - 1] = '\0';
+}
+
+void overlayFill(camera_fb_t *fb, int x, int y, int w, int h, uint8_t v) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > (int)fb->width) w = fb->width - x;
+    if (y + h > (int)fb->height) h = fb->height - y;
+    for (int r = 0; r < h; r++) memset(fb->buf + (y + r) * fb->width + x, v, w > 0 ? w : 0);
+}
+
+// Digits and '/' from the OCR reference font; other characters left blank
+void overlayText(camera_fb_t *fb, int x, int y, const char *text, int scale) {
+    for (; *text; text++, x += 6 * scale) {
+        const char *c = strchr(OCR_CLASS_CHARS, *text);
+        if (c == NULL) continue;
+        const uint8_t *glyph = OCR_FONT[c - OCR_CLASS_CHARS];
+        for (int gy = 0; gy < 7; gy++)
+            for (int gx = 0; gx < 5; gx++)
+                if (glyph[gy] & (0x10 >> gx)) overlayFill(fb, x + gx * scale, y + gy * scale, scale, scale, 255);
+    }
+}
+
+void drawDecodeOverlay(camera_fb_t *fb) {
+    if (fb->format != PIXFORMAT_GRAYSCALE || lastDecode.stamp == 0) return;
+    if (millis() - lastDecode.stamp > DEBUG_OVERLAY_MS) return;
+
+    // White frame with black outline so it shows on any background
+    const DecodeOverlay &d = lastDecode;
+    overlayFill(fb, d.x - 3, d.y - 3, d.w + 6, 5, 0);
+    overlayFill(fb, d.x - 3, d.y + d.h - 2, d.w + 6, 5, 0);
+    overlayFill(fb, d.x - 3, d.y - 3, 5, d.h + 6, 0);
+    overlayFill(fb, d.x + d.w - 2, d.y - 3, 5, d.h + 6, 0);
+    overlayFill(fb, d.x - 2, d.y - 2, d.w + 4, 3, 255);
+    overlayFill(fb, d.x - 2, d.y + d.h - 1, d.w + 4, 3, 255);
+    overlayFill(fb, d.x - 2, d.y - 2, 3, d.h + 4, 255);
+    overlayFill(fb, d.x + d.w - 1, d.y - 2, 3, d.h + 4, 255);
+
+    // Decoded digits on a black band above the symbol (below if no room)
+    const int scale = 3;
+    int textW = strlen(d.text) * 6 * scale + 2 * scale;
+    int textY = d.y - 10 * scale >= 0 ? d.y - 10 * scale : d.y + d.h + 4;
+    overlayFill(fb, d.x, textY, textW, 9 * scale, 0);
+    overlayText(fb, d.x + scale, textY + scale, d.text, scale);
+}
+
+// ============ FRAME CACHE ============
+// One task grabs frames only while someone is watching, encodes them once
+// into one of two refcounted JPEG slots, and every HTTP response reads from
+// the latest slot. It yields to production scans (cameraBusy) and never
+// waits on the camera, so an open browser cannot delay a scan. A /scan
+// request decodes a copy of the frame after the camera is released.
+struct FrameSlot {
+    uint8_t *jpg;
+    size_t len;
+    uint32_t seq;
+    int refs;
+};
+
+struct DebugScan {
+    uint32_t seq;           // Frame the result was computed on, 0 = none
+    bool found;
+    char type[12];
+    char data[64];
+    int brightness, contrast, minVal, maxVal;
+};
+
+FrameSlot frameSlots[2] = { { NULL, 0, 0, 0 }, { NULL, 0, 0, 0 } };
+int latestSlot = -1;
+uint32_t frameSeq = 0;
+int frameWidth = 0, frameHeight = 0;
+SemaphoreHandle_t frameCacheMutex = NULL;
+
+volatile unsigned long frameDemandUntil = 0;   // Grab frames until this millis()
+volatile bool scanRequested = false;           // /scan waiting for the next frame
+DebugScan debugScan = { 0, false, "", "", 0, 0, 0, 0 };
+SemaphoreHandle_t debugDecodeMutex = NULL;     // Held by a debug decode (shared scanWork)
+volatile uint32_t frameCacheStackFree = 0;     // Lowest stack high-water mark seen, bytes
+
+volatile int streamClientCount = 0;
+volatile float streamFps = 0;
+
+void markFrameDemand(unsigned long ms) {
+    frameDemandUntil = millis() + ms;
+}
+
+// Take a reference to the newest JPEG, -1 if none yet
+int acquireLatestFrame() {
+    xSemaphoreTake(frameCacheMutex, portMAX_DELAY);
+    int slot = latestSlot;
+    if (slot >= 0) frameSlots[slot].refs++;
+    xSemaphoreGive(frameCacheMutex);
+    return slot;
+}
+
+void releaseFrame(int slot) {
+    if (slot < 0) return;
+    xSemaphoreTake(frameCacheMutex, portMAX_DELAY);
+    frameSlots[slot].refs--;
+    xSemaphoreGive(frameCacheMutex);
+}
+
+// Store a freshly encoded frame; dropped if both slots are still being sent
+void publishFrame(uint8_t *jpg, size_t len, int width, int height) {
+    xSemaphoreTake(frameCacheMutex, portMAX_DELAY);
+    int slot = latestSlot == 0 ? 1 : 0;
+    if (frameSlots[slot].refs == 0) {
+        free(frameSlots[slot].jpg);
+        frameSlots[slot].jpg = jpg;
+        frameSlots[slot].len = len;
+        frameSlots[slot].seq = ++frameSeq;
+        latestSlot = slot;
+        frameWidth = width;
+        frameHeight = height;
+        jpg = NULL;
+    }
+    xSemaphoreGive(frameCacheMutex);
+    free(jpg);
+}
+
+// Production scans call this after raising cameraBusy: it waits out a debug
+// decode in flight, later ones see cameraBusy and leave the decoder alone
+void debugDecodeYield() {
+    if (debugDecodeMutex == NULL) return;
+    xSemaphoreTake(debugDecodeMutex, portMAX_DELAY);
+    xSemaphoreGive(debugDecodeMutex);
+}
+
+// Private copy of a frame for a debug decode, NULL if there is no room
+camera_fb_t* copyDebugFrame(const camera_fb_t *fb) {
+    uint32_t caps = psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    uint8_t *buf = (uint8_t *)heap_caps_malloc(fb->len, caps);
+    if (buf == NULL) return NULL;
+    camera_fb_t *copy = new camera_fb_t(*fb);
+    copy->buf = buf;
+    memcpy(buf, fb->buf, fb->len);
+    return copy;
+}
+
+void freeDebugFrame(camera_fb_t *copy) {
+    free(copy->buf);
+    delete copy;
+}
+
+// Debug scan on a copy of a cached frame, camera already released, or on
+// the frame itself (holdingCamera) when there was no room for a copy.
+// Returns false if a production scan started meanwhile; the next frame retries.
+bool runDebugScan(camera_fb_t *fb, uint32_t seq, bool holdingCamera) {
+    DebugScan r = { seq, false, "", "", 0, 0, 255, 0 };
+    long sum = 0;
+    for (int i = 0; i < (int)fb->len; i += 100) {
+        if (fb->buf[i] < r.minVal) r.minVal = fb->buf[i];
+        if (fb->buf[i] > r.maxVal) r.maxVal = fb->buf[i];
+        sum += fb->buf[i];
+    }
+    r.brightness = sum / (fb->len / 100);
+    r.contrast = r.maxVal - r.minVal;
+
+    xSemaphoreTake(debugDecodeMutex, portMAX_DELAY);
+    if (cameraBusy) {
+        xSemaphoreGive(debugDecodeMutex);
+        return false;
+    }
+    BarcodeResult result = scanBarcode(fb);
+    xSemaphoreGive(debugDecodeMutex);
+
+    if (result.found) {
+        if (holdingCamera) {
+            debugNoteDecode(result);
+        } else if (cameraLock()) {
+            debugNoteDecode(result);
+            cameraUnlock();
+        }
+        r.found = true;
+        strncpy(r.type, result.type, sizeof(r.type) - 1);
+        strncpy(r.data, result.data, sizeof(r.data) - 1);
+    }
+
+    xSemaphoreTake(frameCacheMutex, portMAX_DELAY);
+    debugScan = r;
+    xSemaphoreGive(frameCacheMutex);
+    return true;
+}
+
+// The decode is the deepest call this task makes; log when headroom shrinks
+void noteFrameCacheStack() {
+    uint32_t bytes = uxTaskGetStackHighWaterMark(NULL);
+    if (frameCacheStackFree != 0 && bytes >= frameCacheStackFree) return;
+    frameCacheStackFree = bytes;
+    Serial.printf("[DEBUG] Stack framecache: minimo %u byte liberi su %u\n", bytes, DEBUG_TASK_STACK);
+}
+
+void frameCacheTask(void *arg) {
+    TickType_t lastWake = xTaskGetTickCount();
+    unsigned long fpsStart = millis();
+    int fpsFrames = 0;
+
+    for (;;) {
+        if (cameraBusy || (long)(millis() - frameDemandUntil) > 0) {
+            streamFps = 0;
+            vTaskDelay(pdMS_TO_TICKS(100));
+            lastWake = xTaskGetTickCount();
+            continue;
+        }
+
+        camera_fb_t *fb = cameraGetFrame(0);
+        if (fb) {
+            uint8_t *jpg = NULL;
+            size_t len = 0;
+            int width = fb->width, height = fb->height;
+            uint32_t seq = frameSeq + 1;
+            camera_fb_t *copy = NULL;
+            if (scanRequested) {
+                copy = copyDebugFrame(fb);
+                // No room for a copy: decode in place, camera held meanwhile
+                if (copy == NULL && runDebugScan(fb, seq, true)) scanRequested = false;
+            }
+            drawDecodeOverlay(fb);
+            bool ok = frame2jpg(fb, DEBUG_STREAM_QUALITY, &jpg, &len);
+            cameraReturnFrame(fb);
+            if (ok) {
+                publishFrame(jpg, len, width, height);
+                fpsFrames++;
+            }
+            if (copy) {
+                if (runDebugScan(copy, seq, false)) scanRequested = false;
+                freeDebugFrame(copy);
+            }
+            noteFrameCacheStack();
+        }
+
+        if (millis() - fpsStart >= 2000) {
+            streamFps = fpsFrames * 1000.0f / (millis() - fpsStart);
+            fpsFrames = 0;
+            fpsStart = millis();
+        }
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(1000 / DEBUG_STREAM_FPS));
+    }
+}
+
+// ============ MJPEG STREAM ============
+// Per-connection state; the AsyncTCP filler copies at most maxLen bytes per
+// call (bounded by the TCP send window), straight from the referenced slot.
+// The filler runs again when sent data is acked, or on AsyncTCP's 500 ms
+// poll once nothing is in flight. So a part is followed by the next one in
+// the same call whenever a newer frame exists, and only a viewer that has
+// caught up with the producer returns TRY_AGAIN. On a fast link that means
+// one frame per poll, 2 fps (DEBUG_STREAM_FPS 4 has a newer frame ready at
+// every poll); a link slower than that gets frames back to back.
+struct StreamConn {
+    int slot;
+    uint32_t lastSeq;
+    size_t offset;
+    size_t headerLen;
+    char header[80];
+};
+
+size_t fillStream(StreamConn *c, uint8_t *buf, size_t maxLen) {
+    markFrameDemand(2000);
+
+    size_t n = 0;
+    while (n < maxLen) {
+        if (c->slot < 0) {
+            int slot = acquireLatestFrame();
+            if (slot < 0 || frameSlots[slot].seq == c->lastSeq) {
+                releaseFrame(slot);
+                break;
+            }
+            c->slot = slot;
+            c->offset = 0;
+            c->headerLen = snprintf(c->header, sizeof(c->header),
+                "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", frameSlots[slot].len);
+        }
+
+        // Part = header + JPEG + CRLF, emitted across as many calls as needed
+        const FrameSlot &f = frameSlots[c->slot];
+        size_t total = c->headerLen + f.len + 2;
+        while (n < maxLen && c->offset < total) {
+            size_t chunk;
+            if (c->offset < c->headerLen) {
+                chunk = min(maxLen - n, c->headerLen - c->offset);
+                memcpy(buf + n, c->header + c->offset, chunk);
+            } else if (c->offset < c->headerLen + f.len) {
+                chunk = min(maxLen - n, c->headerLen + f.len - c->offset);
+                memcpy(buf + n, f.jpg + (c->offset - c->headerLen), chunk);
+            } else {
+                chunk = min(maxLen - n, total - c->offset);
+                memcpy(buf + n, "\r\n" + (c->offset - c->headerLen - f.len), chunk);
+            }
+            n += chunk;
+            c->offset += chunk;
+        }
+
+        if (c->offset >= total) {
+            c->lastSeq = f.seq;
+            releaseFrame(c->slot);
+            c->slot = -1;
+        }
+    }
+    return n ? n : RESPONSE_TRY_AGAIN;
+}
+
+void handleStream(AsyncWebServerRequest *request) {
+    if (streamClientCount >= DEBUG_STREAM_CLIENTS) {
+        request->send(503, "text/plain", "Too many viewers");
+        return;
+    }
+    StreamConn *conn = new StreamConn();
+    conn->slot = -1;
+    markFrameDemand(2000);
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        "multipart/x-mixed-replace; boundary=frame",
+        [conn](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+            return fillStream(conn, buf, maxLen);
+        });
+    response->addHeader("Cache-Control", "no-cache");
+    request->onDisconnect([conn]() {
+        releaseFrame(conn->slot);
+        delete conn;
+        streamClientCount--;
+        Serial.println("[STREAM] Client disconnesso");
+    });
+    streamClientCount++;
+    Serial.println("[STREAM] Client connesso");
+    request->send(response);
+}
+
 // Handle root - serve HTML page
-void handleRoot() {
-    debugServer.send(200, "text/html", DEBUG_HTML);
+void handleRoot(AsyncWebServerRequest *request) {
+    request->send_P(200, "text/html", DEBUG_HTML);
 }
 
-// Handle /capture - return camera frame as BMP
-void handleCapture() {
-    camera_fb_t *fb = esp_camera_fb_get();
-    if (!fb) {
-        debugServer.send(500, "text/plain", "Camera capture failed");
+// Handle /capture - latest cached JPEG (with decode overlay)
+void handleCapture(AsyncWebServerRequest *request) {
+    markFrameDemand(5000);
+    int slot = acquireLatestFrame();
+    if (slot < 0) {
+        AsyncWebServerResponse *response = request->beginResponse(503, "text/plain", "No frame yet");
+        response->addHeader("Retry-After", "1");
+        request->send(response);
         return;
     }
 
-    // For grayscale, create a simple BMP
-    int width = fb->width;
-    int height = fb->height;
-    int rowSize = (width + 3) & ~3;  // BMP rows must be 4-byte aligned
-    int imageSize = rowSize * height;
-    int fileSize = 54 + 256*4 + imageSize;  // Header + palette + data
-
-    // Create BMP header
-    int dataOffset = 54 + 256*4;  // 1078
-    uint8_t bmpHeader[54] = {
-        'B', 'M',                           // Signature
-        (uint8_t)(fileSize), (uint8_t)(fileSize >> 8), (uint8_t)(fileSize >> 16), (uint8_t)(fileSize >> 24),
-        0, 0, 0, 0,                         // Reserved
-        (uint8_t)(dataOffset), (uint8_t)(dataOffset >> 8), 0, 0,  // Data offset (header + palette)
-        40, 0, 0, 0,                        // Info header size
-        (uint8_t)(width), (uint8_t)(width >> 8), (uint8_t)(width >> 16), (uint8_t)(width >> 24),
-        (uint8_t)(height), (uint8_t)(height >> 8), (uint8_t)(height >> 16), (uint8_t)(height >> 24),
-        1, 0,                               // Planes
-        8, 0,                               // Bits per pixel (8 = grayscale)
-        0, 0, 0, 0,                         // Compression (none)
-        (uint8_t)(imageSize), (uint8_t)(imageSize >> 8), (uint8_t)(imageSize >> 16), (uint8_t)(imageSize >> 24),
-        0x13, 0x0B, 0, 0,                   // X pixels per meter
-        0x13, 0x0B, 0, 0,                   // Y pixels per meter
-        0, 1, 0, 0,                         // Colors used (256)
-        0, 0, 0, 0                          // Important colors
-    };
-
-    // Create grayscale palette (256 entries)
-    uint8_t palette[256 * 4];
-    for (int i = 0; i < 256; i++) {
-        palette[i * 4] = i;      // Blue
-        palette[i * 4 + 1] = i;  // Green
-        palette[i * 4 + 2] = i;  // Red
-        palette[i * 4 + 3] = 0;  // Reserved
-    }
-
-    // Send response
-    debugServer.setContentLength(fileSize);
-    debugServer.send(200, "image/bmp", "");
-
-    // Send header
-    debugServer.sendContent((const char*)bmpHeader, 54);
-
-    // Send palette
-    debugServer.sendContent((const char*)palette, 256 * 4);
-
-    // Send image data (BMP is bottom-up, so flip vertically)
-    uint8_t rowBuffer[1280];  // Max width
-    for (int y = height - 1; y >= 0; y--) {
-        memcpy(rowBuffer, fb->buf + y * width, width);
-        // Pad row to 4-byte boundary
-        for (int p = width; p < rowSize; p++) rowBuffer[p] = 0;
-        debugServer.sendContent((const char*)rowBuffer, rowSize);
-    }
-
-    esp_camera_fb_return(fb);
+    // Slot stays referenced until the client is gone
+    request->onDisconnect([slot]() { releaseFrame(slot); });
+    request->send_P(200, "image/jpeg", frameSlots[slot].jpg, frameSlots[slot].len);
 }
 
 // Handle /status - return JSON status
-void handleStatus() {
-    char json[256];
+void handleStatus(AsyncWebServerRequest *request) {
+    float idlePct, standbyPct, lightSleepPct;
+    powerResidency(&idlePct, &standbyPct, &lightSleepPct);
+
+    char json[608];
     snprintf(json, sizeof(json),
-        "{\"status\":\"OK\",\"ip\":\"%s\",\"rssi\":%d,\"width\":%d,\"height\":%d,\"heap\":%d,\"mode\":\"%s\"}",
+        "{\"status\":\"OK\",\"ip\":\"%s\",\"rssi\":%d,\"width\":%d,\"height\":%d,\"heap\":%d,\"mode\":\"%s\","
+        "\"frame\":%u,\"stream_fps\":%.1f,\"stream_clients\":%d,"
+        "\"idle_pct\":%.1f,\"light_sleep_pct\":%.1f,\"standby_pct\":%.1f,\"standby_count\":%u,\"resume_ms\":%u,\"resume_max_ms\":%u,"
+        "\"profile\":\"%s\",\"profile_switches\":%u,\"switch_ms\":%u,\"switch_max_ms\":%u,"
+        "\"framecache_stack_free\":%u,\"alloc_violations\":%u}",
         WiFi.localIP().toString().c_str(),
         WiFi.RSSI(),
-        1024, 768,  // Current resolution
+        frameWidth, frameHeight,
         ESP.getFreeHeap(),
-        modeAdd ? "IN" : "OUT"
+        modeAdd ? "IN" : "OUT",
+        frameSeq, streamFps, streamClientCount,
+        idlePct, lightSleepPct, standbyPct, cameraStandbyCount, cameraResumeMs, cameraResumeMaxMs,
+        CAM_PROFILE_NAMES[cameraProfile], cameraSwitchCount, cameraSwitchMs, cameraSwitchMaxMs,
+        frameCacheStackFree, allocViolations
     );
-    debugServer.send(200, "application/json", json);
+    request->send(200, "application/json", json);
 }
 
-// Handle /scan - perform scan and return result
-void handleDebugScan() {
-    camera_fb_t *fb = esp_camera_fb_get();
-    if (!fb) {
-        debugServer.send(500, "application/json", "{\"error\":\"Camera failed\"}");
+// Handle /scan - decode the next cached frame; answers {"pending":true,
+// "after":N} until the frame cache task has a result for frame N or newer,
+// the page polls /scan?after=N. The client carries N, so concurrent
+// viewers each wait for their own frame.
+void handleDebugScan(AsyncWebServerRequest *request) {
+    markFrameDemand(5000);
+
+    xSemaphoreTake(frameCacheMutex, portMAX_DELAY);
+    DebugScan r = debugScan;
+    uint32_t after = frameSeq + 1;
+    xSemaphoreGive(frameCacheMutex);
+
+    if (request->hasParam("after")) after = strtoul(request->getParam("after")->value().c_str(), NULL, 10);
+    if (r.seq == 0 || r.seq < after) {
+        scanRequested = true;
+        char json[48];
+        snprintf(json, sizeof(json), "{\"pending\":true,\"after\":%u}", after);
+        request->send(200, "application/json", json);
         return;
     }
 
-    // Calculate image stats
-    uint8_t minVal = 255, maxVal = 0;
-    long sum = 0;
-    for (int i = 0; i < (int)fb->len; i += 100) {
-        if (fb->buf[i] < minVal) minVal = fb->buf[i];
-        if (fb->buf[i] > maxVal) maxVal = fb->buf[i];
-        sum += fb->buf[i];
-    }
-    int brightness = sum / (fb->len / 100);
-    int contrast = maxVal - minVal;
-
-    // Try to scan
-    BarcodeResult result = scanBarcode(fb);
-    esp_camera_fb_return(fb);
-
-    char json[256];
-    if (result.found) {
+    char json[320];
+    if (r.found) {
+        char dataJson[2 * sizeof(r.data)];     // Decoded payload: quotes, control bytes
+        jsonString(dataJson, sizeof(dataJson), r.data);
         snprintf(json, sizeof(json),
-            "{\"found\":true,\"type\":\"%s\",\"data\":\"%s\",\"brightness\":%d,\"contrast\":%d}",
-            result.type.c_str(), result.data.c_str(), brightness, contrast);
+            "{\"found\":true,\"type\":\"%s\",\"data\":%s,\"brightness\":%d,\"contrast\":%d}",
+            r.type, dataJson, r.brightness, r.contrast);
     } else {
         snprintf(json, sizeof(json),
             "{\"found\":false,\"brightness\":%d,\"contrast\":%d,\"min\":%d,\"max\":%d}",
-            brightness, contrast, minVal, maxVal);
+            r.brightness, r.contrast, r.minVal, r.maxVal);
+    }
+    request->send(200, "application/json", json);
+}
+
+#ifdef ENABLE_SCAN_TRACE
+// ============ METRICS ============
+// Handlers all run in the AsyncTCP task, which is the ring's only consumer
+const float TRACE_QUANTILES[3] = { 0.5f, 0.95f, 0.99f };
+
+// Handle /metrics - Prometheus text exposition
+void handleMetrics(AsyncWebServerRequest *request) {
+    traceDrain();
+    AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+    response->print("# HELP scan_stage_seconds Scan latency per stage\n");
+    response->print("# TYPE scan_stage_seconds summary\n");
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        const TraceHistogram &h = traceHist[i];
+        for (int q = 0; q < 3; q++) {
+            response->printf("scan_stage_seconds{stage=\"%s\",quantile=\"%g\"} %.6f\n",
+                             TRACE_STAGE_NAMES[i], TRACE_QUANTILES[q],
+                             tracePercentile(h, TRACE_QUANTILES[q]) / 1e6);
+        }
+        response->printf("scan_stage_seconds_sum{stage=\"%s\"} %.6f\n", TRACE_STAGE_NAMES[i], h.sumUs / 1e6);
+        response->printf("scan_stage_seconds_count{stage=\"%s\"} %u\n", TRACE_STAGE_NAMES[i], h.count);
     }
-    debugServer.send(200, "application/json", json);
+    response->print("# TYPE scan_trace_dropped_total counter\n");
+    response->printf("scan_trace_dropped_total %u\n", traceDropped.load());
+    response->print("# HELP scan_alloc_violations_total Scan phases that allocated (alloc_check.h)\n");
+    response->print("# TYPE scan_alloc_violations_total counter\n");
+    response->printf("scan_alloc_violations_total %u\n", allocViolations);
+    request->send(response);
 }
 
+// Handle /metrics.json - same data, microseconds
+void handleMetricsJson(AsyncWebServerRequest *request) {
+    traceDrain();
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->print("{\"stages\":{");
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        const TraceHistogram &h = traceHist[i];
+        response->printf("%s\"%s\":{\"count\":%u,\"p50_us\":%u,\"p95_us\":%u,\"p99_us\":%u,\"max_us\":%u,\"mean_us\":%u}",
+                         i ? "," : "", TRACE_STAGE_NAMES[i], h.count,
+                         tracePercentile(h, 0.5f), tracePercentile(h, 0.95f), tracePercentile(h, 0.99f),
+                         h.maxUs, h.count ? (uint32_t)(h.sumUs / h.count) : 0);
+    }
+    response->printf("},\"dropped\":%u,\"alloc_violations\":%u}", traceDropped.load(), allocViolations);
+    request->send(response);
+}
+#endif
+
+#ifdef ENABLE_SELF_BENCH
+// ============ BENCHMARK ============
+// /bench?run=1 queues a run on the loop task; /bench returns the last report
+void handleBench(AsyncWebServerRequest *request) {
+    if (benchRunning) {
+        request->send(200, "application/json", "{\"running\":true}");
+        return;
+    }
+    if (request->hasParam("run")) {
+        requestSelfBench();
+        request->send(202, "application/json", "{\"pending\":true}");
+        return;
+    }
+    if (benchJson == NULL || benchJsonLen == 0) {
+        request->send(404, "application/json", "{\"error\":\"no report, use /bench?run=1\"}");
+        return;
+    }
+    request->send_P(200, "application/json", (const uint8_t *)benchJson, benchJsonLen);
+}
+#endif
+
 // Initialize debug server
 void initDebugServer() {
-    debugServer.on("/", handleRoot);
-    debugServer.on("/capture", handleCapture);
-    debugServer.on("/status", handleStatus);
-    debugServer.on("/scan", handleDebugScan);
+    frameCacheMutex = xSemaphoreCreateMutex();
+    debugDecodeMutex = xSemaphoreCreateMutex();
+
+    debugServer.on("/", HTTP_GET, handleRoot);
+    debugServer.on("/capture", HTTP_GET, handleCapture);
+    debugServer.on("/stream", HTTP_GET, handleStream);
+    debugServer.on("/status", HTTP_GET, handleStatus);
+    debugServer.on("/scan", HTTP_GET, handleDebugScan);
+#ifdef ENABLE_SCAN_TRACE
+    debugServer.on("/metrics", HTTP_GET, handleMetrics);
+    debugServer.on("/metrics.json", HTTP_GET, handleMetricsJson);
+#endif
+#ifdef ENABLE_SELF_BENCH
+    debugServer.on("/bench", HTTP_GET, handleBench);
+#endif
 
     debugServer.begin();
+    xTaskCreatePinnedToCore(frameCacheTask, "framecache", DEBUG_TASK_STACK, NULL, 1, NULL, 0);
+
     Serial.println("\n=== DEBUG SERVER ===");
     Serial.printf("http://%s/\n", WiFi.localIP().toString().c_str());
     Serial.println("====================\n");
 }
 
-// Handle client requests (call in loop)
-void handleDebugServer() {
-    debugServer.handleClient();
-}
-
 #endif
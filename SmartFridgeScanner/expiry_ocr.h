@@ -0,0 +1,477 @@
+#ifndef EXPIRY_OCR_H
+#define EXPIRY_OCR_H
+
+// On-device expiry date reader: text-region detection near the barcode,
+// character segmentation, an int8 dense classifier for digits and '/', and
+// date-pattern validation. Plain C/C++ only (no Arduino/ESP headers) so the
+// whole pipeline builds on the host for accuracy and latency benchmarks.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef OCR_MICROS
+  #if defined(ARDUINO)
+    #define OCR_MICROS() micros()
+  #else
+    #include <time.h>
+    static inline uint32_t ocrHostMicros() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+    }
+    #define OCR_MICROS() ocrHostMicros()
+  #endif
+#endif
+
+#define OCR_CELL_W        16      // Stroke-energy cell size (px)
+#define OCR_CELL_H        8
+#define OCR_MAX_CELLS_X   (1024 / OCR_CELL_W)
+#define OCR_MAX_CELLS_Y   (768 / OCR_CELL_H)
+#define OCR_MAX_REGIONS   8
+#define OCR_MAX_CHARS     24
+#define OCR_GLYPH_W       8       // Classifier input: 8x12 int8
+#define OCR_GLYPH_H       12
+#define OCR_GLYPH_SIZE    (OCR_GLYPH_W * OCR_GLYPH_H)
+#define OCR_NUM_CLASSES   11      // '0'-'9', '/'
+#define OCR_MIN_CONFIDENCE 55     // Cosine similarity x100 to accept a glyph
+
+struct OcrBox {
+    int x, y, w, h;
+};
+
+struct OcrGlyph {
+    OcrBox box;
+    char sep;  // '.', '-' when recognised from geometry, 0 for classifier glyphs
+};
+
+struct OcrRegion {
+    OcrBox box;
+    uint32_t score;  // Stroke energy, weighted by closeness to the barcode
+};
+
+struct OcrStats {
+    uint32_t detectUs, segmentUs, classifyUs, totalUs;
+    int regions;     // Candidate text regions examined
+    int glyphs;      // Glyphs classified
+    int confidence;  // Mean confidence (x100) of the accepted date
+    char text[OCR_MAX_CHARS + 1];  // Raw string of the last region read
+};
+
+// ============ GLYPH FONT (5x7, MSB = left column) ============
+// Weights of the dense layer are derived from this font at init. A trained
+// weight table with the same [class][96] int8 layout can replace it.
+const uint8_t OCR_FONT[OCR_NUM_CLASSES][7] = {
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+    {0x01, 0x01, 0x02, 0x04, 0x08, 0x10, 0x10}, // /
+};
+const char OCR_CLASS_CHARS[OCR_NUM_CLASSES + 1] = "0123456789/";
+
+// Dense layer: weights [class][input], row-major int8 (zero offsets)
+static int8_t ocrWeights[OCR_NUM_CLASSES * OCR_GLYPH_SIZE];
+static int32_t ocrWeightNorm[OCR_NUM_CLASSES];
+static bool ocrReady = false;
+
+// ============ GLYPH NORMALIZATION ============
+// Ink coverage of the glyph box resampled to 8x12, zero-mean, scaled to int8
+void ocrNormalizeGlyph(const uint8_t *pixels, int stride, const OcrBox *g, uint8_t threshold, int8_t *out) {
+    int16_t cov[OCR_GLYPH_SIZE];
+    int32_t sum = 0;
+    for (int oy = 0; oy < OCR_GLYPH_H; oy++) {
+        int y0 = g->y + oy * g->h / OCR_GLYPH_H;
+        int y1 = g->y + (oy + 1) * g->h / OCR_GLYPH_H;
+        if (y1 <= y0) y1 = y0 + 1;
+        for (int ox = 0; ox < OCR_GLYPH_W; ox++) {
+            int x0 = g->x + ox * g->w / OCR_GLYPH_W;
+            int x1 = g->x + (ox + 1) * g->w / OCR_GLYPH_W;
+            if (x1 <= x0) x1 = x0 + 1;
+            int ink = 0, n = 0;
+            for (int y = y0; y < y1; y++) {
+                const uint8_t *row = pixels + y * stride;
+                for (int x = x0; x < x1; x++) { if (row[x] < threshold) ink++; n++; }
+            }
+            cov[oy * OCR_GLYPH_W + ox] = ink * 127 / n;
+            sum += cov[oy * OCR_GLYPH_W + ox];
+        }
+    }
+    int mean = sum / OCR_GLYPH_SIZE;
+    int maxAbs = 1;
+    for (int i = 0; i < OCR_GLYPH_SIZE; i++) {
+        cov[i] -= mean;
+        if (abs(cov[i]) > maxAbs) maxAbs = abs(cov[i]);
+    }
+    for (int i = 0; i < OCR_GLYPH_SIZE; i++) out[i] = (int8_t)(cov[i] * 127 / maxAbs);
+}
+
+// Build the int8 weights by rendering each font glyph at 4x and running it
+// through the same normalization as camera glyphs
+void initExpiryOCR() {
+    if (ocrReady) return;
+    const int S = 4;
+    static uint8_t canvas[7 * S][5 * S];
+    for (int c = 0; c < OCR_NUM_CLASSES; c++) {
+        int minX = 5, maxX = -1;
+        for (int y = 0; y < 7 * S; y++) {
+            for (int x = 0; x < 5 * S; x++) {
+                bool on = OCR_FONT[c][y / S] & (0x10 >> (x / S));
+                canvas[y][x] = on ? 0 : 255;
+                if (on) { if (x / S < minX) minX = x / S; if (x / S > maxX) maxX = x / S; }
+            }
+        }
+        // Same tight bounding box a segmented camera glyph would have
+        OcrBox g = { minX * S, 0, (maxX - minX + 1) * S, 7 * S };
+        int8_t *w = ocrWeights + c * OCR_GLYPH_SIZE;
+        ocrNormalizeGlyph(&canvas[0][0], 5 * S, &g, 128, w);
+        int64_t sq = 0;
+        for (int i = 0; i < OCR_GLYPH_SIZE; i++) sq += w[i] * w[i];
+        ocrWeightNorm[c] = (int32_t)sqrtf((float)sq);
+    }
+    ocrReady = true;
+}
+
+// ============ INT8 DENSE LAYER ============
+// out[c] = sum(w[c][i] * in[i]), int32 accumulators. At 11x96 MACs per
+// glyph this is a few microseconds, so no vector kernel is needed.
+void ocrDenseS8(const int8_t *input, const int8_t *weights, int inputs, int outputs, int32_t *out) {
+    for (int c = 0; c < outputs; c++) {
+        const int8_t *w = weights + c * inputs;
+        int32_t acc = 0;
+        for (int i = 0; i < inputs; i++) acc += (int32_t)w[i] * input[i];
+        out[c] = acc;
+    }
+}
+
+// Classify a glyph box; returns the character, confidence x100 in *conf
+char ocrClassify(const uint8_t *pixels, int stride, const OcrBox *g, uint8_t threshold, int *conf) {
+    int8_t in[OCR_GLYPH_SIZE];
+    int32_t scores[OCR_NUM_CLASSES];
+    ocrNormalizeGlyph(pixels, stride, g, threshold, in);
+    ocrDenseS8(in, ocrWeights, OCR_GLYPH_SIZE, OCR_NUM_CLASSES, scores);
+
+    int64_t sq = 0;
+    for (int i = 0; i < OCR_GLYPH_SIZE; i++) sq += in[i] * in[i];
+    float inNorm = sqrtf((float)sq);
+    if (inNorm < 1) { *conf = 0; return '?'; }
+
+    int best = 0;
+    float bestCos = -1;
+    for (int c = 0; c < OCR_NUM_CLASSES; c++) {
+        float cosv = scores[c] / (inNorm * ocrWeightNorm[c]);
+        if (cosv > bestCos) { bestCos = cosv; best = c; }
+    }
+    *conf = (int)(bestCos * 100);
+    return OCR_CLASS_CHARS[best];
+}
+
+// ============ TEXT REGION DETECTION ============
+// Printed text has dense horizontal intensity changes in short bands. Cells
+// with high stroke energy are grouped into line-shaped boxes; cells over the
+// barcode (plus its human-readable digits) are excluded.
+int findTextRegions(const uint8_t *pixels, int width, int height, const OcrBox *exclude,
+                    OcrRegion *regions, int maxRegions) {
+    int cw = width / OCR_CELL_W, ch = height / OCR_CELL_H;
+    if (cw > OCR_MAX_CELLS_X) cw = OCR_MAX_CELLS_X;
+    if (ch > OCR_MAX_CELLS_Y) ch = OCR_MAX_CELLS_Y;
+
+    static uint8_t energy[OCR_MAX_CELLS_X * OCR_MAX_CELLS_Y];
+    uint16_t hist[256] = {0};
+    for (int cy = 0; cy < ch; cy++) {
+        for (int cx = 0; cx < cw; cx++) {
+            uint32_t e = 0;
+            for (int y = cy * OCR_CELL_H; y < (cy + 1) * OCR_CELL_H; y += 2) {
+                const uint8_t *row = pixels + y * width + cx * OCR_CELL_W;
+                for (int x = 0; x < OCR_CELL_W - 1; x += 2) e += abs(row[x + 1] - row[x]);
+            }
+            e /= (OCR_CELL_W / 2) * (OCR_CELL_H / 2) / 2;  // ~2x mean gradient
+            energy[cy * cw + cx] = e > 255 ? 255 : e;
+            hist[energy[cy * cw + cx]]++;
+        }
+    }
+    // Median cell energy is the frame's texture/noise level (text is sparse)
+    int median = 0;
+    for (int acc = 0; median < 255 && acc + hist[median] < cw * ch / 2; median++) acc += hist[median];
+    int active = median * 2 + 8;
+
+    // Excluded box in cells, grown by 25% vertically for the printed digits
+    int ex0 = -1, ex1 = -1, ey0 = -1, ey1 = -1;
+    if (exclude && exclude->w > 0) {
+        ex0 = exclude->x / OCR_CELL_W - 1;
+        ex1 = (exclude->x + exclude->w) / OCR_CELL_W + 1;
+        ey0 = (exclude->y - exclude->h / 8) / OCR_CELL_H - 1;
+        ey1 = (exclude->y + exclude->h + exclude->h / 4) / OCR_CELL_H + 1;
+    }
+
+    // Row-by-row run grouping into boxes (cell units), no flood-fill stack
+    struct { int x0, x1, y0, y1; uint32_t e; bool open; } boxes[32];
+    int nBoxes = 0;
+    for (int cy = 0; cy < ch; cy++) {
+        for (int b = 0; b < nBoxes; b++) if (boxes[b].y1 < cy - 1) boxes[b].open = false;
+        bool inExcl = cy >= ey0 && cy <= ey1;
+        auto on = [&](int x) {
+            return energy[cy * cw + x] >= active && !(inExcl && x >= ex0 && x <= ex1);
+        };
+        int cx = 0;
+        while (cx < cw) {
+            while (cx < cw && !on(cx)) cx++;
+            if (cx >= cw) break;
+            int r0 = cx;
+            uint32_t e = 0;
+            while (cx < cw && on(cx)) e += energy[cy * cw + cx++];
+            // Bridge one-cell gaps: wide letter spacing, separators
+            while (cx + 1 < cw && on(cx + 1)) {
+                cx++;
+                while (cx < cw && on(cx)) e += energy[cy * cw + cx++];
+            }
+            int r1 = cx - 1;
+            if (r1 == r0) continue;  // Lone cells are texture, not text
+
+            int target = -1;
+            for (int b = 0; b < nBoxes; b++) {
+                if (!boxes[b].open || boxes[b].x1 < r0 - 1 || boxes[b].x0 > r1 + 1) continue;
+                if (target < 0) { target = b; continue; }
+                // Run bridges two boxes: merge b into target
+                if (boxes[b].x0 < boxes[target].x0) boxes[target].x0 = boxes[b].x0;
+                if (boxes[b].x1 > boxes[target].x1) boxes[target].x1 = boxes[b].x1;
+                if (boxes[b].y0 < boxes[target].y0) boxes[target].y0 = boxes[b].y0;
+                boxes[target].e += boxes[b].e;
+                boxes[b].open = false;
+                boxes[b].e = 0;
+            }
+            if (target < 0) {
+                if (nBoxes >= 32) continue;
+                target = nBoxes++;
+                boxes[target].x0 = r0; boxes[target].x1 = r1;
+                boxes[target].y0 = cy; boxes[target].e = 0;
+                boxes[target].open = true;
+            }
+            if (r0 < boxes[target].x0) boxes[target].x0 = r0;
+            if (r1 > boxes[target].x1) boxes[target].x1 = r1;
+            boxes[target].y1 = cy;
+            boxes[target].e += e;
+        }
+    }
+
+    // Keep line-shaped boxes, score by energy and closeness to the barcode
+    int n = 0;
+    for (int b = 0; b < nBoxes; b++) {
+        if (boxes[b].e == 0) continue;
+        int bw = boxes[b].x1 - boxes[b].x0 + 1, bh = boxes[b].y1 - boxes[b].y0 + 1;
+        if (bw < 3 || bh > 8 || bw < bh) continue;
+
+        // One cell of margin: glyph tops/bottoms spill into weaker cells
+        OcrRegion r;
+        int x0 = boxes[b].x0 > 0 ? boxes[b].x0 - 1 : 0;
+        int y0 = boxes[b].y0 > 0 ? boxes[b].y0 - 1 : 0;
+        int x1 = boxes[b].x1 < cw - 1 ? boxes[b].x1 + 1 : cw - 1;
+        int y1 = boxes[b].y1 < ch - 1 ? boxes[b].y1 + 1 : ch - 1;
+        r.box.x = x0 * OCR_CELL_W;
+        r.box.y = y0 * OCR_CELL_H;
+        r.box.w = (x1 - x0 + 1) * OCR_CELL_W;
+        r.box.h = (y1 - y0 + 1) * OCR_CELL_H;
+        r.score = boxes[b].e;
+        if (exclude && exclude->w > 0) {
+            int dy = abs((r.box.y + r.box.h / 2) - (exclude->y + exclude->h / 2));
+            r.score = r.score * exclude->h / (exclude->h + dy);
+        }
+
+        // Insertion into the top-N list, best first
+        int pos = n < maxRegions ? n : maxRegions;
+        while (pos > 0 && regions[pos - 1].score < r.score) {
+            if (pos < maxRegions) regions[pos] = regions[pos - 1];
+            pos--;
+        }
+        if (pos < maxRegions) {
+            regions[pos] = r;
+            if (n < maxRegions) n++;
+        }
+    }
+    return n;
+}
+
+// ============ CHARACTER SEGMENTATION ============
+// Otsu over the region, ink column projection, gaps narrower than a dot-matrix
+// dot spacing are bridged. Returns the number of glyph boxes.
+int ocrSegment(const uint8_t *pixels, int width, const OcrBox *region,
+               uint8_t *threshold, OcrGlyph *glyphs, int maxGlyphs) {
+    uint32_t hist[256] = {0};
+    for (int y = region->y; y < region->y + region->h; y++) {
+        const uint8_t *row = pixels + y * width;
+        for (int x = region->x; x < region->x + region->w; x++) hist[row[x]]++;
+    }
+    uint32_t total = region->w * region->h;
+    uint64_t sumAll = 0;
+    for (int i = 0; i < 256; i++) sumAll += (uint64_t)i * hist[i];
+    uint64_t sumB = 0;
+    uint32_t wB = 0;
+    float bestVar = 0;
+    int thr = 128;
+    for (int t = 0; t < 256; t++) {
+        wB += hist[t];
+        if (wB == 0) continue;
+        uint32_t wF = total - wB;
+        if (wF == 0) break;
+        sumB += (uint64_t)t * hist[t];
+        float mB = (float)sumB / wB, mF = (float)(sumAll - sumB) / wF;
+        float var = (float)wB * wF * (mB - mF) * (mB - mF);
+        if (var > bestVar) { bestVar = var; thr = t; }
+    }
+    *threshold = thr + 1;
+
+    // Text line extent from the row projection
+    int top = -1, bottom = -1;
+    for (int y = region->y; y < region->y + region->h; y++) {
+        const uint8_t *row = pixels + y * width;
+        int ink = 0;
+        for (int x = region->x; x < region->x + region->w; x++) if (row[x] <= thr) ink++;
+        if (ink > region->w / 40 + 1) { if (top < 0) top = y; bottom = y; }
+    }
+    if (top < 0) return 0;
+    int lineH = bottom - top + 1;
+    int maxGap = lineH / 10 > 1 ? lineH / 10 : 1;  // Dot spacing < letter spacing (~lineH/7)
+
+    int n = 0, start = -1, gap = 0;
+    int xEnd = region->x + region->w;
+    for (int x = region->x; x <= xEnd; x++) {
+        bool ink = false;
+        for (int y = top; y <= bottom && x < xEnd && !ink; y++) ink = pixels[y * width + x] <= thr;
+        if (ink) {
+            if (start < 0) start = x;
+            gap = 0;
+            continue;
+        }
+        if (start < 0) continue;
+        if (++gap <= maxGap && x < xEnd) continue;
+
+        int end = x - gap;  // Last ink column
+        if (n < maxGlyphs) {
+            // Tight vertical extent of this glyph
+            int gy0 = bottom, gy1 = top;
+            for (int y = top; y <= bottom; y++) {
+                for (int xx = start; xx <= end; xx++) {
+                    if (pixels[y * width + xx] <= thr) { if (y < gy0) gy0 = y; if (y > gy1) gy1 = y; break; }
+                }
+            }
+            OcrGlyph *g = &glyphs[n++];
+            g->box.x = start; g->box.w = end - start + 1;
+            g->box.y = gy0; g->box.h = gy1 - gy0 + 1;
+            g->sep = 0;
+            // Separators are recognised from their height relative to the line
+            if (g->box.h * 3 < lineH) {
+                int mid = gy0 + g->box.h / 2;
+                g->sep = mid > top + lineH * 2 / 3 ? '.' : '-';
+            }
+        }
+        start = -1;
+        gap = 0;
+    }
+    return n;
+}
+
+// ============ DATE VALIDATION ============
+static int ocrDaysInMonth(int m, int y) {
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (m == 2 && ((y % 4 == 0 && y % 100 != 0) || y % 400 == 0)) return 29;
+    return days[m - 1];
+}
+
+// Read a run of digits at text[*i]; returns digit count
+static int ocrDigits(const char *text, int *i, int *value) {
+    int n = 0;
+    *value = 0;
+    while (text[*i] >= '0' && text[*i] <= '9') { *value = *value * 10 + (text[*i] - '0'); (*i)++; n++; }
+    return n;
+}
+
+// Accepts DD/MM/YY(YY) and MM/YY(YY) with '/', '.' or '-' separators.
+// Writes "YYYY-MM-DD" (end of month for MM/YY) into out[11].
+bool parseExpiryDate(const char *text, char *out) {
+    int len = strlen(text);
+    for (int s = 0; s < len; s++) {
+        if (text[s] < '0' || text[s] > '9' || (s > 0 && text[s - 1] >= '0' && text[s - 1] <= '9')) continue;
+        int i = s, a, b, c;
+        int na = ocrDigits(text, &i, &a);
+        char sep = text[i];
+        if (na < 1 || na > 2 || (sep != '/' && sep != '.' && sep != '-')) continue;
+        i++;
+        int nb = ocrDigits(text, &i, &b);
+        if (nb < 1 || nb > 4) continue;
+
+        int day, month, year;
+        if (nb <= 2 && text[i] == sep) {
+            i++;
+            int nc = ocrDigits(text, &i, &c);
+            if (nc != 2 && nc != 4) continue;
+            day = a; month = b; year = nc == 2 ? 2000 + c : c;
+        } else if (nb == 2 || nb == 4) {
+            month = a; year = nb == 2 ? 2000 + b : b; day = 0;
+        } else {
+            continue;
+        }
+        if (month < 1 || month > 12 || year < 2020 || year > 2045) continue;
+        if (day == 0) day = ocrDaysInMonth(month, year);
+        if (day < 1 || day > ocrDaysInMonth(month, year)) continue;
+        snprintf(out, 11, "%04d-%02d-%02d", year, month, day);
+        return true;
+    }
+    return false;
+}
+
+// ============ FULL PIPELINE ============
+// barcode: decoded symbol box (may be NULL). out receives "YYYY-MM-DD".
+bool readExpiryDate(const uint8_t *pixels, int width, int height, const OcrBox *barcode,
+                    char *out, OcrStats *stats) {
+    initExpiryOCR();
+    memset(stats, 0, sizeof(*stats));
+    uint32_t t0 = OCR_MICROS();
+
+    OcrRegion regions[OCR_MAX_REGIONS];
+    int nRegions = findTextRegions(pixels, width, height, barcode, regions, OCR_MAX_REGIONS);
+    uint32_t t1 = OCR_MICROS();
+    stats->detectUs = t1 - t0;
+
+    bool found = false;
+    for (int r = 0; r < nRegions && !found; r++) {
+        stats->regions++;
+        uint32_t ts = OCR_MICROS();
+        OcrGlyph glyphs[OCR_MAX_CHARS];
+        uint8_t thr;
+        int n = ocrSegment(pixels, width, &regions[r].box, &thr, glyphs, OCR_MAX_CHARS);
+        uint32_t tc = OCR_MICROS();
+        stats->segmentUs += tc - ts;
+
+        char text[OCR_MAX_CHARS + 1];
+        int confSum = 0, confN = 0;
+        for (int g = 0; g < n; g++) {
+            if (glyphs[g].sep) { text[g] = glyphs[g].sep; continue; }
+            int conf;
+            char c = ocrClassify(pixels, width, &glyphs[g].box, thr, &conf);
+            stats->glyphs++;
+            text[g] = conf >= OCR_MIN_CONFIDENCE ? c : '?';
+            confSum += conf; confN++;
+        }
+        text[n] = 0;
+        stats->classifyUs += OCR_MICROS() - tc;
+        memcpy(stats->text, text, n + 1);
+
+        if (parseExpiryDate(text, out)) {
+            stats->confidence = confN ? confSum / confN : 0;
+            found = true;
+        }
+    }
+    stats->totalUs = OCR_MICROS() - t0;
+    return found;
+}
+
+#endif
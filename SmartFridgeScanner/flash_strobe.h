@@ -0,0 +1,241 @@
+#ifndef FLASH_STROBE_H
+#define FLASH_STROBE_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "camera_config.h"
+#include "led_feedback.h"
+
+#if defined(ENABLE_FLASH_STROBE) && defined(BOARD_ESP32CAM)
+#define FLASH_STROBE
+#include "driver/pcnt.h"
+#endif
+
+// ============ FLASH STROBE ============
+// The OV2640 has a rolling shutter: each row is exposed for E up to its own
+// readout, the rows one after the other over the readout time R of a frame
+// period T. With E = T (manual exposure, one whole frame) every row is
+// exposing during the vertical blanking between two frames, so a pulse that
+// fits there lights the whole next frame at once. At a low fixed gain the
+// ambient light over the rest of E stays dark and the pulse sets the motion
+// blur, not E.
+//
+// VSYNC edges are counted by PCNT, which interrupts once per frame (on the
+// ESP32 the camera driver owns the pin's GPIO interrupt). The pulse starts
+// there, or from the hardware timer after STROBE_DELAY_US, and the same
+// timer ends it after STROBE_PULSE_US. Only for the scan profile's SVGA
+// readout: the UXGA readout (detail, receipt) needs more exposure lines than
+// the driver accepts, those frames keep the steady flash.
+
+#define OV2640_SVGA_FRAME_LINES 672     // 600 active + 72 blanking; exposure is counted in lines
+#define OV2640_SVGA_BLANK_LINES 72
+#define STROBE_VSYNC_UNIT       PCNT_UNIT_0
+#define STROBE_TIMER            1       // Hardware timer 1 (group 0)
+#define STROBE_WAIT_MS          300     // For the first pulse, sensor resume included
+
+bool strobeReady = false;               // PCNT and timer set up
+bool strobeActive = false;              // Current capture runs on the strobe
+unsigned long flashStartMs = 0;
+uint32_t flashStartPulses = 0;
+
+#ifdef FLASH_STROBE
+hw_timer_t *strobeTimer = NULL;
+volatile bool strobeArmed = false;
+volatile bool strobeLit = false;
+volatile uint8_t strobeSkip = 0;        // VSYNCs left before the manual exposure holds
+volatile uint32_t strobePulses = 0;
+volatile uint32_t strobePeriodUs = 0;   // Last measured VSYNC period
+volatile int64_t strobeLastVsyncUs = 0;
+volatile int64_t strobePulseVsyncUs = 0; // VSYNC that started the last pulse
+
+void IRAM_ATTR strobeTimerStart(uint32_t us) {
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 0, 0)
+    timerRestart(strobeTimer);
+    timerAlarm(strobeTimer, us, false, 0);
+#else
+    timerWrite(strobeTimer, 0);
+    timerAlarmWrite(strobeTimer, us, false);
+    timerAlarmEnable(strobeTimer);
+#endif
+}
+
+void IRAM_ATTR strobeLight() {
+    digitalWrite(FLASH_LED, HIGH);
+    strobeLit = true;
+    strobeTimerStart(STROBE_PULSE_US);
+}
+
+// Delay elapsed: light; pulse elapsed: dark
+void IRAM_ATTR strobeTimerISR() {
+    if (!strobeLit) {
+        if (strobeArmed) strobeLight();
+        return;
+    }
+    digitalWrite(FLASH_LED, LOW);
+    strobeLit = false;
+    strobePulses++;
+}
+
+void IRAM_ATTR strobeVsyncISR(void *arg) {
+    int64_t now = esp_timer_get_time();
+    if (strobeLastVsyncUs) strobePeriodUs = now - strobeLastVsyncUs;
+    strobeLastVsyncUs = now;
+    if (!strobeArmed || strobeLit) return;
+    if (strobeSkip) {
+        strobeSkip--;
+        return;
+    }
+    strobePulseVsyncUs = now;
+    if (STROBE_DELAY_US > 0) strobeTimerStart(STROBE_DELAY_US);
+    else strobeLight();
+}
+#endif
+
+void initFlashStrobe() {
+#ifdef FLASH_STROBE
+    pcnt_config_t pc = {};
+    pc.pulse_gpio_num = VSYNC_GPIO_NUM;
+    pc.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    pc.channel = PCNT_CHANNEL_0;
+    pc.unit = STROBE_VSYNC_UNIT;
+    pc.pos_mode = PCNT_COUNT_INC;       // Rising edge
+    pc.neg_mode = PCNT_COUNT_DIS;
+    pc.lctrl_mode = PCNT_MODE_KEEP;
+    pc.hctrl_mode = PCNT_MODE_KEEP;
+    pc.counter_h_lim = 1;               // Event and reset on every edge
+    pc.counter_l_lim = 0;
+    if (pcnt_unit_config(&pc) != ESP_OK) {
+        Serial.println("[STROBE] PCNT non disponibile, flash fisso");
+        return;
+    }
+    pcnt_event_enable(STROBE_VSYNC_UNIT, PCNT_EVT_H_LIM);
+    pcnt_isr_service_install(0);        // Already installed is fine
+    pcnt_isr_handler_add(STROBE_VSYNC_UNIT, strobeVsyncISR, NULL);
+    pcnt_counter_pause(STROBE_VSYNC_UNIT);  // Counts only while armed: no interrupts when idle
+
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 0, 0)
+    strobeTimer = timerBegin(1000000);
+    if (strobeTimer) timerAttachInterrupt(strobeTimer, strobeTimerISR);
+#else
+    strobeTimer = timerBegin(STROBE_TIMER, 80, true);   // 1 us ticks
+    if (strobeTimer) timerAttachInterrupt(strobeTimer, strobeTimerISR, true);
+#endif
+    if (strobeTimer == NULL) {
+        Serial.println("[STROBE] Timer non disponibile, flash fisso");
+        return;
+    }
+    strobeReady = true;
+    Serial.printf("[STROBE] Impulso %u us su VSYNC (GPIO%d)\n", STROBE_PULSE_US, VSYNC_GPIO_NUM);
+#endif
+}
+
+#ifdef FLASH_STROBE
+// Exposure for the strobe (true) or back to automatic
+bool strobeExposure(bool manual) {
+    if (!cameraLock()) return false;
+    cameraPower(true);
+    sensor_t *s = esp_camera_sensor_get();
+    bool ok = s != NULL && s->id.PID == OV2640_PID;
+    if (ok && manual) {
+        s->set_exposure_ctrl(s, 0);
+        s->set_aec2(s, 0);
+        s->set_aec_value(s, OV2640_SVGA_FRAME_LINES);
+        s->set_gain_ctrl(s, 0);
+        s->set_agc_gain(s, STROBE_GAIN);
+    } else if (ok) {
+        cameraAutoExposure(s);
+    }
+    cameraUnlock();
+    return ok;
+}
+
+void strobeDisarm() {
+    strobeArmed = false;
+    pcnt_counter_pause(STROBE_VSYNC_UNIT);
+    // A pulse in flight ends on its own within STROBE_PULSE_US
+    for (int i = 0; strobeLit && i < 10; i++) delay(1);
+    flashPinDirect(false);
+    strobeExposure(false);
+}
+
+// Returns once the first pulse under the manual exposure has fired; false
+// (nothing armed) where the strobe does not apply
+bool strobeBegin() {
+    if (!strobeReady || cameraProfile != CAM_PROFILE_SCAN || cameraConfig.frame_size > FRAMESIZE_SVGA) return false;
+    // PCNT would count a tone's edges on the shared pad as VSYNC: a tone
+    // longer than captureFlashOn() waits for keeps the steady flash
+    if (speakerTrack.playing) {
+        Serial.println("[STROBE] Speaker attivo, flash fisso");
+        return false;
+    }
+    if (!strobeExposure(true)) return false;
+
+    flashPinDirect(true);
+    uint32_t pulses = strobePulses;
+    strobeSkip = 1;                     // The frame in progress may still use the old exposure
+    strobeLastVsyncUs = 0;
+    pcnt_counter_clear(STROBE_VSYNC_UNIT);
+    pcnt_counter_resume(STROBE_VSYNC_UNIT);
+    strobeArmed = true;
+    unsigned long t0 = millis();
+    while (strobePulses == pulses && millis() - t0 < STROBE_WAIT_MS) delay(1);
+    if (strobePulses == pulses) {
+        Serial.println("[STROBE] Nessun VSYNC, flash fisso");
+        strobeDisarm();
+        return false;
+    }
+    uint32_t period = strobePeriodUs;
+    uint32_t blankUs = (uint64_t)period * OV2640_SVGA_BLANK_LINES / OV2640_SVGA_FRAME_LINES;
+    Serial.printf("[STROBE] Primo impulso dopo %lu ms, frame %u us, blanking ~%u us%s\n",
+                  millis() - t0, period, blankUs,
+                  period && STROBE_DELAY_US + STROBE_PULSE_US > blankUs ? " (impulso piu lungo!)" : "");
+    // Frames from before the first pulse are dark; half a period of margin
+    // whichever VSYNC edge the driver timestamps frames at
+    if (cameraLock()) {
+        cameraWindowAtUs = strobePulseVsyncUs - period / 2;
+        cameraUnlock();
+    }
+    return true;
+}
+#endif
+
+// ============ CAPTURE FLASH ============
+// Flash around a capture: the strobe where it applies, otherwise the steady
+// flash with BURST_SETTLE_MS for the auto exposure to settle. The speaker
+// is held for the capture; a short beep just before it (the 50 ms scan
+// beep) still plays out
+#define CAPTURE_SPEAKER_WAIT_MS 60
+
+void captureFlashOn() {
+    speakerHold(CAPTURE_SPEAKER_WAIT_MS);
+    flashStartMs = millis();
+#ifdef FLASH_STROBE
+    flashStartPulses = strobePulses;
+    strobeActive = strobeBegin();
+    if (strobeActive) return;
+#endif
+    flashOn();
+    delay(BURST_SETTLE_MS);
+}
+
+void captureFlashOff() {
+    unsigned long ms = millis() - flashStartMs;
+#ifdef FLASH_STROBE
+    if (strobeActive) {
+        strobeDisarm();
+        uint32_t pulses = strobePulses - flashStartPulses;
+        strobeActive = false;
+        Serial.printf("[STROBE] %u impulsi, flash acceso %.1f ms su %lu ms\n",
+                      pulses, pulses * STROBE_PULSE_US / 1000.0f, ms);
+        speakerResume();
+        return;
+    }
+#endif
+    flashOff();
+    speakerResume();
+    Serial.printf("[FLASH] Flash fisso acceso %lu ms\n", ms);
+}
+
+#endif
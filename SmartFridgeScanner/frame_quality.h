@@ -0,0 +1,167 @@
+#ifndef FRAME_QUALITY_H
+#define FRAME_QUALITY_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "config.h"
+#include "camera_config.h"
+#include "scan_trace.h"
+#ifdef ENABLE_SCANLINE_FUSION
+#include "scanline_fusion.h"
+#endif
+
+// ============ FRAME QUALITY ============
+// Cheap sharpness/contrast score used to pick the best frame of a burst.
+// Only FQ_ROWS rows of the centre band (where scan1DBarcode() looks) are
+// sampled, each over the middle half of the width: about 18 KB touched on
+// an XGA frame in PSRAM, well under a millisecond.
+
+#define FQ_ROWS             12      // Rows sampled across the centre band
+#define FQ_ROW_SAMPLES      128     // Pixels per sampled row
+#define FQ_MIN_CONTRAST     60      // Below this scan1DBarcode() skips the line anyway
+
+struct FrameQuality {
+    uint32_t sharpness;     // Variance of the 4-neighbour Laplacian
+    uint16_t gradient;      // Mean |dx| + |dy|
+    uint8_t contrast;       // Max - min of the samples
+    uint8_t brightness;     // Mean of the samples
+    uint32_t score;         // Sharpness, demoted when contrast is too low
+};
+
+void scoreFrame(const camera_fb_t *fb, FrameQuality *q) {
+    memset(q, 0, sizeof(*q));
+    int w = fb->width, h = fb->height;
+    if (fb->format != PIXFORMAT_GRAYSCALE || w < 8 || h < 8) return;
+
+    int x0 = w / 4, x1 = w * 3 / 4;
+    int step = max(1, (x1 - x0) / FQ_ROW_SAMPLES);
+    int y0 = h / 4, rowStep = max(1, (h / 2) / FQ_ROWS);
+    const uint8_t *buf = fb->buf;
+
+    int64_t lapSum = 0;
+    uint64_t lapSq = 0, gradSum = 0, pixSum = 0;
+    uint8_t lo = 255, hi = 0;
+    uint32_t n = 0;
+    for (int r = 0; r < FQ_ROWS; r++) {
+        const uint8_t *row = buf + (size_t)(y0 + r * rowStep) * w;
+        const uint8_t *up = row - w, *down = row + w;
+        for (int x = x0; x < x1; x += step) {
+            int c = row[x], l = row[x - 1], rt = row[x + 1], u = up[x], d = down[x];
+            int lap = 4 * c - l - rt - u - d;
+            lapSum += lap;
+            lapSq += (uint32_t)(lap * lap);
+            gradSum += abs(rt - l) + abs(d - u);
+            pixSum += c;
+            if (c < lo) lo = c;
+            if (c > hi) hi = c;
+            n++;
+        }
+    }
+    int64_t mean = lapSum / (int64_t)n;
+    q->sharpness = (uint32_t)(lapSq / n - mean * mean);
+    q->gradient = gradSum / n;
+    q->contrast = hi - lo;
+    q->brightness = pixSum / n;
+    // A washed-out or dark frame can still look "sharp" from sensor noise
+    q->score = q->contrast >= FQ_MIN_CONTRAST ? q->sharpness : q->sharpness / 16;
+}
+
+// ============ BURST CAPTURE ============
+// BURST_FRAMES frames back to back under one camera lock. With spare frame
+// buffers the BURST_DECODE sharpest are held (always leaving the driver one
+// to fill). With a single buffer nothing can be held while grabbing: the
+// first frames only measure the best score, then the next frame within
+// BURST_ACCEPT_PCT of it is kept (giving up after BURST_FRAMES more).
+
+struct CameraBurst {
+    camera_fb_t *fb[BURST_DECODE];  // Sharpest first
+    FrameQuality q[BURST_DECODE];
+    int seq[BURST_DECODE];          // Position in the burst, from 1
+    int count;                      // Frames held
+    int grabbed;
+};
+
+// Hold a scored frame in rank order; returns whatever dropped off the end
+camera_fb_t* burstInsert(CameraBurst *b, int keep, camera_fb_t *fb, const FrameQuality &q) {
+    int pos = b->count;
+    while (pos > 0 && b->q[pos - 1].score < q.score) pos--;
+    if (pos >= keep) return fb;
+    camera_fb_t *dropped = b->count == keep ? b->fb[keep - 1] : NULL;
+    int last = min(b->count, keep - 1);
+    for (int i = last; i > pos; i--) {
+        b->fb[i] = b->fb[i - 1];
+        b->q[i] = b->q[i - 1];
+        b->seq[i] = b->seq[i - 1];
+    }
+    b->fb[pos] = fb;
+    b->q[pos] = q;
+    b->seq[pos] = b->grabbed;
+    if (b->count < keep) b->count++;
+    return dropped;
+}
+
+// Frame fetch + score, traced
+camera_fb_t* burstGrab(CameraBurst *b, FrameQuality *q) {
+    camera_fb_t *fb = cameraFetchFrame();
+    if (!fb) return NULL;
+    b->grabbed++;
+    TRACE_BEGIN(tScore);
+    scoreFrame(fb, q);
+    TRACE_END(TRACE_SCORE, tScore);
+    Serial.printf("[BURST] #%d: nitidezza %u, gradiente %u, contrasto %u, luminosita %u\n",
+                  b->grabbed, q->sharpness, q->gradient, q->contrast, q->brightness);
+    #ifdef ENABLE_SCANLINE_FUSION
+    fusionAddFrame(fb);
+    #endif
+    return fb;
+}
+
+// False if no frame could be captured; otherwise burstRelease() when done
+bool burstCapture(CameraBurst *b) {
+    memset(b, 0, sizeof(*b));
+    if (!cameraLock()) return false;
+    #ifdef ENABLE_SCANLINE_FUSION
+    fusionReset();
+    #endif
+    int keep = min(BURST_DECODE, cameraFbCount - 1);
+    FrameQuality q;
+
+    if (keep > 0) {
+        for (int i = 0; i < BURST_FRAMES; i++) {
+            camera_fb_t *fb = burstGrab(b, &q);
+            if (!fb) break;
+            camera_fb_t *dropped = burstInsert(b, keep, fb, q);
+            if (dropped) esp_camera_fb_return(dropped);
+        }
+    } else {
+        uint32_t best = 0;
+        for (int i = 0; i < 2 * BURST_FRAMES - 1; i++) {
+            camera_fb_t *fb = burstGrab(b, &q);
+            if (!fb) break;
+            bool last = i == 2 * BURST_FRAMES - 2;
+            if (last || (i >= BURST_FRAMES - 1 && (uint64_t)q.score * 100 >= (uint64_t)best * BURST_ACCEPT_PCT)) {
+                burstInsert(b, 1, fb, q);
+                break;
+            }
+            best = max(best, q.score);
+            esp_camera_fb_return(fb);
+        }
+    }
+
+    if (b->count == 0) {
+        cameraUnlock();
+        return false;
+    }
+    Serial.printf("[BURST] %d frame acquisiti, da decodificare:", b->grabbed);
+    for (int i = 0; i < b->count; i++) Serial.printf(" #%d", b->seq[i]);
+    Serial.println();
+    return true;
+}
+
+void burstRelease(CameraBurst *b) {
+    for (int i = 0; i < b->count; i++) esp_camera_fb_return(b->fb[i]);
+    b->count = 0;
+    cameraUnlock();
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+#include "config.h"
+#include "camera_config.h"
+#include "power_idle.h"
+
+// ============ INPUT EVENTS ============
+// Button and PIR are interrupt driven. Edges are timestamped in the ISR,
+// a release is classified by how long the button was held and the result
+// is queued, so presses made during a (blocking) scan are handled after it.
+// loop() sleeps on the queue instead of polling.
+
+enum InputEventType : uint8_t {
+    INPUT_SCAN = 0,     // Short press
+    INPUT_TOGGLE,       // 1-3 s press
+    INPUT_RECEIPT,      // >= 3 s press
+    INPUT_PIR,          // Motion
+#ifdef ENABLE_SELF_BENCH
+    INPUT_BENCH,        // >= 8 s press or /bench?run=1
+#endif
+};
+
+struct InputEvent {
+    InputEventType type;
+    uint32_t timeMs;        // Edge time (release / PIR rising)
+    uint32_t heldMs;        // Press duration, 0 for PIR
+};
+
+#define INPUT_QUEUE_LEN 8
+
+QueueHandle_t inputQueue = NULL;
+volatile bool inputButtonDown = false;
+volatile uint32_t inputLastEdgeMs = 0;
+volatile uint32_t inputPressStartMs = 0;
+volatile uint32_t inputDropped = 0;
+int inputButtonPin = -1;
+int inputPirPin = -1;
+
+static inline uint32_t inputNowMs() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+void IRAM_ATTR inputPost(InputEventType type, uint32_t t, uint32_t held, bool fromISR) {
+    InputEvent ev = { type, t, held };
+    if(fromISR) {
+        BaseType_t woken = pdFALSE;
+        if(xQueueSendFromISR(inputQueue, &ev, &woken) != pdTRUE) inputDropped++;
+        portYIELD_FROM_ISR(woken);
+    } else if(xQueueSend(inputQueue, &ev, 0) != pdTRUE) {
+        inputDropped++;
+    }
+}
+
+// Shared edge logic: button is active LOW
+void IRAM_ATTR inputButtonEdge(bool down, bool fromISR) {
+    uint32_t t = inputNowMs();
+    if(down == inputButtonDown) return;             // Same level, bounce already filtered
+    if(t - inputLastEdgeMs < DEBOUNCE_MS) return;   // Contact bounce
+    inputLastEdgeMs = t;
+    inputButtonDown = down;
+
+    if(down) {
+        inputPressStartMs = t;
+        return;
+    }
+
+    uint32_t held = t - inputPressStartMs;
+    #ifdef ENABLE_SELF_BENCH
+    if(held >= BENCH_PRESS_MS) { inputPost(INPUT_BENCH, t, held, fromISR); return; }
+    #endif
+    if(held >= RECEIPT_PRESS_MS) inputPost(INPUT_RECEIPT, t, held, fromISR);
+    else if(held >= LONG_PRESS_MS) inputPost(INPUT_TOGGLE, t, held, fromISR);
+    else inputPost(INPUT_SCAN, t, held, fromISR);
+}
+
+void IRAM_ATTR inputButtonISR() {
+    powerWakeFiredISR(inputButtonPin);
+    inputButtonEdge(digitalRead(inputButtonPin) == LOW, true);
+}
+
+// GPIO0 doubles as XCLK on the ESP32-CAM/WROVER pinout: a CHANGE interrupt
+// there would fire on every clock edge, so sample it from a timer instead
+// and feed the same edge logic. Each sample is a one-shot that schedules the
+// next: every INPUT_POLL_MS while the sensor is awake (it blocks light sleep
+// then anyway), every INPUT_POLL_IDLE_MS while it is parked so automatic
+// light sleep can last that long. A changed level only counts once the next
+// sample, INPUT_POLL_MS later, confirms it.
+esp_timer_handle_t inputPollTimer = NULL;
+bool inputPollConfirming = false;
+#define INPUT_POLL_MS 10
+
+void inputPollCallback(void *) {
+    bool down = digitalRead(inputButtonPin) == LOW;
+    if(down != inputButtonDown && !inputPollConfirming) {
+        inputPollConfirming = true;
+    } else {
+        inputPollConfirming = false;
+        inputButtonEdge(down, false);
+    }
+    bool slow = cameraAsleep && !inputButtonDown && !inputPollConfirming;
+    esp_timer_start_once(inputPollTimer, (slow ? INPUT_POLL_IDLE_MS : INPUT_POLL_MS) * 1000);
+}
+
+#ifdef ENABLE_PIR
+void IRAM_ATTR inputPirISR() {
+    powerWakeFiredISR(inputPirPin);
+    inputPost(INPUT_PIR, inputNowMs(), 0, true);
+}
+#endif
+
+// Call after initCamera() so the pin mux of a shared XCLK pin is final
+void initInput(int buttonPin, int pirPin) {
+    inputQueue = xQueueCreate(INPUT_QUEUE_LEN, sizeof(InputEvent));
+    inputButtonPin = buttonPin;
+    inputButtonDown = (digitalRead(buttonPin) == LOW);
+
+    if(buttonPin == XCLK_GPIO_NUM) {
+        esp_timer_create_args_t args = {};
+        args.callback = inputPollCallback;
+        args.name = "input_poll";
+        esp_timer_create(&args, &inputPollTimer);
+        esp_timer_start_once(inputPollTimer, INPUT_POLL_MS * 1000);
+        Serial.printf("[INPUT] GPIO%d condiviso con XCLK, campionato ogni %d ms (%d ms in standby)\n",
+                      buttonPin, INPUT_POLL_MS, INPUT_POLL_IDLE_MS);
+    } else {
+        attachInterrupt(digitalPinToInterrupt(buttonPin), inputButtonISR, CHANGE);
+    }
+
+    #ifdef ENABLE_PIR
+        inputPirPin = pirPin;
+        pinMode(pirPin, INPUT);
+        attachInterrupt(digitalPinToInterrupt(pirPin), inputPirISR, RISING);
+    #else
+        (void)pirPin;
+    #endif
+}
+
+// Block until an event arrives or timeoutMs expires
+bool waitInputEvent(InputEvent *ev, uint32_t timeoutMs) {
+    return xQueueReceive(inputQueue, ev, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+// Event age when it is picked up, i.e. how long it waited in the queue
+uint32_t inputLatency(const InputEvent &ev) {
+    return inputNowMs() - ev.timeMs;
+}
+
+#endif
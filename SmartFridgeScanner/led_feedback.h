@@ -6,6 +6,7 @@
 #endif
 
 #include "driver/dac.h"
+#include "esp_timer.h"
 
 #if defined(BOARD_ESP32S3)
     #define FLASH_LED 48
@@ -27,6 +28,124 @@
 #define PWM_CHANNEL 2  // Use channel 2 to avoid conflict with camera (uses 0)
 #define SPEAKER_CHANNEL DAC_CHANNEL_1
 
+// ============ FEEDBACK SEQUENCER ============
+// LED and speaker patterns are queued as (value, duration) steps and played
+// in the background by one-shot esp_timers, so callers never block.
+// LED value = PWM duty, speaker value = tone frequency (0 = silence).
+// When a track runs dry it returns to its idle value (LED: mode level).
+// A held track finishes the step in progress and keeps the rest queued.
+#define FEEDBACK_QUEUE 32
+
+struct FeedbackStep {
+    uint16_t value;
+    uint16_t ms;
+};
+
+struct FeedbackTrack {
+    FeedbackStep steps[FEEDBACK_QUEUE];
+    uint8_t head;
+    uint8_t count;
+    bool playing;
+    bool held;
+    esp_timer_handle_t timer;
+    void (*apply)(uint16_t value);
+    uint16_t idleValue;
+};
+
+FeedbackTrack ledTrack, speakerTrack;
+portMUX_TYPE feedbackMux = portMUX_INITIALIZER_UNLOCKED;
+volatile bool flashOverride = false;    // Camera flash owns the LED pin
+
+void applyLed(uint16_t duty) {
+    if (!flashOverride) ledcWrite(FLASH_LED, duty);
+}
+
+void applyTone(uint16_t freq) {
+    #if SOC_DAC_SUPPORTED
+        // Hardware cosine generator: no CPU time spent per cycle
+        if (freq == 0) {
+            dac_cw_generator_disable();
+            dac_output_voltage(SPEAKER_CHANNEL, 0);
+            return;
+        }
+        dac_cw_config_t cw = {};
+        cw.en_ch = SPEAKER_CHANNEL;
+        cw.scale = DAC_CW_SCALE_2;      // Half amplitude, about the old 55..200 swing
+        cw.phase = DAC_CW_PHASE_0;
+        cw.freq = freq;
+        cw.offset = 0;
+        dac_cw_generator_config(&cw);
+        dac_cw_generator_enable();
+    #endif
+}
+
+// Start the next queued step, or fall back to idle. Runs in the caller or
+// in the esp_timer task.
+void feedbackNext(FeedbackTrack *t) {
+    FeedbackStep step;
+    bool idle;
+    portENTER_CRITICAL(&feedbackMux);
+    idle = t->count == 0 || t->held;
+    if (idle) {
+        t->playing = false;
+        step.value = t->idleValue;
+    } else {
+        step = t->steps[t->head];
+        t->head = (t->head + 1) % FEEDBACK_QUEUE;
+        t->count--;
+    }
+    portEXIT_CRITICAL(&feedbackMux);
+
+    t->apply(step.value);
+    if (!idle) esp_timer_start_once(t->timer, (uint64_t)step.ms * 1000);
+}
+
+void feedbackTimerCallback(void *arg) {
+    feedbackNext((FeedbackTrack *)arg);
+}
+
+void feedbackQueue(FeedbackTrack *t, uint16_t value, uint16_t ms) {
+    bool start = false;
+    portENTER_CRITICAL(&feedbackMux);
+    if (t->count < FEEDBACK_QUEUE) {
+        t->steps[(t->head + t->count) % FEEDBACK_QUEUE] = { value, ms };
+        t->count++;
+        if (!t->playing && !t->held) t->playing = start = true;
+    }
+    portEXIT_CRITICAL(&feedbackMux);
+    if (start) feedbackNext(t);
+}
+
+void feedbackHold(FeedbackTrack *t, bool hold) {
+    bool resume;
+    portENTER_CRITICAL(&feedbackMux);
+    t->held = hold;
+    resume = !hold && !t->playing && t->count > 0;
+    if (resume) t->playing = true;
+    portEXIT_CRITICAL(&feedbackMux);
+    if (resume) feedbackNext(t);
+}
+
+void feedbackInitTrack(FeedbackTrack *t, void (*apply)(uint16_t), const char *name) {
+    memset(t, 0, sizeof(*t));
+    t->apply = apply;
+    esp_timer_create_args_t args = {};
+    args.callback = feedbackTimerCallback;
+    args.arg = t;
+    args.name = name;
+    esp_timer_create(&args, &t->timer);
+}
+
+bool feedbackIdle() {
+    return !ledTrack.playing && !speakerTrack.playing;
+}
+
+// Wait for queued patterns to finish (only before sleep/restart)
+void feedbackFlush(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (!feedbackIdle() && millis() - start < timeoutMs) delay(10);
+}
+
 void initLED() {
     #ifdef USE_NEW_LEDC_API
         ledcAttach(FLASH_LED, 5000, 8);
@@ -40,97 +159,131 @@ void initLED() {
         dac_output_enable(SPEAKER_CHANNEL);
         dac_output_voltage(SPEAKER_CHANNEL, 0);
     #endif
+
+    feedbackInitTrack(&ledTrack, applyLed, "led");
+    feedbackInitTrack(&speakerTrack, applyTone, "speaker");
+}
+
+// Idle LED level, shown whenever no pattern is playing
+void ledSetBase(uint16_t duty) {
+    portENTER_CRITICAL(&feedbackMux);
+    ledTrack.idleValue = duty;
+    bool playing = ledTrack.playing;
+    portEXIT_CRITICAL(&feedbackMux);
+    if (!playing) applyLed(duty);
 }
 
 void ledModeIn() {
-    ledcWrite(FLASH_LED, 50);
+    ledSetBase(50);
 }
 
 void ledModeOut() {
-    ledcWrite(FLASH_LED, 200);
+    ledSetBase(200);
 }
 
 void ledGreen() {
-    ledcWrite(FLASH_LED, 50);
+    ledSetBase(50);
 }
 
 void ledRed() {
-    ledcWrite(FLASH_LED, 200);
+    ledSetBase(200);
 }
 
 void ledOff() {
-    ledcWrite(FLASH_LED, 0);
+    ledSetBase(0);
 }
 
+// Flash overrides any LED pattern until flashOff()
 void flashOn() {
+    flashOverride = true;
     ledcWrite(FLASH_LED, 255);
 }
 
 void flashOff() {
+    flashOverride = false;
     ledcWrite(FLASH_LED, 0);
+    if (!ledTrack.playing) applyLed(ledTrack.idleValue);
+}
+
+// The flash strobe (flash_strobe.h) drives the pin as a plain GPIO: a LEDC
+// duty change only lands at the next 200 us PWM period
+void flashPinDirect(bool direct) {
+    if (direct) {
+        flashOverride = true;
+        #ifdef USE_NEW_LEDC_API
+            ledcDetach(FLASH_LED);
+        #else
+            ledcDetachPin(FLASH_LED);
+        #endif
+        pinMode(FLASH_LED, OUTPUT);
+        digitalWrite(FLASH_LED, LOW);
+    } else {
+        #ifdef USE_NEW_LEDC_API
+            ledcAttach(FLASH_LED, 5000, 8);
+        #else
+            ledcAttachPin(FLASH_LED, PWM_CHANNEL);
+        #endif
+        flashOff();
+    }
+}
+
+void ledStep(uint16_t duty, uint16_t ms) {
+    feedbackQueue(&ledTrack, duty, ms);
 }
 
 void ledBlink(int times, int onTime, int offTime) {
     for(int i=0; i<times; i++) {
-        ledcWrite(FLASH_LED, 255);
-        delay(onTime);
-        ledcWrite(FLASH_LED, 0);
-        delay(offTime);
+        ledStep(255, onTime);
+        ledStep(0, offTime);
     }
 }
 
 void ledProcessing() {
-    for(int i=0; i<5; i++) {
-        ledcWrite(FLASH_LED, 255);
-        delay(100);
-        ledcWrite(FLASH_LED, 0);
-        delay(100);
-    }
+    ledBlink(5, 100, 100);
 }
 
 void ledSuccess() {
-    for(int i=0; i<3; i++) {
-        ledcWrite(FLASH_LED, 255);
-        delay(200);
-        ledcWrite(FLASH_LED, 0);
-        delay(200);
-    }
+    ledBlink(3, 200, 200);
 }
 
 void ledError() {
-    for(int i=0; i<5; i++) {
-        ledcWrite(FLASH_LED, 255);
-        delay(100);
-        ledcWrite(FLASH_LED, 0);
-        delay(100);
-    }
+    ledBlink(5, 100, 100);
 }
 
 void speakerBeep(int frequency, int duration) {
-    #if SOC_DAC_SUPPORTED
-        int halfPeriod = 1000000 / frequency / 2;
-        int cycles = (duration * 1000) / (halfPeriod * 2);
-        for(int i=0; i<cycles; i++) {
-            dac_output_voltage(SPEAKER_CHANNEL, 200);
-            delayMicroseconds(halfPeriod);
-            dac_output_voltage(SPEAKER_CHANNEL, 55);
-            delayMicroseconds(halfPeriod);
-        }
-        dac_output_voltage(SPEAKER_CHANNEL, 0);
-    #else
+    #if !SOC_DAC_SUPPORTED
         Serial.printf("Beep: %dHz, %dms\n", frequency, duration);
     #endif
+    feedbackQueue(&speakerTrack, frequency, duration);
+}
+
+void speakerRest(int duration) {
+    feedbackQueue(&speakerTrack, 0, duration);
+}
+
+// DAC channel 1 is GPIO25, the camera's VSYNC on the AI-Thinker pinout:
+// captures hold the speaker. The tone in progress may end (up to waitMs),
+// the rest of the pattern waits for speakerResume(). True once silent.
+bool speakerHold(unsigned long waitMs) {
+    feedbackHold(&speakerTrack, true);
+    unsigned long start = millis();
+    while (speakerTrack.playing && millis() - start < waitMs) delay(1);
+    return !speakerTrack.playing;
+}
+
+void speakerResume() {
+    feedbackHold(&speakerTrack, false);
 }
 
 void speakerSuccess() {
-    speakerBeep(1000, 100); delay(50);
-    speakerBeep(1500, 100); delay(50);
+    speakerBeep(1000, 100); speakerRest(50);
+    speakerBeep(1500, 100); speakerRest(50);
     speakerBeep(2000, 150);
 }
 
 void speakerError() {
-    speakerBeep(500, 200); delay(100);
-    speakerBeep(400, 200); delay(100);
+    speakerBeep(500, 200); speakerRest(100);
+    speakerBeep(400, 200); speakerRest(100);
     speakerBeep(300, 200);
 }
 
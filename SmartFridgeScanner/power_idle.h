@@ -0,0 +1,182 @@
+#ifndef POWER_IDLE_H
+#define POWER_IDLE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <driver/gpio.h>
+#include "hal/gpio_ll.h"
+#include "config.h"
+#include "camera_config.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+// ============ LIGHT-SLEEP IDLE ============
+// loop() spends idle time blocked on the input queue. With power management
+// in the IDF build (CONFIG_PM_ENABLE + tickless idle) the scheduler turns
+// that into automatic light sleep, woken by the button/PIR GPIO or the next
+// timer; WiFi stays associated in modem sleep. Handling an event holds a
+// CPU_FREQ_MAX lock so scans run exactly as fast as before. Without PM
+// support only modem sleep and the sensor standby apply.
+// Residency: the share of time loop() waited for input, the sensor was
+// parked and the chip was actually in light sleep, plus how long the sensor
+// took to deliver a fresh frame after resuming. Waiting is not sleeping
+// (timers, WiFi and the camera's PM lock keep the chip up): the light-sleep
+// share comes from the PM driver's own mode statistics, which need
+// CONFIG_PM_PROFILING in the IDF build; without it it is reported as -1.
+
+struct PowerStats {
+    uint64_t idleUs;            // loop() blocked waiting for input
+    uint32_t events;
+    int64_t sinceUs;            // Start of the measuring window
+};
+
+PowerStats powerStats;
+#if CONFIG_PM_ENABLE
+esp_pm_lock_handle_t powerCpuLock = NULL;
+#endif
+
+// Light-sleep wake. gpio_wakeup_enable() sets the same interrupt type
+// attachInterrupt() did, so a level wake left on would turn the button's
+// CHANGE and the PIR's RISING interrupt into level ones that fire for as long
+// as the level holds. Wake levels are armed only around the idle wait, on the
+// level the pin is not at, and the edge type comes back in powerIdleEnd() or,
+// when the wake fired, first thing in the pin's ISR. GPIO0 on the CAM pinout
+// carries XCLK and is sampled by the input timer instead (which wakes the
+// chip by itself).
+struct PowerWakePin {
+    int pin;
+    gpio_int_type_t edge;       // Type the input ISR runs on
+    bool bothLevels;            // Button: release wakes too; PIR: rising only
+    volatile bool armed;
+};
+
+#define POWER_WAKE_PINS 2
+PowerWakePin powerWakePins[POWER_WAKE_PINS];
+int powerWakeCount = 0;
+
+void powerAddWake(int pin, gpio_int_type_t edge, bool bothLevels) {
+    if (pin < 0 || pin == XCLK_GPIO_NUM || powerWakeCount == POWER_WAKE_PINS) return;
+    powerWakePins[powerWakeCount++] = { pin, edge, bothLevels, false };
+}
+
+void powerArmWake() {
+    for (int i = 0; i < powerWakeCount; i++) {
+        PowerWakePin &w = powerWakePins[i];
+        bool high = digitalRead(w.pin) == HIGH;
+        if (high && !w.bothLevels) continue;    // PIR pulse still high, already posted
+        w.armed = true;
+        gpio_wakeup_enable((gpio_num_t)w.pin, high ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+}
+
+void powerDisarmWake() {
+    for (int i = 0; i < powerWakeCount; i++) {
+        PowerWakePin &w = powerWakePins[i];
+        if (!w.armed) continue;
+        w.armed = false;
+        gpio_wakeup_disable((gpio_num_t)w.pin);
+        gpio_set_intr_type((gpio_num_t)w.pin, w.edge);
+    }
+}
+
+// From the input ISRs: the level that woke the chip would retrigger the ISR
+// until loop() runs, so drop back to the edge type with register writes
+void IRAM_ATTR powerWakeFiredISR(int pin) {
+    for (int i = 0; i < powerWakeCount; i++) {
+        PowerWakePin &w = powerWakePins[i];
+        if (w.pin != pin || !w.armed) continue;
+        w.armed = false;
+        gpio_ll_wakeup_disable(&GPIO, (gpio_num_t)pin);
+        gpio_ll_set_intr_type(&GPIO, (gpio_num_t)pin, w.edge);
+    }
+}
+
+void initPowerIdle(int buttonPin, int pirPin) {
+    powerStats.sinceUs = esp_timer_get_time();
+    WiFi.setSleep(true);    // Modem sleep: radio off between DTIM beacons
+
+#ifdef ENABLE_LIGHT_SLEEP
+    powerAddWake(buttonPin, GPIO_INTR_ANYEDGE, true);     // initInput(): CHANGE
+    #ifdef ENABLE_PIR
+        powerAddWake(pirPin, GPIO_INTR_POSEDGE, false);   // initInput(): RISING
+    #endif
+    esp_sleep_enable_gpio_wakeup();
+
+    #if CONFIG_PM_ENABLE
+        esp_pm_config_esp32_t pm = {};
+        pm.max_freq_mhz = 240;
+        pm.min_freq_mhz = 80;
+        pm.light_sleep_enable = true;
+        esp_err_t err = esp_pm_configure(&pm);
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "scan", &powerCpuLock);
+        Serial.printf("[POWER] Light sleep automatico: %s\n", err == ESP_OK ? "attivo" : "non supportato");
+    #else
+        Serial.println("[POWER] Build senza CONFIG_PM_ENABLE: solo modem sleep + standby sensore");
+    #endif
+#endif
+    (void)buttonPin; (void)pirPin;
+}
+
+// Around waitInputEvent(): everything outside is counted as active
+int64_t powerIdleBegin() {
+#ifdef ENABLE_LIGHT_SLEEP
+    powerArmWake();
+#endif
+    return esp_timer_get_time();
+}
+
+void powerIdleEnd(int64_t startUs) {
+#ifdef ENABLE_LIGHT_SLEEP
+    powerDisarmWake();
+#endif
+    powerStats.idleUs += esp_timer_get_time() - startUs;
+}
+
+// Around the handling of one input event: full speed, sensor awake
+void powerActive() {
+    powerStats.events++;
+#if CONFIG_PM_ENABLE
+    if (powerCpuLock) esp_pm_lock_acquire(powerCpuLock);
+#endif
+    cameraResume();
+}
+
+void powerRelease() {
+#if CONFIG_PM_ENABLE
+    if (powerCpuLock) esp_pm_lock_release(powerCpuLock);
+#endif
+}
+
+// Time spent in light sleep since boot, -1 if the build cannot tell. The PM
+// driver only prints its statistics: read the "SLEEP" row of the mode table.
+int64_t powerLightSleepUs() {
+#if CONFIG_PM_ENABLE && CONFIG_PM_PROFILING
+    static char dump[2048];
+    FILE *f = fmemopen(dump, sizeof(dump) - 1, "w");
+    if (f == NULL) return -1;
+    esp_pm_dump_locks(f);
+    long len = ftell(f);
+    fclose(f);
+    dump[max(0L, min(len, (long)sizeof(dump) - 1))] = '\0';
+    for (char *line = strstr(dump, "Mode stats:"); line; line = strchr(line + 1, '\n')) {
+        long long us;
+        if (sscanf(line, "\nSLEEP %*uM %lld", &us) == 1) return us;
+    }
+#endif
+    return -1;
+}
+
+// Percentages over the window since boot; lightSleepPct -1 when unknown
+void powerResidency(float *idlePct, float *standbyPct, float *lightSleepPct) {
+    int64_t now = esp_timer_get_time();
+    float total = (float)(now - powerStats.sinceUs);
+    uint64_t standby = cameraStandbyUs + (cameraAsleep ? now - cameraStandbySinceUs : 0);
+    int64_t sleepUs = powerLightSleepUs();
+    *idlePct = total > 0 ? 100.0f * powerStats.idleUs / total : 0;
+    *standbyPct = total > 0 ? 100.0f * standby / total : 0;
+    // PM statistics count from boot, not from initPowerIdle()
+    *lightSleepPct = sleepUs < 0 ? -1 : now > 0 ? 100.0f * sleepUs / now : 0;
+}
+
+#endif
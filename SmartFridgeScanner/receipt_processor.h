@@ -0,0 +1,257 @@
+#ifndef RECEIPT_PROCESSOR_H
+#define RECEIPT_PROCESSOR_H
+
+// Receipt preprocessing: locate the paper, estimate skew, then stream a
+// deskewed, adaptively binarized 1bpp crop row by row. Plain C/C++ only
+// (no Arduino/ESP headers) so it can be built on the host against saved frames.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#define RECEIPT_SAMPLE_STEP   4       // Subsampling for paper/skew analysis
+#define RECEIPT_TILE          32      // Adaptive threshold tile size (px)
+#define RECEIPT_MAX_TILES_X   (1600 / RECEIPT_TILE + 1)
+#define RECEIPT_MAX_TILES_Y   (1200 / RECEIPT_TILE + 1)
+#define RECEIPT_MAX_SKEW_DEG  8.0f    // Search range for skew (+/-)
+#define RECEIPT_SKEW_STEP_DEG 0.5f
+#define RECEIPT_THRESH_BIAS   15      // % below local mean that counts as ink
+#define RECEIPT_MIN_AREA_PCT  8       // Smaller bright regions are not a receipt
+#define RECEIPT_MIN_CONTRAST  48      // Paper vs. background mean, below = no paper
+#define RECEIPT_MAX_GAP       4       // Samples of ink bridged inside the paper
+
+struct ReceiptRegion {
+    bool found;
+    int x, y, w, h;          // Paper bounding box in the source frame
+    float skewDeg;           // Text rotation, positive = clockwise
+    uint8_t paperThreshold;  // Global paper/background threshold (Otsu)
+};
+
+// Row sink for the binarized output: one packed 1bpp row per call
+typedef void (*receipt_row_cb)(void *ctx, const uint8_t *row, size_t bytes);
+
+// Local mean per tile of the current region (smoothed 3x3)
+static uint8_t receiptTileMean[RECEIPT_MAX_TILES_X * RECEIPT_MAX_TILES_Y];
+static int receiptTilesX = 0, receiptTilesY = 0;
+
+// ============ OTSU THRESHOLD (subsampled) ============
+// Also returns the distance between the two class means: a frame of shelves
+// and packaging splits somewhere too, just not with paper's contrast
+uint8_t receiptOtsu(const uint8_t *pixels, int width, int height, int *separation) {
+    uint32_t hist[256] = {0};
+    uint32_t total = 0;
+    for (int y = 0; y < height; y += RECEIPT_SAMPLE_STEP) {
+        const uint8_t *row = pixels + y * width;
+        for (int x = 0; x < width; x += RECEIPT_SAMPLE_STEP) { hist[row[x]]++; total++; }
+    }
+
+    uint64_t sumAll = 0;
+    for (int i = 0; i < 256; i++) sumAll += (uint64_t)i * hist[i];
+
+    uint64_t sumB = 0;
+    uint32_t wB = 0;
+    float bestVar = 0;
+    int best = 128;
+    *separation = 0;
+    for (int t = 0; t < 256; t++) {
+        wB += hist[t];
+        if (wB == 0) continue;
+        uint32_t wF = total - wB;
+        if (wF == 0) break;
+        sumB += (uint64_t)t * hist[t];
+        float mB = (float)sumB / wB;
+        float mF = (float)(sumAll - sumB) / wF;
+        float var = (float)wB * wF * (mB - mF) * (mB - mF);
+        if (var > bestVar) { bestVar = var; best = t; *separation = (int)(mF - mB); }
+    }
+    return (uint8_t)best;
+}
+
+// Longest run of entries >= minCount, bridging up to RECEIPT_MAX_GAP entries
+// below it (a row through a text line, a column along left-aligned text);
+// returns run start, writes length
+static int receiptLongestRun(const uint16_t *counts, int n, int minCount, int *runLen) {
+    int bestStart = -1, bestLen = 0, start = -1, last = -1;
+    for (int i = 0; i <= n; i++) {
+        bool on = (i < n) && counts[i] >= minCount;
+        if (on) {
+            if (start < 0) start = i;
+            last = i;
+        } else if (start >= 0 && (i == n || i - last > RECEIPT_MAX_GAP)) {
+            if (last + 1 - start > bestLen) { bestLen = last + 1 - start; bestStart = start; }
+            start = -1;
+        }
+    }
+    *runLen = bestLen;
+    return bestStart;
+}
+
+// ============ FIND BRIGHT PAPER REGION ============
+bool findReceiptRegion(const uint8_t *pixels, int width, int height, ReceiptRegion *region) {
+    memset(region, 0, sizeof(*region));
+    int separation;
+    region->paperThreshold = receiptOtsu(pixels, width, height, &separation);
+    if (separation < RECEIPT_MIN_CONTRAST) return false;
+
+    int sw = (width + RECEIPT_SAMPLE_STEP - 1) / RECEIPT_SAMPLE_STEP;
+    int sh = (height + RECEIPT_SAMPLE_STEP - 1) / RECEIPT_SAMPLE_STEP;
+    if (sw > 400 || sh > 300) return false;
+
+    // Column projection of bright samples, then row projection inside the columns
+    uint16_t colCount[400] = {0};
+    uint16_t rowCount[300] = {0};
+    for (int sy = 0; sy < sh; sy++) {
+        const uint8_t *row = pixels + sy * RECEIPT_SAMPLE_STEP * width;
+        for (int sx = 0; sx < sw; sx++) {
+            if (row[sx * RECEIPT_SAMPLE_STEP] > region->paperThreshold) colCount[sx]++;
+        }
+    }
+    int colLen;
+    int col0 = receiptLongestRun(colCount, sw, sh * 2 / 5, &colLen);
+    if (col0 < 0) return false;
+
+    for (int sy = 0; sy < sh; sy++) {
+        const uint8_t *row = pixels + sy * RECEIPT_SAMPLE_STEP * width;
+        for (int sx = col0; sx < col0 + colLen; sx++) {
+            if (row[sx * RECEIPT_SAMPLE_STEP] > region->paperThreshold) rowCount[sy]++;
+        }
+    }
+    int rowLen;
+    int row0 = receiptLongestRun(rowCount, sh, colLen / 2, &rowLen);
+    if (row0 < 0) return false;
+
+    if (colLen * rowLen * 100 < sw * sh * RECEIPT_MIN_AREA_PCT) return false;
+
+    // Back to full resolution, one sample of margin on each side
+    region->x = (col0 > 0 ? col0 - 1 : 0) * RECEIPT_SAMPLE_STEP;
+    region->y = (row0 > 0 ? row0 - 1 : 0) * RECEIPT_SAMPLE_STEP;
+    int x1 = (col0 + colLen + 1) * RECEIPT_SAMPLE_STEP;
+    int y1 = (row0 + rowLen + 1) * RECEIPT_SAMPLE_STEP;
+    region->w = (x1 < width ? x1 : width) - region->x;
+    region->h = (y1 < height ? y1 : height) - region->y;
+    if (region->w > 1600) region->w = 1600;
+    if (region->h > 1200) region->h = 1200;
+    region->w &= ~7;  // Whole bytes per packed row
+    region->found = region->w >= 64 && region->h >= 64;
+    return region->found;
+}
+
+// ============ ADAPTIVE THRESHOLD GRID ============
+void buildReceiptTiles(const uint8_t *pixels, int width, const ReceiptRegion *region) {
+    receiptTilesX = (region->w + RECEIPT_TILE - 1) / RECEIPT_TILE;
+    receiptTilesY = (region->h + RECEIPT_TILE - 1) / RECEIPT_TILE;
+    if (receiptTilesX > RECEIPT_MAX_TILES_X) receiptTilesX = RECEIPT_MAX_TILES_X;
+    if (receiptTilesY > RECEIPT_MAX_TILES_Y) receiptTilesY = RECEIPT_MAX_TILES_Y;
+
+    static uint8_t raw[RECEIPT_MAX_TILES_X * RECEIPT_MAX_TILES_Y];
+    for (int ty = 0; ty < receiptTilesY; ty++) {
+        for (int tx = 0; tx < receiptTilesX; tx++) {
+            uint32_t sum = 0, n = 0;
+            int y1 = (ty + 1) * RECEIPT_TILE;
+            int x1 = (tx + 1) * RECEIPT_TILE;
+            if (y1 > region->h) y1 = region->h;
+            if (x1 > region->w) x1 = region->w;
+            for (int y = ty * RECEIPT_TILE; y < y1; y += 2) {
+                const uint8_t *row = pixels + (region->y + y) * width + region->x;
+                for (int x = tx * RECEIPT_TILE; x < x1; x += 2) { sum += row[x]; n++; }
+            }
+            raw[ty * receiptTilesX + tx] = n ? sum / n : 255;
+        }
+    }
+
+    // 3x3 smoothing hides tile seams without a per-pixel interpolation
+    for (int ty = 0; ty < receiptTilesY; ty++) {
+        for (int tx = 0; tx < receiptTilesX; tx++) {
+            int sum = 0, n = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    int ny = ty + dy, nx = tx + dx;
+                    if (ny < 0 || nx < 0 || ny >= receiptTilesY || nx >= receiptTilesX) continue;
+                    sum += raw[ny * receiptTilesX + nx]; n++;
+                }
+            }
+            receiptTileMean[ty * receiptTilesX + tx] = sum / n;
+        }
+    }
+}
+
+// ============ SKEW FROM TEXT-LINE PROJECTIONS ============
+// Ink samples are projected onto rows for each candidate angle; text lines
+// give the sharpest (highest energy) profile when the angle matches. A tile
+// of margin is skipped: the box corners outside a tilted sheet are dark
+// background with horizontal edges, which would pull the result towards 0.
+float estimateReceiptSkew(const uint8_t *pixels, int width, const ReceiptRegion *region) {
+    const int step = 2;
+    const int bins = region->h / step + 1;
+    const int mx = region->w >= 4 * RECEIPT_TILE ? RECEIPT_TILE : region->w / 4;
+    const int my = region->h >= 4 * RECEIPT_TILE ? RECEIPT_TILE : region->h / 4;
+    static uint16_t profile[1200 / 2 + 1];
+    if (bins > (int)(sizeof(profile) / sizeof(profile[0]))) return 0;
+
+    float bestAngle = 0;
+    uint64_t bestScore = 0;
+    for (float a = -RECEIPT_MAX_SKEW_DEG; a <= RECEIPT_MAX_SKEW_DEG + 0.01f; a += RECEIPT_SKEW_STEP_DEG) {
+        memset(profile, 0, bins * sizeof(uint16_t));
+        int slope = (int)(tanf(a * (float)M_PI / 180.0f) * 65536.0f);
+        for (int y = my; y < region->h - my; y += step) {
+            const uint8_t *row = pixels + (region->y + y) * width + region->x;
+            const uint8_t *mean = receiptTileMean + (y / RECEIPT_TILE) * receiptTilesX;
+            for (int x = mx; x < region->w - mx; x += step * 2) {
+                int limit = mean[x / RECEIPT_TILE] * (100 - RECEIPT_THRESH_BIAS) / 100;
+                if (row[x] >= limit) continue;
+                int yy = y - ((x * slope) >> 16);
+                if (yy >= 0 && yy < region->h) profile[yy / step]++;
+            }
+        }
+        uint64_t score = 0;
+        for (int i = 0; i < bins; i++) score += (uint32_t)profile[i] * profile[i];
+        if (score > bestScore) { bestScore = score; bestAngle = a; }
+    }
+    return bestAngle;
+}
+
+// Full analysis: region, tile means and skew. Returns false if no receipt found.
+bool prepareReceipt(const uint8_t *pixels, int width, int height, ReceiptRegion *region) {
+    if (!findReceiptRegion(pixels, width, height, region)) return false;
+    buildReceiptTiles(pixels, width, region);
+    region->skewDeg = estimateReceiptSkew(pixels, width, region);
+    return true;
+}
+
+// ============ DESKEW + BINARIZE + PACK (streaming) ============
+// Emits region->h rows of region->w/8 bytes, PBM convention (1 = ink).
+// Source coordinates are walked in 16.16 fixed point, no output buffer.
+void streamReceiptBits(const uint8_t *pixels, int width, int height,
+                       const ReceiptRegion *region, receipt_row_cb emit, void *ctx) {
+    static uint8_t packed[1600 / 8];
+    int rowBytes = region->w / 8;
+    float rad = region->skewDeg * (float)M_PI / 180.0f;
+    int32_t c = (int32_t)(cosf(rad) * 65536.0f);
+    int32_t s = (int32_t)(sinf(rad) * 65536.0f);
+    int cx = region->w / 2, cy = region->h / 2;
+
+    for (int oy = 0; oy < region->h; oy++) {
+        // Source of output pixel (0, oy) rotated about the region centre
+        int32_t sx = (int32_t)((region->x + cx) << 16) + (-cx) * c - (oy - cy) * s;
+        int32_t sy = (int32_t)((region->y + cy) << 16) + (-cx) * s + (oy - cy) * c;
+        memset(packed, 0, rowBytes);
+        for (int ox = 0; ox < region->w; ox++, sx += c, sy += s) {
+            int px = sx >> 16, py = sy >> 16;
+            if (px < 0 || py < 0 || px >= width || py >= height) continue;  // Off-frame = paper
+            int tx = (px - region->x) / RECEIPT_TILE, ty = (py - region->y) / RECEIPT_TILE;
+            if (tx < 0) tx = 0; else if (tx >= receiptTilesX) tx = receiptTilesX - 1;
+            if (ty < 0) ty = 0; else if (ty >= receiptTilesY) ty = receiptTilesY - 1;
+            int limit = receiptTileMean[ty * receiptTilesX + tx] * (100 - RECEIPT_THRESH_BIAS) / 100;
+            if (pixels[py * width + px] < limit) packed[ox >> 3] |= 0x80 >> (ox & 7);
+        }
+        emit(ctx, packed, rowBytes);
+    }
+}
+
+// Size in bytes of the packed 1bpp image (without PBM header)
+size_t receiptPackedSize(const ReceiptRegion *region) {
+    return (size_t)(region->w / 8) * region->h;
+}
+
+#endif
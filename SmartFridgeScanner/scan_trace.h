@@ -0,0 +1,135 @@
+#ifndef SCAN_TRACE_H
+#define SCAN_TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
+
+// ============ SCAN LATENCY TRACING ============
+// Stages of handleScan() are timed with esp_timer_get_time() and pushed as
+// spans into a lock-free single-producer/single-consumer ring. The debug
+// server drains the ring into per-stage log-bucket histograms on demand.
+// Without ENABLE_SCAN_TRACE the macros compile to nothing.
+// Remote OCR includes its own TLS connect, so spans may nest.
+
+enum TraceStage {
+    TRACE_FLASH = 0,        // Flash warm-up delay before capture
+    TRACE_CAPTURE,          // Burst capture, scoring included
+    TRACE_QR,               // scanQRCode
+    TRACE_1D,               // scan1DBarcode
+    TRACE_OCR,              // Local or remote expiry OCR
+    TRACE_TLS_CONNECT,      // TLS handshake to SERVER_HOST
+    TRACE_POST,             // Product webhook request + response after connect
+    TRACE_TOTAL,            // Whole handleScan()
+    TRACE_WAKE,             // Wake (RTC stamp, wake_timing.h) -> first decode after a PIR wake
+    TRACE_SCORE,            // scoreFrame, one span per burst frame
+    TRACE_FUSION,           // fusionAddFrame / fusionDecode
+    TRACE_STAGE_COUNT
+};
+
+const char* const TRACE_STAGE_NAMES[TRACE_STAGE_COUNT] = {
+    "flash", "capture", "qr", "1d", "ocr", "tls_connect", "post", "total", "wake", "score", "fusion"
+};
+
+#ifdef ENABLE_SCAN_TRACE
+
+#define TRACE_BEGIN(var)        int64_t var = esp_timer_get_time()
+#define TRACE_END(stage, var)   traceRecord(stage, esp_timer_get_time() - (var))
+
+#define TRACE_RING_SIZE     256     // Power of two
+#define TRACE_BUCKETS       96      // 4 buckets per octave, up to ~16 s
+
+struct TraceSpan {
+    uint8_t stage;
+    uint32_t us;
+};
+
+struct TraceHistogram {
+    uint32_t buckets[TRACE_BUCKETS];
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t maxUs;
+};
+
+TraceSpan traceRing[TRACE_RING_SIZE];
+std::atomic<uint32_t> traceHead(0);     // Written by the scanning task only
+std::atomic<uint32_t> traceTail(0);     // Written by the draining task only
+std::atomic<uint32_t> traceDropped(0);
+TraceHistogram traceHist[TRACE_STAGE_COUNT];
+TaskHandle_t traceProducer = NULL;
+
+// Call from setup(): only spans from that task (loop) are recorded, so the
+// debug server's own test scans do not pollute the production numbers
+void initScanTrace() {
+    traceProducer = xTaskGetCurrentTaskHandle();
+}
+
+void traceRecord(TraceStage stage, int64_t us) {
+    if (xTaskGetCurrentTaskHandle() != traceProducer) return;
+    uint32_t head = traceHead.load(std::memory_order_relaxed);
+    if (head - traceTail.load(std::memory_order_acquire) >= TRACE_RING_SIZE) {
+        traceDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceSpan &span = traceRing[head & (TRACE_RING_SIZE - 1)];
+    span.stage = stage;
+    span.us = us > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)us;
+    traceHead.store(head + 1, std::memory_order_release);
+}
+
+// Bucket b covers [2^(b/4) * (4 + b%4) / 4, next): ~19% resolution
+int traceBucket(uint32_t us) {
+    if (us < 4) return us;
+    int msb = 31 - __builtin_clz(us);
+    int b = msb * 4 + ((us >> (msb - 2)) & 3);
+    return b < TRACE_BUCKETS ? b : TRACE_BUCKETS - 1;
+}
+
+uint32_t traceBucketUpper(int b) {
+    if (b < 4) return b + 1;
+    int msb = b / 4;
+    return (uint32_t)((4 + b % 4 + 1) << (msb - 2));
+}
+
+// Single consumer: only call from one task (the async web server)
+void traceDrain() {
+    uint32_t tail = traceTail.load(std::memory_order_relaxed);
+    uint32_t head = traceHead.load(std::memory_order_acquire);
+    while (tail != head) {
+        const TraceSpan &span = traceRing[tail & (TRACE_RING_SIZE - 1)];
+        TraceHistogram &h = traceHist[span.stage];
+        h.buckets[traceBucket(span.us)]++;
+        h.count++;
+        h.sumUs += span.us;
+        if (span.us > h.maxUs) h.maxUs = span.us;
+        tail++;
+    }
+    traceTail.store(tail, std::memory_order_release);
+}
+
+// Upper bound of the bucket holding quantile q (0..1), 0 if empty
+uint32_t tracePercentile(const TraceHistogram &h, float q) {
+    if (h.count == 0) return 0;
+    uint32_t rank = (uint32_t)(q * h.count + 0.5f);
+    if (rank < 1) rank = 1;
+    uint32_t seen = 0;
+    for (int b = 0; b < TRACE_BUCKETS; b++) {
+        seen += h.buckets[b];
+        if (seen >= rank) {
+            uint32_t upper = traceBucketUpper(b);
+            return upper < h.maxUs ? upper : h.maxUs;
+        }
+    }
+    return h.maxUs;
+}
+
+#else
+
+#define TRACE_BEGIN(var)
+#define TRACE_END(stage, var)
+
+inline void initScanTrace() {}
+
+#endif
+
+#endif
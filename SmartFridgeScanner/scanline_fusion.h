@@ -0,0 +1,168 @@
+#ifndef SCANLINE_FUSION_H
+#define SCANLINE_FUSION_H
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "config.h"
+#include "scan_trace.h"
+#include "barcode_scanner.h"
+
+// ============ SCANLINE FUSION ============
+// Low light leaves single scanlines too noisy for the EAN checksum. As burst
+// frames arrive, each of FUSION_LINES bands (FUSION_BAND_ROWS rows averaged
+// into one profile) is aligned to the running mean of the same band with a
+// zero-mean 1D cross-correlation (+/- FUSION_MAX_SHIFT px, quarter-pixel
+// parabolic refinement) and added to it. Bars are vertical, so vertical hand
+// motion only moves the band along the bars. fusionDecode() contrast-stretches
+// the averaged profiles and hands them to scan1DLine().
+// Scratch lives in the scanner arena (scanWork.fusion*).
+
+static_assert(FUSION_LINES <= 5, "fusionLineY() has five bands");
+
+#define FUSION_MIN_NCC      0.5f    // Weaker match = band left the code, frame not added
+#define FUSION_MIN_RANGE    12      // Fused profile span below this is not worth decoding
+
+struct ScanlineFusion {
+    int width, height;
+    int frames;                         // Frames offered since fusionReset()
+    uint8_t lineFrames[FUSION_LINES];   // Frames accumulated per band
+    int16_t lastShift[FUSION_LINES];    // Quarter pixels, for the log
+};
+
+ScanlineFusion fusion = {};
+
+// Centre-weighted subset of scan1DBarcode()'s lines
+int fusionLineY(int i, int h) {
+    static const uint8_t NUM[] = { 1, 1, 2, 5, 7 }, DEN[] = { 2, 3, 3, 12, 12 };
+    return h * NUM[i] / DEN[i];
+}
+
+void fusionReset() {
+    fusion.width = fusion.height = 0;
+    fusion.frames = 0;
+    memset(fusion.lineFrames, 0, sizeof(fusion.lineFrames));
+}
+
+// Mean of the band's rows into scanWork.fusionLine
+void fusionProfile(const camera_fb_t *fb, int y) {
+    int w = fb->width;
+    int y0 = constrain(y - FUSION_BAND_ROWS / 2, 0, (int)fb->height - FUSION_BAND_ROWS);
+    const uint8_t *row = fb->buf + (size_t)y0 * w;
+    for (int x = 0; x < w; x++) {
+        int sum = 0;
+        for (int r = 0; r < FUSION_BAND_ROWS; r++) sum += row[r * w + x];
+        scanWork.fusionLine[x] = sum / FUSION_BAND_ROWS;
+    }
+}
+
+// Best shift of the new profile against the band's running mean, in
+// quarter pixels; false if the two do not look like the same code
+bool fusionAlign(const uint16_t *acc, int frames, int w, int *shiftQ) {
+    const uint8_t *cur = scanWork.fusionLine;
+    int16_t *ref = scanWork.fusionRef;
+    int x0 = FUSION_MAX_SHIFT + 1, x1 = w - FUSION_MAX_SHIFT - 1;
+
+    int32_t refSum = 0, curSum = 0;
+    for (int x = 0; x < w; x++) {
+        ref[x] = acc[x] / frames;
+        refSum += ref[x];
+        curSum += cur[x];
+    }
+    int refMean = refSum / w, curMean = curSum / w;
+    int64_t refEnergy = 0, curEnergy = 0;
+    for (int x = 0; x < w; x++) ref[x] -= refMean;
+    for (int x = x0; x < x1; x++) {
+        int c = cur[x] - curMean;
+        refEnergy += ref[x] * ref[x];
+        curEnergy += c * c;
+    }
+    if (refEnergy == 0 || curEnergy == 0) return false;
+
+    int32_t corr[2 * FUSION_MAX_SHIFT + 1];
+    int best = 0;
+    for (int s = -FUSION_MAX_SHIFT; s <= FUSION_MAX_SHIFT; s++) {
+        int32_t sum = 0;
+        const uint8_t *c = cur + s;
+        for (int x = x0; x < x1; x++) sum += ref[x] * (c[x] - curMean);
+        corr[s + FUSION_MAX_SHIFT] = sum;
+        if (sum > corr[best]) best = s + FUSION_MAX_SHIFT;
+    }
+    float ncc = corr[best] / sqrtf((float)refEnergy * (float)curEnergy);
+    if (ncc < FUSION_MIN_NCC) return false;
+
+    int q = 0;
+    if (best > 0 && best < 2 * FUSION_MAX_SHIFT) {
+        float cm = corr[best - 1], c0 = corr[best], cp = corr[best + 1];
+        float den = cm - 2 * c0 + cp;
+        if (den < 0) q = constrain((int)lroundf(2 * (cm - cp) / den), -2, 2);
+    }
+    *shiftQ = (best - FUSION_MAX_SHIFT) * 4 + q;
+    return true;
+}
+
+// Add one frame's bands; cheap enough to run between burst frames
+void fusionAddFrame(const camera_fb_t *fb) {
+    if (scanWork.fusionAcc == NULL || fb->format != PIXFORMAT_GRAYSCALE) return;
+    if (fusion.frames >= FUSION_FRAMES || (int)fb->width > scanWork.lineCapacity) return;
+    if (fusion.frames == 0) {
+        fusion.width = fb->width;
+        fusion.height = fb->height;
+    } else if ((int)fb->width != fusion.width || (int)fb->height != fusion.height) {
+        return;
+    }
+    TRACE_BEGIN(tFusion);
+    int w = fusion.width;
+    for (int i = 0; i < FUSION_LINES; i++) {
+        uint16_t *acc = scanWork.fusionAcc + i * w;
+        fusionProfile(fb, fusionLineY(i, fusion.height));
+        const uint8_t *cur = scanWork.fusionLine;
+        if (fusion.lineFrames[i] == 0) {
+            for (int x = 0; x < w; x++) acc[x] = cur[x];
+            fusion.lineFrames[i] = 1;
+            fusion.lastShift[i] = 0;
+            continue;
+        }
+        int q;
+        if (!fusionAlign(acc, fusion.lineFrames[i], w, &q)) continue;
+        // Linear interpolation at the quarter-pixel offset, edges clamped
+        int whole = q >> 2, frac = q & 3;
+        for (int x = 0; x < w; x++) {
+            int xi = constrain(x + whole, 0, w - 2);
+            acc[x] += (cur[xi] * (4 - frac) + cur[xi + 1] * frac + 2) >> 2;
+        }
+        fusion.lineFrames[i]++;
+        fusion.lastShift[i] = q;
+    }
+    fusion.frames++;
+    TRACE_END(TRACE_FUSION, tFusion);
+}
+
+// Decode the averaged bands that have at least minFrames frames
+BarcodeResult fusionDecode(int minFrames = 2) {
+    BarcodeResult result = {};
+    if (scanWork.fusionAcc == NULL || fusion.frames < minFrames) return result;
+    TRACE_BEGIN(tFusion);
+    int w = fusion.width;
+    uint8_t *line = scanWork.fusionLine;
+    for (int i = 0; i < FUSION_LINES && !result.found; i++) {
+        int n = fusion.lineFrames[i];
+        if (n < minFrames || n == 0) continue;
+        const uint16_t *acc = scanWork.fusionAcc + i * w;
+        int lo = 255 * FUSION_FRAMES, hi = 0;
+        for (int x = 0; x < w; x++) {
+            lo = min(lo, (int)acc[x]);
+            hi = max(hi, (int)acc[x]);
+        }
+        if ((hi - lo) / n < FUSION_MIN_RANGE) continue;
+        // Stretch to full range: averaging left less noise than contrast
+        for (int x = 0; x < w; x++) line[x] = (acc[x] - lo) * 255 / (hi - lo);
+        int y = fusionLineY(i, fusion.height);
+        result = scan1DLine(line, w, y);
+        Serial.printf("[FUSION] Riga %d: %d frame, ultimo spostamento %.2f px, escursione %d%s\n",
+                      y, n, fusion.lastShift[i] / 4.0f, (hi - lo) / n, result.found ? " -> letto" : "");
+    }
+    TRACE_END(TRACE_FUSION, tFusion);
+    return result;
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SCANNER_ARENA_H
+#define SCANNER_ARENA_H
+
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+
+// ============ SCANNER WORKSPACE ARENA ============
+// One block carved at boot (PSRAM when the camera uses it, DRAM otherwise)
+// holds all decoder scratch. Nothing is ever freed, so memory use is fixed
+// after setup() and the scan path makes no allocator calls.
+
+#define ARENA_OCR_STRIP_BYTES   (24 * 1024)     // Remote OCR crop strip
+
+struct ScannerArena {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    bool inPsram;
+};
+
+ScannerArena scannerArena = { NULL, 0, 0, false };
+
+bool initScannerArena(size_t size, bool psram) {
+    uint32_t caps = psram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    scannerArena.base = (uint8_t *)heap_caps_malloc(size, caps);
+    if (scannerArena.base == NULL && psram) {
+        // PSRAM exhausted or missing: fall back to internal RAM
+        caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+        scannerArena.base = (uint8_t *)heap_caps_malloc(size, caps);
+        psram = false;
+    }
+    if (scannerArena.base == NULL) {
+        Serial.printf("[ARENA] Allocazione %u bytes fallita\n", size);
+        return false;
+    }
+    scannerArena.size = size;
+    scannerArena.used = 0;
+    scannerArena.inPsram = psram;
+    Serial.printf("[ARENA] %u bytes in %s\n", size, psram ? "PSRAM" : "DRAM");
+    return true;
+}
+
+// Carve a zeroed, aligned slice; only call during init
+void* arenaAlloc(size_t bytes, size_t align = 4) {
+    size_t offset = (scannerArena.used + align - 1) & ~(align - 1);
+    if (scannerArena.base == NULL || offset + bytes > scannerArena.size) {
+        Serial.printf("[ARENA] Spazio esaurito (%u + %u > %u)\n", offset, bytes, scannerArena.size);
+        return NULL;
+    }
+    scannerArena.used = offset + bytes;
+    memset(scannerArena.base + offset, 0, bytes);
+    return scannerArena.base + offset;
+}
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef SELF_BENCH_H
+#define SELF_BENCH_H
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include "esp_heap_caps.h"
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(3, 0, 0)
+#include <esp_memory_utils.h>
+typedef esp_partition_mmap_handle_t bench_map_t;
+#define BENCH_MMAP_DATA ESP_PARTITION_MMAP_DATA
+#define benchUnmap esp_partition_munmap
+#else
+#include <soc/soc_memory_layout.h>
+typedef spi_flash_mmap_handle_t bench_map_t;
+#define BENCH_MMAP_DATA SPI_FLASH_MMAP_DATA
+#define benchUnmap spi_flash_munmap
+#endif
+#include "config.h"
+#include "camera_config.h"
+#include "barcode_scanner.h"
+#include "input_events.h"
+
+// ============ SELF BENCHMARK ============
+// Decodes reference frames from the "benchframes" flash partition (image
+// built by tools/bench_partition.py) and times scanBarcode(), scan1DBarcode()
+// and scanQRCode() with the CPU cycle counter. Each frame is decoded straight
+// from memory-mapped flash, then from a copy in internal RAM and in PSRAM,
+// so cache misses and external RAM latency show up as separate numbers.
+// "scan" includes the scanner's serial logging, like in production.
+// Frames of any size up to the scanner's line width run: quirc is sized for
+// each frame before timing and put back to the profile sizes afterwards.
+
+#define BENCH_PARTITION_LABEL   "benchframes"
+#define BENCH_PARTITION_SUBTYPE 0x40
+#define BENCH_MAGIC             0x46424653      // "SFBF" little endian
+#define BENCH_VERSION           1
+#define BENCH_REPEAT            5
+#define BENCH_MAX_FRAMES        16
+#define BENCH_JSON_BYTES        12288
+#define BENCH_FRAME_JSON_MAX    1024            // Room one frame's results may take
+
+// Partition layout: header, entry table, then 4-byte aligned 8-bit frames
+struct BenchHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+};
+
+struct BenchEntry {
+    uint16_t width, height;
+    uint32_t offset;            // From the partition start
+    uint32_t length;
+    char expected[48];          // Decoded text, "" = no symbol expected
+};
+
+enum BenchStage { BENCH_SCAN, BENCH_1D, BENCH_QR, BENCH_STAGE_COUNT };
+const char* const BENCH_STAGE_NAMES[BENCH_STAGE_COUNT] = { "scan", "1d", "qr" };
+
+enum BenchPlace { BENCH_FLASH, BENCH_DRAM, BENCH_PSRAM, BENCH_PLACE_COUNT };
+const char* const BENCH_PLACE_NAMES[BENCH_PLACE_COUNT] = { "flash", "dram", "psram" };
+
+char *benchJson = NULL;             // Last report, served on /bench
+size_t benchJsonLen = 0;
+volatile bool benchRunning = false;
+
+// Ask loop() to run the benchmark (debug server, any task)
+void requestSelfBench() {
+    inputPost(INPUT_BENCH, inputNowMs(), 0, false);
+}
+
+void benchAppend(const char *fmt, ...) {
+    if (benchJsonLen >= BENCH_JSON_BYTES - 1) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(benchJson + benchJsonLen, BENCH_JSON_BYTES - benchJsonLen, fmt, args);
+    va_end(args);
+    if (n > 0) benchJsonLen = min(benchJsonLen + n, (size_t)BENCH_JSON_BYTES - 1);
+}
+
+// Where code or data lives, to check IRAM/DRAM placement of hot paths
+const char* benchWhere(const void *p) {
+    if (esp_ptr_in_iram(p)) return "iram";
+    if (esp_ptr_in_dram(p)) return "dram";
+    if (esp_ptr_external_ram(p)) return "psram";
+    return "flash";
+}
+
+// UPC-A may come back as the equivalent EAN-13 with a leading 0
+bool benchMatches(const char *expected, const BarcodeResult &r) {
+    if (!r.found) return expected[0] == '\0';
+    if (strcmp(expected, r.data) == 0) return true;
+    return strlen(expected) == 12 && r.data[0] == '0' && strcmp(expected, r.data + 1) == 0;
+}
+
+// Time one stage BENCH_REPEAT times: first run, fastest run, mean
+void benchStage(BenchStage stage, camera_fb_t *fb, BarcodeResult *last) {
+    uint32_t first = 0, best = UINT32_MAX;
+    uint64_t sum = 0;
+    for (int i = 0; i < BENCH_REPEAT; i++) {
+        uint32_t c0 = ESP.getCycleCount();
+        BarcodeResult r;
+        switch (stage) {
+            case BENCH_SCAN: r = scanBarcode(fb); break;
+            case BENCH_1D:   r = scan1DBarcode(fb); break;
+            default:         r = scanQRCode(fb); break;
+        }
+        uint32_t cycles = ESP.getCycleCount() - c0;
+        if (i == 0) first = cycles;
+        best = min(best, cycles);
+        sum += cycles;
+        if (stage == BENCH_SCAN) *last = r;
+    }
+    benchAppend("%s\"%s\":{\"first\":%u,\"min\":%u,\"avg\":%u}", stage ? "," : "",
+                BENCH_STAGE_NAMES[stage], first, best, (uint32_t)(sum / BENCH_REPEAT));
+}
+
+// Run all stages on one copy of a frame; buf == NULL reports the reason
+void benchPlace(BenchPlace place, uint8_t *buf, const BenchEntry &e, const char *why, BarcodeResult *last) {
+    benchAppend("%s\"%s\":", place ? "," : "", BENCH_PLACE_NAMES[place]);
+    if (buf == NULL) {
+        benchAppend("{\"skipped\":\"%s\"}", why);
+        return;
+    }
+    camera_fb_t fb = {};
+    fb.buf = buf;
+    fb.len = e.length;
+    fb.width = e.width;
+    fb.height = e.height;
+    fb.format = PIXFORMAT_GRAYSCALE;
+    benchAppend("{\"at\":\"%s\",", benchWhere(buf));
+    for (int s = 0; s < BENCH_STAGE_COUNT; s++) benchStage((BenchStage)s, &fb, last);
+    benchAppend("}");
+}
+
+void runSelfBench() {
+    Serial.println("\n==== BENCHMARK ====");
+    benchRunning = true;
+    unsigned long t0 = millis();
+
+    if (benchJson == NULL) {
+        uint32_t caps = psramFound() ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL;
+        benchJson = (char *)heap_caps_malloc(BENCH_JSON_BYTES, caps | MALLOC_CAP_8BIT);
+        if (benchJson == NULL) {
+            Serial.println("[BENCH] Memoria insufficiente per il report");
+            benchRunning = false;
+            return;
+        }
+    }
+    benchJsonLen = 0;
+    benchJson[0] = '\0';
+
+    const esp_partition_t *part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)BENCH_PARTITION_SUBTYPE, BENCH_PARTITION_LABEL);
+    const uint8_t *base = NULL;
+    bench_map_t map = 0;
+    if (part == NULL ||
+        esp_partition_mmap(part, 0, part->size, BENCH_MMAP_DATA, (const void **)&base, &map) != ESP_OK) {
+        Serial.println("[BENCH] Partizione " BENCH_PARTITION_LABEL " assente");
+        benchAppend("{\"error\":\"no " BENCH_PARTITION_LABEL " partition\"}");
+        benchRunning = false;
+        return;
+    }
+    const BenchHeader *hdr = (const BenchHeader *)base;
+    const BenchEntry *entries = (const BenchEntry *)(base + sizeof(BenchHeader));
+    if (hdr->magic != BENCH_MAGIC || hdr->version != BENCH_VERSION) {
+        Serial.println("[BENCH] Partizione senza frame di riferimento");
+        benchAppend("{\"error\":\"bad partition header\"}");
+        benchUnmap(map);
+        benchRunning = false;
+        return;
+    }
+
+    benchAppend("{\"board\":\"%s\",\"cpu_mhz\":%u,\"frame\":\"%dx%d\",\"repeat\":%d,",
+                BOARD_NAME, getCpuFrequencyMhz(), cameraFrameWidth, cameraFrameHeight, BENCH_REPEAT);
+    benchAppend("\"placement\":{\"scanBarcode\":\"%s\",\"scan1DBarcode\":\"%s\",\"scanQRCode\":\"%s\","
+                "\"readPattern\":\"%s\",\"decodeDigit\":\"%s\",\"quirc_end\":\"%s\",\"ean_tables\":\"%s\",\"arena\":\"%s\"},",
+                benchWhere((const void *)scanBarcode), benchWhere((const void *)scan1DBarcode),
+                benchWhere((const void *)scanQRCode), benchWhere((const void *)readPattern),
+                benchWhere((const void *)decodeDigit), benchWhere((const void *)quirc_end),
+                benchWhere(EAN_L), scannerArena.base ? benchWhere(scannerArena.base) : "none");
+    benchAppend("\"frames\":[");
+
+    int run = 0, ok = 0, skipped = 0;
+    bool truncated = false;
+    QrInstance qrSaved = qrInstanceCount ? qrInstances[0] : QrInstance{};
+    int count = min((int)hdr->count, BENCH_MAX_FRAMES);
+    for (int i = 0; i < count; i++) {
+        if (benchJsonLen > BENCH_JSON_BYTES - BENCH_FRAME_JSON_MAX) {
+            truncated = true;
+            break;
+        }
+        BenchEntry e = entries[i];
+        e.expected[sizeof(e.expected) - 1] = '\0';
+        // 1D needs the row to fit the scanner's line buffer
+        if (e.width > scanWork.lineCapacity ||
+            e.length != (uint32_t)e.width * e.height || e.offset + e.length > part->size) {
+            Serial.printf("[BENCH] Frame %d saltato: %dx%d, riga massima %d\n", i, e.width, e.height, scanWork.lineCapacity);
+            skipped++;
+            continue;
+        }
+        // Size quirc for this frame outside the timed runs
+        qrFor(e.width, e.height);
+        const uint8_t *src = base + e.offset;
+        BarcodeResult last = {};
+
+        benchAppend("%s{\"index\":%d,\"size\":\"%dx%d\",\"expected\":\"%s\",\"runs\":{",
+                    run ? "," : "", i, e.width, e.height, e.expected);
+        benchPlace(BENCH_FLASH, (uint8_t *)src, e, NULL, &last);
+
+        // Internal RAM rarely has a whole frame free: fall back to the
+        // camera's own buffer when the driver keeps it in DRAM
+        uint8_t *dram = (uint8_t *)heap_caps_malloc(e.length, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        camera_fb_t *camFb = NULL;
+        if (dram == NULL && !cameraInPsram) {
+            camFb = cameraGetFrame(pdMS_TO_TICKS(1000));
+            if (camFb && camFb->len >= e.length) dram = camFb->buf;
+        }
+        if (dram) memcpy(dram, src, e.length);
+        benchPlace(BENCH_DRAM, dram, e, "no memory", &last);
+        if (camFb) cameraReturnFrame(camFb);
+        else heap_caps_free(dram);
+
+        uint8_t *psram = psramFound() ? (uint8_t *)heap_caps_malloc(e.length, MALLOC_CAP_SPIRAM) : NULL;
+        if (psram) memcpy(psram, src, e.length);
+        benchPlace(BENCH_PSRAM, psram, e, psramFound() ? "no memory" : "no psram", &last);
+        heap_caps_free(psram);
+
+        bool good = benchMatches(e.expected, last);
+        benchAppend("},\"decoded\":\"%s\",\"ok\":%s}", last.found ? last.data : "", good ? "true" : "false");
+        run++;
+        if (good) ok++;
+        Serial.printf("[BENCH] Frame %d: %s\n", i, good ? "OK" : "ERRATO");
+    }
+    benchUnmap(map);
+    if (qrInstanceCount && (qrInstances[0].width != qrSaved.width || qrInstances[0].height != qrSaved.height)) {
+        qrResize(qrInstances[0], qrSaved.width, qrSaved.height);
+    }
+
+    unsigned long ms = millis() - t0;
+    benchAppend("],\"run\":%d,\"ok\":%d,\"skipped\":%d,\"ms\":%lu,\"truncated\":%s}",
+                run, ok, skipped, ms, truncated ? "true" : "false");
+    Serial.printf("[BENCH] %d frame, %d corretti, %d saltati, %lu ms\n", run, ok, skipped, ms);
+    Serial.println(benchJson);
+    Serial.println("===================\n");
+    benchRunning = false;
+}
+
+#endif
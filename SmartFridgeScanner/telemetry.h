@@ -0,0 +1,161 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include "barcode_scanner.h"
+#include "api_client.h"
+#include "alloc_check.h"
+
+extern int bootCount;
+extern const char* BOARD_NAME;
+
+// ============ FLEET TELEMETRY ============
+// Counters accumulate between reports and are reset once the server has
+// accepted them, so each report carries deltas for its interval.
+
+enum TelemetrySymbology { SYM_QR = 0, SYM_EAN13, SYM_EAN8, SYM_UPCA, SYM_COUNT };
+const char* const SYM_NAMES[SYM_COUNT] = { "QR", "EAN13", "EAN8", "UPCA" };
+
+// Decode time bucket upper bounds (ms), last bucket is open-ended
+#define DECODE_BUCKETS 8
+const uint16_t DECODE_BUCKET_MS[DECODE_BUCKETS - 1] = { 25, 50, 100, 200, 400, 800, 1600 };
+
+struct TelemetryCounters {
+    uint32_t scans;
+    uint32_t attempts[SYM_COUNT];
+    uint32_t successes[SYM_COUNT];
+    uint32_t decodeHist[DECODE_BUCKETS];
+    uint32_t tlsCount, tlsFailures, tlsTotalMs, tlsMaxMs;   // Snapshot of tlsStats at last report
+    uint32_t allocViolations;   // Snapshot of allocViolations at last report
+    uint32_t wakeMs;        // Wake -> first decode of this boot (wake_timing.h), 0 if not a PIR wake
+};
+
+TelemetryCounters telemetry;
+unsigned long lastTelemetry = 0;
+
+// Record one production decode: QR is always tried, 1D only if QR failed
+void telemetryNoteScan(const BarcodeResult &result, uint32_t decodeMs) {
+    telemetry.scans++;
+    telemetry.attempts[SYM_QR]++;
+    bool qr = result.found && strcmp(result.type, "QR") == 0;
+    if(qr) {
+        telemetry.successes[SYM_QR]++;
+    } else {
+        for(int i = SYM_EAN13; i < SYM_COUNT; i++) telemetry.attempts[i]++;
+        for(int i = SYM_EAN13; i < SYM_COUNT && result.found; i++) {
+            if(strcmp(result.type, SYM_NAMES[i]) == 0) telemetry.successes[i]++;
+        }
+    }
+
+    int b = 0;
+    while(b < DECODE_BUCKETS - 1 && decodeMs > DECODE_BUCKET_MS[b]) b++;
+    telemetry.decodeHist[b]++;
+}
+
+const char* resetReasonName(esp_reset_reason_t r) {
+    switch(r) {
+        case ESP_RST_POWERON:   return "POWERON";
+        case ESP_RST_EXT:       return "EXT";
+        case ESP_RST_SW:        return "SW";
+        case ESP_RST_PANIC:     return "PANIC";
+        case ESP_RST_INT_WDT:   return "INT_WDT";
+        case ESP_RST_TASK_WDT:  return "TASK_WDT";
+        case ESP_RST_WDT:       return "WDT";
+        case ESP_RST_DEEPSLEEP: return "DEEPSLEEP";
+        case ESP_RST_BROWNOUT:  return "BROWNOUT";
+        case ESP_RST_SDIO:      return "SDIO";
+        default:                return "UNKNOWN";
+    }
+}
+
+// Build the compact JSON report, returns its length
+int buildTelemetry(char *out, size_t size) {
+    uint64_t mac = ESP.getEfuseMac();
+    int n = snprintf(out, size,
+        "{\"device\":\"%s\",\"id\":\"%04X%08X\",\"boot\":%d,\"uptime\":%lu,\"reset\":\"%s\","
+        "\"rssi\":%d,\"heap\":%u,\"heap_min\":%u,\"heap_largest\":%u,\"psram\":%u,\"psram_free\":%u,"
+        "\"tls\":[%u,%u,%u,%u],\"scans\":%u,\"alloc_violations\":%u,\"sym\":{",
+        BOARD_NAME, (uint16_t)(mac >> 32), (uint32_t)mac, bootCount, millis() / 1000,
+        resetReasonName(esp_reset_reason()), WiFi.RSSI(),
+        ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap(),
+        ESP.getPsramSize(), ESP.getFreePsram(),
+        tlsStats.count - telemetry.tlsCount, tlsStats.failures - telemetry.tlsFailures,
+        tlsStats.totalMs - telemetry.tlsTotalMs, tlsStats.maxMs,
+        telemetry.scans, allocViolations - telemetry.allocViolations);
+    for(int i = 0; i < SYM_COUNT && n < (int)size; i++) {
+        n += snprintf(out + n, size - n, "%s\"%s\":[%u,%u]", i ? "," : "",
+                      SYM_NAMES[i], telemetry.attempts[i], telemetry.successes[i]);
+    }
+    if(n < (int)size) n += snprintf(out + n, size - n, "},\"decode_ms\":[");
+    for(int i = 0; i < DECODE_BUCKETS && n < (int)size; i++) {
+        n += snprintf(out + n, size - n, "%s%u", i ? "," : "", telemetry.decodeHist[i]);
+    }
+    if(n < (int)size) n += snprintf(out + n, size - n, "]");
+    if(telemetry.wakeMs && n < (int)size) n += snprintf(out + n, size - n, ",\"wake_ms\":%u", telemetry.wakeMs);
+    if(n < (int)size) n += snprintf(out + n, size - n, "}");
+    return n < (int)size ? n : -1;
+}
+
+// POST the report; counters are only cleared when the server accepted it
+bool sendTelemetry() {
+    if(!checkWiFi()) {
+        return false;
+    }
+
+    char payload[640];
+    int len = buildTelemetry(payload, sizeof(payload));
+    if(len < 0) {
+        Serial.println("[TELEMETRY] Report troppo lungo");
+        return false;
+    }
+
+    WiFiClientSecure client;
+    client.setInsecure();
+    if(!connectServer(client)) {
+        return false;
+    }
+
+    client.print("POST " TELEMETRY_ENDPOINT " HTTP/1.1\r\n");
+    client.print("Host: " SERVER_HOST "\r\n");
+    client.print("Content-Type: application/json\r\n");
+    client.printf("Content-Length: %d\r\n", len);
+    client.print("Connection: close\r\n\r\n");
+    client.write((const uint8_t *)payload, len);
+
+    char body[128];
+    int code = readHttpResponse(client, body, sizeof(body), 10000);
+    client.stop();
+
+    if(code < 200 || code >= 300) {
+        Serial.printf("[TELEMETRY] Invio fallito: HTTP %d\n", code);
+        return false;
+    }
+
+    // Keep TLS and allocation totals monotonic, remember where this interval ended
+    uint32_t tlsCount = tlsStats.count, tlsFailures = tlsStats.failures, tlsTotalMs = tlsStats.totalMs;
+    memset(&telemetry, 0, sizeof(telemetry));
+    telemetry.tlsCount = tlsCount;
+    telemetry.tlsFailures = tlsFailures;
+    telemetry.tlsTotalMs = tlsTotalMs;
+    telemetry.allocViolations = allocViolations;
+    tlsStats.maxMs = 0;
+    Serial.printf("[TELEMETRY] Inviato (%d bytes)\n", len);
+    return true;
+}
+
+// Milliseconds until the next report is due (0 = now)
+unsigned long telemetryDueIn(unsigned long now) {
+    unsigned long due = lastTelemetry == 0 ? TELEMETRY_FIRST_MS : TELEMETRY_INTERVAL_MS;
+    unsigned long elapsed = now - lastTelemetry;
+    return elapsed >= due ? 0 : due - elapsed;
+}
+
+// Call from loop(): first report shortly after boot (carries reset reason)
+void handleTelemetry(unsigned long now) {
+    if(telemetryDueIn(now) > 0) return;
+    lastTelemetry = now;
+    sendTelemetry();
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef WAKE_TIMING_H
+#define WAKE_TIMING_H
+
+#include <Arduino.h>
+#include "esp_sleep.h"
+#include "soc/rtc.h"
+#include "soc/rtc_cntl_reg.h"
+#include "config.h"
+
+// ============ WAKE TIMING ============
+// millis() and esp_timer start with the app, after the ROM, the bootloader
+// and the image load (~200-300 ms after a deep-sleep wake). The deep-sleep
+// wake stub runs before all of that: it stamps the RTC slow clock, which
+// keeps counting through sleep and reset, and setup() turns the difference
+// into the offset between the wake and esp_timer's zero. The slow clock is
+// the internal RC (about 150 kHz, a few % off), plenty for a ~300 ms offset.
+
+RTC_DATA_ATTR uint32_t wakeRtcLo = 0, wakeRtcHi = 0;    // Two words: no 64-bit helpers in the stub
+int64_t wakeBootOffsetUs = -1;                          // Wake -> esp_timer zero, -1 = not measured
+
+#ifdef ENABLE_DEEP_SLEEP
+// Runs from RTC fast memory right after the wake, flash not mapped yet
+void RTC_IRAM_ATTR esp_wake_deep_sleep(void) {
+    esp_default_wake_deep_sleep();
+    SET_PERI_REG_MASK(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_UPDATE);
+#if CONFIG_IDF_TARGET_ESP32
+    while (GET_PERI_REG_MASK(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_VALID) == 0) {}
+    wakeRtcLo = READ_PERI_REG(RTC_CNTL_TIME0_REG);
+    wakeRtcHi = READ_PERI_REG(RTC_CNTL_TIME1_REG);
+#else
+    wakeRtcLo = READ_PERI_REG(RTC_CNTL_TIME_LOW0_REG);
+    wakeRtcHi = READ_PERI_REG(RTC_CNTL_TIME_HIGH0_REG);
+#endif
+}
+#endif
+
+// Call early in setup() after a deep-sleep wake; consumes the stamp
+void wakeMeasureBoot() {
+    uint64_t stamp = ((uint64_t)wakeRtcHi << 32) | wakeRtcLo;
+    wakeRtcLo = wakeRtcHi = 0;
+    uint32_t hz = rtc_clk_slow_freq_get_hz();
+    uint64_t now = rtc_time_get();
+    if (stamp == 0 || hz == 0 || now <= stamp) return;
+    int64_t sinceWakeUs = (int64_t)((now - stamp) * 1000000ULL / hz);
+    wakeBootOffsetUs = max((int64_t)0, sinceWakeUs - esp_timer_get_time());
+    Serial.printf("[WAKE] ROM + bootloader: %u ms\n", (uint32_t)(wakeBootOffsetUs / 1000));
+}
+
+// Microseconds since the wake; app time only when the stub left no stamp
+int64_t wakeElapsedUs() {
+    return esp_timer_get_time() + max((int64_t)0, wakeBootOffsetUs);
+}
+
+#endif
@@ -3,10 +3,67 @@
 
 #include <WiFi.h>
 #include <WiFiManager.h>
+#include <esp_wifi.h>
 #include "led_feedback.h"
 
 WiFiManager wm;
 
+// ============ FAST RECONNECT ============
+// Channel and BSSID of the last association survive deep sleep, so a wake
+// can join the AP directly instead of scanning all channels first.
+#define WIFI_FAST_TIMEOUT_MS 5000
+
+RTC_DATA_ATTR uint8_t wifiLastBssid[6];
+RTC_DATA_ATTR int32_t wifiLastChannel = 0;
+bool wifiFastPending = false;
+char wifiFastSsid[33];
+char wifiFastPass[65];
+
+void wifiRememberAp() {
+    if(WiFi.status() != WL_CONNECTED) return;
+    wifiLastChannel = WiFi.channel();
+    memcpy(wifiLastBssid, WiFi.BSSID(), sizeof(wifiLastBssid));
+}
+
+// Start associating in the background with the credentials WiFiManager
+// stored, returns false if there is nothing to resume. Not persisted: the
+// channel/BSSID lock stays in RAM, the saved config keeps scanning for the
+// SSID (the AP may move or change channel while we sleep).
+bool wifiFastBegin() {
+    if(wifiLastChannel <= 0) return false;
+    WiFi.mode(WIFI_STA);
+    wifi_config_t conf;
+    if(esp_wifi_get_config(WIFI_IF_STA, &conf) != ESP_OK || !conf.sta.ssid[0]) return false;
+    memcpy(wifiFastSsid, conf.sta.ssid, sizeof(conf.sta.ssid));
+    wifiFastSsid[sizeof(wifiFastSsid) - 1] = 0;
+    memcpy(wifiFastPass, conf.sta.password, sizeof(conf.sta.password));
+    wifiFastPass[sizeof(wifiFastPass) - 1] = 0;
+    WiFi.persistent(false);
+    WiFi.begin(wifiFastSsid, wifiFastPass, wifiLastChannel, wifiLastBssid);
+    WiFi.persistent(true);
+    wifiFastPending = true;
+    return true;
+}
+
+// Wait for a fast reconnect started by wifiFastBegin(). On timeout the
+// stored AP is forgotten and a normal (scanning) join is started.
+bool wifiFastFinish() {
+    wifiFastPending = false;
+    unsigned long t0 = millis();
+    while(WiFi.status() != WL_CONNECTED && millis() - t0 < WIFI_FAST_TIMEOUT_MS) {
+        delay(20);
+    }
+    if(WiFi.status() == WL_CONNECTED) {
+        Serial.printf("[WIFI] Riconnesso (canale %d) in %lu ms\n", wifiLastChannel, millis());
+        return true;
+    }
+    Serial.println("[WIFI] Riconnessione rapida fallita");
+    wifiLastChannel = 0;
+    WiFi.disconnect();
+    WiFi.begin(wifiFastSsid, wifiFastPass);
+    return false;
+}
+
 void setupWiFiManager() {
     Serial.println("\n--- WiFi Configuration ---");
     ledBlink(3, 200, 200);
@@ -38,6 +95,7 @@ void setupWiFiManager() {
     Serial.print("IP: ");
     Serial.println(WiFi.localIP());
     Serial.printf("RSSI: %d dBm\n", WiFi.RSSI());
+    wifiRememberAp();
     
     ledSuccess();
     speakerSuccess();
@@ -45,6 +103,9 @@ void setupWiFiManager() {
 }
 
 bool checkWiFi() {
+    if(wifiFastPending && wifiFastFinish()) {
+        return true;
+    }
     if(WiFi.status() != WL_CONNECTED) {
         Serial.println("WiFi reconnecting...");
         WiFi.reconnect();
@@ -56,6 +117,7 @@ bool checkWiFi() {
         }
         if(WiFi.status() == WL_CONNECTED) {
             Serial.println(" OK!");
+            wifiRememberAp();
             return true;
         } else {
             Serial.println(" FAIL");
@@ -2,9 +2,10 @@ const express = require('express');
 const cors = require('cors');
 const multer = require('multer');
 const Database = require('better-sqlite3');
-const Tesseract = require('tesseract.js');
+const { createWorker, createScheduler } = require('tesseract.js');
 const cron = require('node-cron');
 const path = require('path');
+const os = require('os');
 const fs = require('fs');
 const helmet = require('helmet');
 const rateLimit = require('express-rate-limit');
@@ -78,8 +79,8 @@ app.use(express.static('public'));
 app.use('/images', express.static('uploads/products'));
 
 // ============ FILE UPLOAD SICURO ============
-const ALLOWED_MIMETYPES = ['image/jpeg', 'image/png', 'image/gif', 'image/webp', 'image/x-portable-graymap', 'application/octet-stream'];
-const ALLOWED_EXTENSIONS = ['.jpg', '.jpeg', '.png', '.gif', '.webp', '.pgm', '.raw'];
+const ALLOWED_MIMETYPES = ['image/jpeg', 'image/png', 'image/gif', 'image/webp', 'image/x-portable-graymap', 'image/x-portable-bitmap', 'application/octet-stream'];
+const ALLOWED_EXTENSIONS = ['.jpg', '.jpeg', '.png', '.gif', '.webp', '.pgm', '.pbm', '.raw'];
 
 const storage = multer.diskStorage({
     destination: (req, file, cb) => {
@@ -110,6 +111,138 @@ const upload = multer({
     fileFilter
 });
 
+// OCR uploads stay in memory: they go straight to the worker pool, never to disk
+const memUpload = multer({
+    storage: multer.memoryStorage(),
+    limits: { fileSize: 5 * 1024 * 1024 },
+    fileFilter
+});
+
+// ============ OCR WORKER POOL ============
+// Pre-initialized Tesseract workers (ita+eng loaded once) shared by all
+// requests. Jobs beyond OCR_MAX_QUEUE are rejected with 503 so the device
+// retries instead of waiting on a request that would time out anyway.
+const OCR_WORKERS = validatePositiveInt(process.env.OCR_WORKERS, os.cpus().length, 32);
+const OCR_MAX_QUEUE = validatePositiveInt(process.env.OCR_MAX_QUEUE, OCR_WORKERS * 4, 1000);
+const OCR_LATENCY_SAMPLES = 200;
+
+const ocrScheduler = createScheduler();
+const ocrStats = {
+    ready: 0,
+    pending: 0,     // queued + running
+    completed: 0,
+    failed: 0,
+    rejected: 0,
+    unavailable: 0, // requests refused with no worker ready
+    latencyMs: [],  // last N end-to-end times (queue wait + recognition)
+};
+
+async function initOcrPool() {
+    for (let i = 0; i < OCR_WORKERS; i++) {
+        try {
+            const worker = await createWorker('ita+eng');
+            ocrScheduler.addWorker(worker);
+            ocrStats.ready++;
+        } catch (e) {
+            console.error('[OCR] Worker init failed:', e.message);
+        }
+    }
+    console.log('[OCR] Pool ready: ' + ocrStats.ready + '/' + OCR_WORKERS + ' workers, max queue ' + OCR_MAX_QUEUE);
+}
+
+function pushSample(list, value) {
+    list.push(value);
+    if (list.length > OCR_LATENCY_SAMPLES) list.shift();
+}
+
+function percentile(list, p) {
+    if (list.length === 0) return null;
+    const sorted = [...list].sort((a, b) => a - b);
+    return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+// Queue a recognize job; resolves to the OCR text or null when the queue is
+// full or no worker is up (ocrAdmit() has normally answered those already)
+async function recognizeImage(buffer) {
+    if (ocrStats.ready === 0 || ocrStats.pending >= OCR_MAX_QUEUE) {
+        ocrStats.rejected++;
+        return null;
+    }
+    ocrStats.pending++;
+    const queued = Date.now();
+    try {
+        const { data: { text } } = await ocrScheduler.addJob('recognize', buffer);
+        ocrStats.completed++;
+        pushSample(ocrStats.latencyMs, Date.now() - queued);
+        return text;
+    } catch (e) {
+        ocrStats.failed++;
+        throw e;
+    } finally {
+        ocrStats.pending--;
+    }
+}
+
+// Decode a binary PGM (P5) or PBM (P4, 1 = black) in memory to PNG,
+// since Tesseract expects a common format
+async function pnmToPng(buffer) {
+    const header = buffer.toString('latin1', 0, Math.min(buffer.length, 64));
+    const match = header.match(/^P([45])\s+(?:#.*\s+)*(\d+)\s+(\d+)\s/);
+    if (!match) throw new Error('Formato PNM non valido');
+    const width = parseInt(match[2]);
+    const height = parseInt(match[3]);
+    let offset = match[0].length;
+    let pixels;
+    if (match[1] === '4') {
+        const rowBytes = Math.ceil(width / 8);
+        pixels = Buffer.alloc(width * height);
+        for (let y = 0; y < height; y++) {
+            for (let x = 0; x < width; x++) {
+                const bit = buffer[offset + y * rowBytes + (x >> 3)] & (0x80 >> (x & 7));
+                pixels[y * width + x] = bit ? 0 : 255;
+            }
+        }
+    } else {
+        // P5 has a maxval line after the size
+        const maxval = header.substring(offset).match(/^(\d+)\s/);
+        if (!maxval) throw new Error('Formato PNM non valido');
+        offset += maxval[0].length;
+        pixels = buffer.subarray(offset, offset + width * height);
+    }
+    return sharp(pixels, { raw: { width, height, channels: 1 } }).png().toBuffer();
+}
+
+// Image buffer ready for the OCR pool (raw device formats converted in memory)
+async function ocrInput(file) {
+    const name = file.originalname.toLowerCase();
+    if (name.endsWith('.pgm') || name.endsWith('.pbm') || name.endsWith('.raw')) {
+        return pnmToPng(file.buffer);
+    }
+    return file.buffer;
+}
+
+function sendOcrBusy(res) {
+    res.set('Retry-After', '2');
+    return res.status(503).json({ success: false, error: 'OCR occupato, riprova', queue_depth: ocrStats.pending });
+}
+
+// Before any image work: 503 while no worker is ready (the scheduler would
+// hold the job forever) or the queue is full. True if the request may go on.
+function ocrAdmit(res) {
+    if (ocrStats.ready === 0) {
+        ocrStats.unavailable++;
+        res.set('Retry-After', '10');
+        res.status(503).json({ success: false, error: 'OCR non disponibile', workers_ready: 0 });
+        return false;
+    }
+    if (ocrStats.pending >= OCR_MAX_QUEUE) {
+        ocrStats.rejected++;
+        sendOcrBusy(res);
+        return false;
+    }
+    return true;
+}
+
 // ============ DATABASE ============
 const db = new Database('fridge.db');
 db.exec(`
@@ -146,7 +279,37 @@ db.exec(`
         image_path TEXT,
         timestamp TEXT DEFAULT CURRENT_TIMESTAMP
     );
+    CREATE TABLE IF NOT EXISTS device_telemetry (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        device_id TEXT NOT NULL,
+        device TEXT,
+        boot_count INTEGER,
+        uptime_s INTEGER,
+        reset_reason TEXT,
+        rssi INTEGER,
+        heap_free INTEGER,
+        heap_min INTEGER,
+        heap_largest INTEGER,
+        psram_total INTEGER,
+        psram_free INTEGER,
+        tls_count INTEGER,
+        tls_failures INTEGER,
+        tls_total_ms INTEGER,
+        tls_max_ms INTEGER,
+        scans INTEGER,
+        symbology TEXT,
+        decode_hist TEXT,
+        wake_ms INTEGER,
+        alloc_violations INTEGER,
+        timestamp TEXT DEFAULT CURRENT_TIMESTAMP
+    );
+    CREATE INDEX IF NOT EXISTS idx_telemetry_device ON device_telemetry (device_id, timestamp);
 `);
+// Databases created before wake_ms / alloc_violations were reported
+const telemetryColumns = db.prepare('PRAGMA table_info(device_telemetry)').all().map(c => c.name);
+for (const col of ['wake_ms', 'alloc_violations']) {
+    if (!telemetryColumns.includes(col)) db.exec(`ALTER TABLE device_telemetry ADD COLUMN ${col} INTEGER`);
+}
 console.log('Database initialized');
 
 // ============ INPUT VALIDATION ============
@@ -176,71 +339,105 @@ function validatePositiveInt(val, defaultVal = 1, max = 9999) {
 
 // ============ API ENDPOINTS ============
 
+// Apply one scan to the inventory; returns the user-facing message
+function applyProductAction(action, barcode, expiry_date, device, imagePath) {
+    console.log('[PRODUCT] ' + action + ': ' + barcode);
+
+    db.prepare('INSERT INTO scan_history (barcode, action, device, image_path) VALUES (?, ?, ?, ?)').run(barcode, action, device, imagePath);
+
+    if (action === 'add') {
+        const purchaseDate = new Date().toISOString().split('T')[0]; // Today's date
+        const existing = db.prepare('SELECT * FROM products WHERE barcode = ? AND finished = 0').get(barcode);
+        if (existing) {
+            db.prepare('UPDATE products SET quantity = quantity + 1, image_path = COALESCE(?, image_path) WHERE id = ?').run(imagePath, existing.id);
+        } else {
+            db.prepare('INSERT INTO products (barcode, expiry_date, purchase_date, image_path) VALUES (?, ?, ?, ?)').run(barcode, expiry_date, purchaseDate, imagePath);
+        }
+        db.prepare('DELETE FROM shopping_list WHERE barcode = ?').run(barcode);
+        return 'Prodotto aggiunto';
+    }
+
+    const existing = db.prepare('SELECT * FROM products WHERE barcode = ? AND finished = 0').get(barcode);
+    if (existing) {
+        if (existing.quantity > 1) {
+            db.prepare('UPDATE products SET quantity = quantity - 1 WHERE id = ?').run(existing.id);
+        } else {
+            db.prepare('UPDATE products SET finished = 1, quantity = 0 WHERE id = ?').run(existing.id);
+            if (existing.image_path) {
+                const imgFile = path.join('uploads/products', path.basename(existing.image_path));
+                if (fs.existsSync(imgFile)) fs.unlinkSync(imgFile);
+            }
+            if (!db.prepare('SELECT * FROM shopping_list WHERE barcode = ?').get(barcode)) {
+                db.prepare('INSERT INTO shopping_list (barcode, name, auto_generated) VALUES (?, ?, 1)').run(barcode, existing.name || barcode);
+            }
+        }
+    }
+    return 'Prodotto rimosso';
+}
+
+// Several symbols from one frame arrive as "items" in a single request
+const PRODUCT_BATCH_MAX = 16;
+
+const applyProductBatch = db.transaction((action, items, device) => {
+    return items.map(item => {
+        const barcode = validateBarcode(item && item.barcode);
+        if (!barcode) {
+            return { barcode: null, success: false, error: 'Barcode non valido' };
+        }
+        const expiry = typeof item.expiry_date === 'string' ? validateDate(item.expiry_date) : null;
+        const message = applyProductAction(action, barcode, expiry, device, null);
+        return { barcode, success: true, message };
+    });
+});
+
 app.post('/api/product', upload.single('image'), (req, res) => {
     try {
         const action = sanitizeString(req.body.action, 20);
-        const barcode = validateBarcode(req.body.barcode);
-        const expiry_date = validateDate(req.body.expiry_date);
         const device = sanitizeString(req.body.device, 100);
-        const imagePath = req.file ? '/images/' + req.file.filename : null;
 
-        if (!barcode) {
-            return res.status(400).json({ success: false, error: 'Barcode non valido' });
-        }
         if (!['add', 'remove'].includes(action)) {
             return res.status(400).json({ success: false, error: 'Azione non valida' });
         }
 
-        console.log('[PRODUCT] ' + action + ': ' + barcode);
+        if (Array.isArray(req.body.items)) {
+            const items = req.body.items;
+            if (items.length === 0 || items.length > PRODUCT_BATCH_MAX) {
+                return res.status(400).json({ success: false, error: 'Numero di prodotti non valido' });
+            }
+            const results = applyProductBatch(action, items, device);
+            const processed = results.filter(r => r.success).length;
+            console.log('[PRODUCT] Batch ' + action + ': ' + processed + '/' + items.length);
+            return res.status(processed ? 200 : 400).json({ success: processed > 0, processed, results });
+        }
 
-        db.prepare('INSERT INTO scan_history (barcode, action, device, image_path) VALUES (?, ?, ?, ?)').run(barcode, action, device, imagePath);
+        const barcode = validateBarcode(req.body.barcode);
+        const expiry_date = validateDate(req.body.expiry_date);
+        const imagePath = req.file ? '/images/' + req.file.filename : null;
 
-        if (action === 'add') {
-            const purchaseDate = new Date().toISOString().split('T')[0]; // Today's date
-            const existing = db.prepare('SELECT * FROM products WHERE barcode = ? AND finished = 0').get(barcode);
-            if (existing) {
-                db.prepare('UPDATE products SET quantity = quantity + 1, image_path = COALESCE(?, image_path) WHERE id = ?').run(imagePath, existing.id);
-            } else {
-                db.prepare('INSERT INTO products (barcode, expiry_date, purchase_date, image_path) VALUES (?, ?, ?, ?)').run(barcode, expiry_date, purchaseDate, imagePath);
-            }
-            db.prepare('DELETE FROM shopping_list WHERE barcode = ?').run(barcode);
-            res.json({ success: true, message: 'Prodotto aggiunto' });
-        } else if (action === 'remove') {
-            const existing = db.prepare('SELECT * FROM products WHERE barcode = ? AND finished = 0').get(barcode);
-            if (existing) {
-                if (existing.quantity > 1) {
-                    db.prepare('UPDATE products SET quantity = quantity - 1 WHERE id = ?').run(existing.id);
-                } else {
-                    db.prepare('UPDATE products SET finished = 1, quantity = 0 WHERE id = ?').run(existing.id);
-                    if (existing.image_path) {
-                        const imgFile = path.join('uploads/products', path.basename(existing.image_path));
-                        if (fs.existsSync(imgFile)) fs.unlinkSync(imgFile);
-                    }
-                    if (!db.prepare('SELECT * FROM shopping_list WHERE barcode = ?').get(barcode)) {
-                        db.prepare('INSERT INTO shopping_list (barcode, name, auto_generated) VALUES (?, ?, 1)').run(barcode, existing.name || barcode);
-                    }
-                }
-            }
-            res.json({ success: true, message: 'Prodotto rimosso' });
+        if (!barcode) {
+            return res.status(400).json({ success: false, error: 'Barcode non valido' });
         }
+
+        const message = applyProductAction(action, barcode, expiry_date, device, imagePath);
+        res.json({ success: true, message });
     } catch (e) {
         console.error('[ERROR] /api/product:', e.message);
         res.status(500).json({ success: false, error: 'Errore interno' });
     }
 });
 
-app.post('/api/ocr', upload.single('image'), async (req, res) => {
+app.post('/api/ocr', memUpload.single('image'), async (req, res) => {
     if (!req.file) return res.status(400).json({ error: 'Nessuna immagine' });
+    if (!ocrAdmit(res)) return;
     try {
-        const { data: { text } } = await Tesseract.recognize(req.file.path, 'ita+eng');
+        const text = await recognizeImage(await ocrInput(req.file));
+        if (text === null) return sendOcrBusy(res);
         const datePatterns = [/(\d{2})[\/\-\.](\d{2})[\/\-\.](\d{4})/g, /(\d{2})[\/\-\.](\d{2})[\/\-\.](\d{2})/g];
         let expiry_date = null;
         for (const p of datePatterns) {
             const m = text.match(p);
             if (m) { expiry_date = m[0]; break; }
         }
-        // Cleanup file temporaneo
-        try { fs.unlinkSync(req.file.path); } catch (e) {}
         res.json({ expiry_date, confidence: expiry_date ? 0.7 : 0 });
     } catch (e) {
         console.error('[ERROR] /api/ocr:', e.message);
@@ -249,23 +446,14 @@ app.post('/api/ocr', upload.single('image'), async (req, res) => {
 });
 
 // Receipt scanning endpoint - parses deli receipts (scontrini gastronomia)
-app.post('/api/receipt', upload.single('image'), async (req, res) => {
+app.post('/api/receipt', memUpload.single('image'), async (req, res) => {
     if (!req.file) return res.status(400).json({ error: 'Nessuna immagine' });
-    let convertedPath = null;
+    if (!ocrAdmit(res)) return;
     try {
-        console.log('[RECEIPT] Processing receipt image:', req.file.originalname, req.file.mimetype);
-
-        // Convert any image format to PNG for Tesseract compatibility
-        let imagePath = req.file.path;
-        if (req.file.originalname.endsWith('.pgm') || req.file.originalname.endsWith('.raw')) {
-            console.log('[RECEIPT] Converting PGM/raw to PNG...');
-            convertedPath = req.file.path + '.png';
-            await sharp(req.file.path).png().toFile(convertedPath);
-            imagePath = convertedPath;
-            console.log('[RECEIPT] Conversion complete');
-        }
+        console.log('[RECEIPT] Processing receipt image:', req.file.originalname, req.file.mimetype, req.file.size + ' bytes');
 
-        const { data: { text } } = await Tesseract.recognize(imagePath, 'ita+eng');
+        const text = await recognizeImage(await ocrInput(req.file));
+        if (text === null) return sendOcrBusy(res);
         console.log('[RECEIPT] OCR text:', text.substring(0, 500));
 
         // Parse purchase date from receipt
@@ -370,10 +558,6 @@ app.post('/api/receipt', upload.single('image'), async (req, res) => {
             console.log('[RECEIPT] Added:', product.name, product.weight || '');
         }
 
-        // Cleanup temp files
-        try { fs.unlinkSync(req.file.path); } catch (e) {}
-        if (convertedPath) try { fs.unlinkSync(convertedPath); } catch (e) {}
-
         res.json({
             success: true,
             purchase_date: purchaseDate,
@@ -383,8 +567,6 @@ app.post('/api/receipt', upload.single('image'), async (req, res) => {
         });
     } catch (e) {
         console.error('[ERROR] /api/receipt:', e.message);
-        try { fs.unlinkSync(req.file.path); } catch (e2) {}
-        if (convertedPath) try { fs.unlinkSync(convertedPath); } catch (e3) {}
         res.status(500).json({ error: 'Elaborazione scontrino fallita: ' + e.message });
     }
 });
@@ -584,6 +766,157 @@ app.get('/api/stats', (req, res) => {
     }
 });
 
+// OCR pool metrics (no auth, like health)
+app.get('/api/ocr/metrics', (req, res) => {
+    res.json({
+        workers: OCR_WORKERS,
+        workers_ready: ocrStats.ready,
+        queue_depth: ocrStats.pending,
+        waiting: ocrScheduler.getQueueLen(),
+        max_queue: OCR_MAX_QUEUE,
+        completed: ocrStats.completed,
+        failed: ocrStats.failed,
+        rejected: ocrStats.rejected,
+        unavailable: ocrStats.unavailable,
+        latency_ms: {
+            p50: percentile(ocrStats.latencyMs, 0.5),
+            p95: percentile(ocrStats.latencyMs, 0.95),
+            p99: percentile(ocrStats.latencyMs, 0.99),
+        },
+    });
+});
+
+// ============ DEVICE TELEMETRY ============
+// Each report carries counter deltas for its interval (see telemetry.h)
+const TELEMETRY_SYMBOLOGIES = ['QR', 'EAN13', 'EAN8', 'UPCA'];
+const DECODE_BUCKETS_MS = [25, 50, 100, 200, 400, 800, 1600, Infinity];
+
+function telemetryInt(val, max = 0x7fffffff) {
+    const num = parseInt(val);
+    if (isNaN(num)) return null;
+    return Math.max(-max, Math.min(num, max));
+}
+
+// Upper bound of the bucket holding quantile q
+function bucketPercentile(hist, q) {
+    const total = hist.reduce((a, b) => a + b, 0);
+    if (!total) return null;
+    let seen = 0;
+    for (let i = 0; i < hist.length; i++) {
+        seen += hist[i];
+        if (seen >= q * total) return DECODE_BUCKETS_MS[i];
+    }
+    return null;
+}
+
+app.post('/api/telemetry', (req, res) => {
+    try {
+        const b = req.body || {};
+        const deviceId = sanitizeString(b.id, 32);
+        if (!deviceId) return res.status(400).json({ error: 'id mancante' });
+
+        const tls = Array.isArray(b.tls) ? b.tls.map(v => telemetryInt(v) || 0) : [0, 0, 0, 0];
+        const sym = {};
+        for (const name of TELEMETRY_SYMBOLOGIES) {
+            const v = b.sym && Array.isArray(b.sym[name]) ? b.sym[name] : [0, 0];
+            sym[name] = [telemetryInt(v[0]) || 0, telemetryInt(v[1]) || 0];
+        }
+        const hist = DECODE_BUCKETS_MS.map((_, i) => Array.isArray(b.decode_ms) ? telemetryInt(b.decode_ms[i]) || 0 : 0);
+
+        db.prepare(`INSERT INTO device_telemetry (device_id, device, boot_count, uptime_s, reset_reason, rssi,
+                        heap_free, heap_min, heap_largest, psram_total, psram_free,
+                        tls_count, tls_failures, tls_total_ms, tls_max_ms, scans, symbology, decode_hist, wake_ms,
+                        alloc_violations)
+                    VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`).run(
+            deviceId, sanitizeString(b.device, 50), telemetryInt(b.boot), telemetryInt(b.uptime),
+            sanitizeString(b.reset, 20), telemetryInt(b.rssi, 200),
+            telemetryInt(b.heap), telemetryInt(b.heap_min), telemetryInt(b.heap_largest),
+            telemetryInt(b.psram), telemetryInt(b.psram_free),
+            tls[0], tls[1], tls[2], tls[3], telemetryInt(b.scans) || 0,
+            JSON.stringify(sym), JSON.stringify(hist), telemetryInt(b.wake_ms),
+            telemetryInt(b.alloc_violations) || 0);
+        res.json({ success: true });
+    } catch (e) {
+        console.error('[TELEMETRY]', e.message);
+        res.status(500).json({ error: 'Errore database' });
+    }
+});
+
+// Per-device aggregate over the last `hours` (default 24)
+app.get('/api/telemetry', (req, res) => {
+    try {
+        const hours = validatePositiveInt(req.query.hours, 24, 24 * 30);
+        const rows = db.prepare(`SELECT * FROM device_telemetry WHERE timestamp >= datetime('now', ?)
+                                 ORDER BY timestamp ASC`).all('-' + hours + ' hours');
+
+        const devices = {};
+        for (const r of rows) {
+            const d = devices[r.device_id] || (devices[r.device_id] = {
+                device_id: r.device_id, reports: 0, scans: 0, boots: new Set(),
+                sym: Object.fromEntries(TELEMETRY_SYMBOLOGIES.map(n => [n, [0, 0]])),
+                decode_hist: DECODE_BUCKETS_MS.map(() => 0),
+                tls_count: 0, tls_failures: 0, tls_total_ms: 0, tls_max_ms: 0,
+                rssi_sum: 0, heap_min: null, heap_largest_min: null,
+                wake_count: 0, wake_total_ms: 0, wake_max_ms: 0, alloc_violations: 0,
+            });
+            d.reports++;
+            d.scans += r.scans || 0;
+            d.boots.add(r.boot_count);
+            const sym = JSON.parse(r.symbology || '{}');
+            for (const n of TELEMETRY_SYMBOLOGIES) {
+                if (sym[n]) { d.sym[n][0] += sym[n][0]; d.sym[n][1] += sym[n][1]; }
+            }
+            JSON.parse(r.decode_hist || '[]').forEach((v, i) => { if (i < d.decode_hist.length) d.decode_hist[i] += v; });
+            d.tls_count += r.tls_count || 0;
+            d.tls_failures += r.tls_failures || 0;
+            d.tls_total_ms += r.tls_total_ms || 0;
+            d.tls_max_ms = Math.max(d.tls_max_ms, r.tls_max_ms || 0);
+            d.rssi_sum += r.rssi || 0;
+            d.alloc_violations += r.alloc_violations || 0;
+            if (r.wake_ms != null) {
+                d.wake_count++;
+                d.wake_total_ms += r.wake_ms;
+                d.wake_max_ms = Math.max(d.wake_max_ms, r.wake_ms);
+            }
+            if (r.heap_min != null) d.heap_min = d.heap_min == null ? r.heap_min : Math.min(d.heap_min, r.heap_min);
+            if (r.heap_largest != null) d.heap_largest_min = d.heap_largest_min == null ? r.heap_largest : Math.min(d.heap_largest_min, r.heap_largest);
+            d.last = r;
+        }
+
+        const result = Object.values(devices).map(d => {
+            const ok = TELEMETRY_SYMBOLOGIES.reduce((a, n) => a + d.sym[n][1], 0);
+            return {
+                device_id: d.device_id,
+                device: d.last.device,
+                last_seen: d.last.timestamp,
+                reports: d.reports,
+                reboots: d.boots.size - 1,
+                last_reset_reason: d.last.reset_reason,
+                scans: d.scans,
+                success_rate: d.scans ? ok / d.scans : null,
+                symbology: Object.fromEntries(TELEMETRY_SYMBOLOGIES.map(n => [n, { attempts: d.sym[n][0], successes: d.sym[n][1] }])),
+                decode_ms: { hist: d.decode_hist, p50: bucketPercentile(d.decode_hist, 0.5), p95: bucketPercentile(d.decode_hist, 0.95) },
+                tls: {
+                    count: d.tls_count, failures: d.tls_failures,
+                    avg_ms: d.tls_count ? Math.round(d.tls_total_ms / d.tls_count) : null, max_ms: d.tls_max_ms,
+                },
+                wake_to_decode: {
+                    count: d.wake_count,
+                    avg_ms: d.wake_count ? Math.round(d.wake_total_ms / d.wake_count) : null, max_ms: d.wake_max_ms,
+                },
+                rssi_avg: Math.round(d.rssi_sum / d.reports),
+                alloc_violations: d.alloc_violations,
+                heap: { free: d.last.heap_free, min: d.heap_min, largest_block_min: d.heap_largest_min },
+                psram: { total: d.last.psram_total, free: d.last.psram_free },
+            };
+        });
+        res.json({ hours, devices: result });
+    } catch (e) {
+        console.error('[TELEMETRY]', e.message);
+        res.status(500).json({ error: 'Errore database' });
+    }
+});
+
 // Health check endpoint (no auth)
 app.get('/api/health', (req, res) => {
     res.json({ status: 'ok', timestamp: new Date().toISOString() });
@@ -606,4 +939,10 @@ app.use((err, req, res, next) => {
 });
 
 // ============ START SERVER ============
+initOcrPool();
 app.listen(PORT, '127.0.0.1', () => console.log('Smart Fridge Server on port ' + PORT + ' (localhost only)'));
+
+process.on('SIGTERM', async () => {
+    await ocrScheduler.terminate();
+    process.exit(0);
+});
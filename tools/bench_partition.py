@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Builds the "benchframes" partition image for the on-device benchmark.
+
+Packs 8-bit PGM frames and the text each should decode to into the layout
+self_bench.h reads: header, entry table, then the frames 4-byte aligned.
+Frames of any size run as long as they are no wider than the scanner's
+frame (640 px without PSRAM, 800 px with it); quirc is resized per frame on
+the device, outside the timed runs, so 640x480 frames work on every board.
+
+    python3 bench_partition.py -o bench.bin frames/ean13.pgm=4006381333931 frames/empty.pgm=
+    python3 bench_partition.py -o bench.bin -m frames/manifest.txt
+
+A manifest has one "file text" line per frame, paths relative to it.
+"""
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x46424653          # "SFBF"
+VERSION = 1
+MAX_FRAMES = 16
+EXPECTED_LEN = 48
+PARTITION_OFFSET = 0x290000  # SmartFridgeScanner/partitions.csv
+PARTITION_SIZE = 0x160000
+HEADER = struct.Struct("<IHH")
+ENTRY = struct.Struct("<HHII%ds" % EXPECTED_LEN)
+
+
+def read_pgm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    fields, pos = [], 0
+    while len(fields) < 4:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            pos = data.index(b"\n", pos)
+            continue
+        end = pos
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[pos:end])
+        pos = end
+    if fields[0] != b"P5" or int(fields[3]) > 255:
+        sys.exit("%s: only 8-bit binary PGM (P5) is supported" % path)
+    width, height = int(fields[1]), int(fields[2])
+    pixels = data[pos + 1:pos + 1 + width * height]
+    if len(pixels) != width * height:
+        sys.exit("%s: truncated" % path)
+    return width, height, pixels
+
+
+def parse_frames(args):
+    frames = []
+    if args.manifest:
+        base = os.path.dirname(args.manifest)
+        with open(args.manifest) as f:
+            for line in f:
+                line = line.strip()
+                if not line or line.startswith("#"):
+                    continue
+                path, _, text = line.partition(" ")
+                frames.append((os.path.join(base, path), text.strip()))
+    for spec in args.frames:
+        path, _, text = spec.partition("=")
+        frames.append((path, text))
+    return frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("frames", nargs="*", help="file.pgm=expected text (empty = no symbol)")
+    parser.add_argument("-m", "--manifest", help="file with one 'frame.pgm expected' per line")
+    parser.add_argument("-o", "--output", required=True, help="partition image to write")
+    args = parser.parse_args()
+
+    frames = parse_frames(args)
+    if not frames:
+        parser.error("no frames given")
+    if len(frames) > MAX_FRAMES:
+        sys.exit("at most %d frames fit the benchmark" % MAX_FRAMES)
+
+    table_end = HEADER.size + ENTRY.size * len(frames)
+    offset = (table_end + 3) & ~3
+    entries, blobs = [], []
+    for path, text in frames:
+        width, height, pixels = read_pgm(path)
+        encoded = text.encode()
+        if len(encoded) >= EXPECTED_LEN:
+            sys.exit("%s: expected text longer than %d bytes" % (path, EXPECTED_LEN - 1))
+        entries.append(ENTRY.pack(width, height, offset, len(pixels), encoded))
+        blobs.append((offset, pixels))
+        offset = (offset + len(pixels) + 3) & ~3
+    if offset > PARTITION_SIZE:
+        sys.exit("image is %d bytes, partition holds %d" % (offset, PARTITION_SIZE))
+
+    image = bytearray(offset)
+    image[:table_end] = HEADER.pack(MAGIC, VERSION, len(frames)) + b"".join(entries)
+    for start, pixels in blobs:
+        image[start:start + len(pixels)] = pixels
+    with open(args.output, "wb") as f:
+        f.write(image)
+
+    print("%s: %d frames, %d bytes" % (args.output, len(frames), len(image)))
+    print("esptool.py write_flash 0x%X %s" % (PARTITION_OFFSET, args.output))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,137 @@
+// Scanline fusion benchmark: renders short bursts of one synthetic 1D code
+// with hand jitter between frames, in dim light with sensor noise, and
+// compares single-frame decoding with the firmware's fusionDecode() after
+// 1..N frames (scanline_fusion.h). "fused1" is the band-averaged, stretched
+// profile of the first frame alone, so the gain of averaging over time
+// shows separately from the gain of averaging rows.
+//
+//   ./build/fusion_bench                       EAN-13 at 640x480
+//   ./build/fusion_bench -s upca -r 1024 -n 40 -N 5 -j 4
+
+#include "sketch.cpp"
+#include "synth_frames.h"
+
+#include <chrono>
+#include <unistd.h>
+
+#ifndef ENABLE_SCANLINE_FUSION
+#error "fusion_bench needs ENABLE_SCANLINE_FUSION (config.h)"
+#endif
+
+// Light level x sensor noise: from a well lit frame to a flash that barely
+// reaches the label
+static const struct { double exposure, noise; } POINTS[] = {
+    { 1.0, 8 },  { 1.0, 32 }, { 0.6, 32 }, { 0.4, 24 }, { 0.4, 40 },
+    { 0.3, 32 }, { 0.2, 20 }, { 0.2, 28 }, { 0.15, 20 }, { 0.1, 12 },
+};
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -s SYM    ean13, ean8 or upca (default ean13)\n"
+        "  -r RES    640 or 1024 (default 640)\n"
+        "  -n N      bursts per point (default 20)\n"
+        "  -N N      frames per burst, 2..FUSION_FRAMES (default FUSION_FRAMES)\n"
+        "  -j PX     hand jitter between frames, px (default 3)\n"
+        "  -S SEED   random seed (default 1)\n"
+        "  -v        show the scanner's serial output\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    SynthSymbology sym = SYNTH_EAN13;
+    int width = 640, trials = 20, frames = FUSION_FRAMES;
+    double jitter = 3;
+    uint64_t seed = 1;
+    bool verbose = false;
+    int c;
+    while ((c = getopt(argc, argv, "s:r:n:N:j:S:vh")) != -1) {
+        switch (c) {
+            case 's':
+                for (int s = 0; s < SYNTH_QR; s++) {
+                    if (!strcmp(optarg, SYNTH_SYMBOLOGY_NAMES[s])) sym = (SynthSymbology)s;
+                }
+                break;
+            case 'r': width = atoi(optarg) == 1024 ? 1024 : 640; break;
+            case 'n': trials = std::max(1, atoi(optarg)); break;
+            case 'N': frames = std::max(2, std::min(FUSION_FRAMES, atoi(optarg))); break;
+            case 'j': jitter = atof(optarg); break;
+            case 'S': seed = strtoull(optarg, nullptr, 10); break;
+            case 'v': verbose = true; break;
+            default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    simLibraryInit(!verbose);
+
+    int height = width * 3 / 4;
+    cameraFrameWidth = width;
+    cameraFrameHeight = height;
+    cameraInPsram = true;
+    initBarcodeScanner();
+
+    SynthFrame frame{ width, height, {} };
+    camera_fb_t fb = {};
+    fb.width = width;
+    fb.height = height;
+    fb.len = (size_t)width * height;
+    fb.format = PIXFORMAT_GRAYSCALE;
+
+    printf("%s %dx%d, %d frames per burst, jitter %g px\n", SYNTH_SYMBOLOGY_NAMES[sym], width, height, frames, jitter);
+    printf("%8s %6s %7s %7s", "exposure", "noise", "single", "any");
+    for (int k = 1; k <= frames; k++) printf("  fused%d", k);
+    printf(" %8s %8s\n", "add_ms", "dec_ms");
+
+    for (auto pt : POINTS) {
+        int single = 0, any = 0;
+        std::vector<int> fused(frames + 1, 0);
+        double addMs = 0, decMs = 0;
+        int adds = 0, decs = 0;
+
+        for (int t = 0; t < trials; t++) {
+            SynthRng rng(seed ^ ((uint64_t)width << 48) ^ ((uint64_t)sym << 40) ^
+                         ((uint64_t)(pt.exposure * 100) << 24) ^ ((uint64_t)pt.noise << 16) ^ (uint64_t)t);
+            SynthSymbol symbol;
+            symbol.make(sym, rng);
+            SynthParams p;
+            p.modulePx = 3.0;
+            p.rollDeg = rng.range(-0.5, 0.5);
+            p.offsetX = rng.range(-0.08, 0.08) * width;
+            p.offsetY = rng.range(-0.08, 0.08) * height;
+            p.exposure = pt.exposure;
+            p.noise = pt.noise;
+
+            fusionReset();
+            bool anyHit = false;
+            for (int k = 1; k <= frames; k++) {
+                if (k > 1) {
+                    // Hand drift: a small random walk of the label
+                    p.offsetX += rng.range(-jitter, jitter);
+                    p.offsetY += rng.range(-jitter, jitter);
+                }
+                synthRender(symbol, p, rng, frame);
+                fb.buf = frame.pixels.data();
+
+                BarcodeResult r = scanBarcode(&fb);
+                bool hit = r.found && synthMatches(symbol, r.data);
+                if (k == 1 && hit) single++;
+                anyHit |= hit;
+
+                auto t0 = std::chrono::steady_clock::now();
+                fusionAddFrame(&fb);
+                auto t1 = std::chrono::steady_clock::now();
+                addMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+                adds++;
+                r = fusionDecode(k == 1 ? 1 : 2);
+                decMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+                decs++;
+                if (r.found && synthMatches(symbol, r.data)) fused[k]++;
+            }
+            if (anyHit) any++;
+        }
+
+        printf("%8.2f %6g %6.0f%% %6.0f%%", pt.exposure, pt.noise, 100.0 * single / trials, 100.0 * any / trials);
+        for (int k = 1; k <= frames; k++) printf(" %6.0f%%", 100.0 * fused[k] / trials);
+        printf(" %8.3f %8.3f\n", addMs / adds, decMs / decs);
+        fflush(stdout);
+    }
+    return 0;
+}
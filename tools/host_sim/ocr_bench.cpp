@@ -0,0 +1,453 @@
+// Expiry date OCR accuracy vs. time: renders product labels (barcode, its
+// digits, a lot code and a printed date) and runs them through the
+// firmware's readExpiryDate() (expiry_ocr.h), varying one degradation at a
+// time around a clean baseline. Three print styles: "dot" is inkjet dot
+// matrix with the classifier's own 5x7 shapes, "block" the same shapes
+// printed solid, "sans" a 6x9 face the templates were not built from.
+//
+//   ./build/ocr_bench                          all fonts and axes, 640x480
+//   ./build/ocr_bench -f sans -a height_px,blur -n 40 -r 800
+//   ./build/ocr_bench -o crops/                also save frames + manifest.txt
+//   ./build/ocr_bench -d crops/                labelled crops instead
+//
+// Manifest (DIR/manifest.txt), one crop per line; the barcode box is the
+// region readExpiryDate() excludes, "-" as date = no date expected:
+//   name.pgm YYYY-MM-DD [x y w h]
+
+#include "expiry_ocr.h"
+#include "synth_frames.h"
+
+#include <chrono>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============ FONTS ============
+struct BenchFont {
+    const char *name;
+    int cols, rows;
+    bool dots;       // Inkjet: round dots on the bitmap grid
+    const char *chars;
+    const uint8_t *bits;   // rows bytes per char, MSB-aligned to cols
+};
+
+// 5x7 extras for the classifier's font: separators and prefix letters
+static const char FONT5_EXTRA_CHARS[] = ".-EXPL ";
+static const uint8_t FONT5_EXTRA[][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04}, // .
+    {0x00, 0x00, 0x00, 0x0E, 0x00, 0x00, 0x00}, // -
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // E
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // X
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // P
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // L
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+};
+static uint8_t font5[sizeof(OCR_CLASS_CHARS) - 1 + sizeof(FONT5_EXTRA_CHARS) - 1][7];
+static char font5Chars[sizeof(font5) / 7 + 1];
+
+// 6x9, bolder and rounder: different '1', '4', '7' and '/' slope
+static const char SANS_CHARS[] = "0123456789/.-EXPL ";
+static const uint8_t SANS[][9] = {
+    {0x1E, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E}, // 0
+    {0x0C, 0x1C, 0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F}, // 1
+    {0x1E, 0x33, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x3F}, // 2
+    {0x1E, 0x33, 0x03, 0x03, 0x0E, 0x03, 0x03, 0x33, 0x1E}, // 3
+    {0x06, 0x0E, 0x16, 0x26, 0x3F, 0x06, 0x06, 0x06, 0x06}, // 4
+    {0x3F, 0x30, 0x30, 0x3E, 0x03, 0x03, 0x03, 0x33, 0x1E}, // 5
+    {0x0E, 0x18, 0x30, 0x3E, 0x33, 0x33, 0x33, 0x33, 0x1E}, // 6
+    {0x3F, 0x03, 0x03, 0x06, 0x06, 0x0C, 0x0C, 0x18, 0x18}, // 7
+    {0x1E, 0x33, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x33, 0x1E}, // 8
+    {0x1E, 0x33, 0x33, 0x33, 0x1F, 0x03, 0x03, 0x06, 0x1C}, // 9
+    {0x03, 0x03, 0x06, 0x06, 0x0C, 0x18, 0x18, 0x30, 0x30}, // /
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+    {0x00, 0x00, 0x00, 0x00, 0x1E, 0x00, 0x00, 0x00, 0x00}, // -
+    {0x3F, 0x30, 0x30, 0x30, 0x3E, 0x30, 0x30, 0x30, 0x3F}, // E
+    {0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x33, 0x33, 0x33}, // X
+    {0x3E, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x30, 0x30, 0x30}, // P
+    {0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x3F}, // L
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // space
+};
+
+static BenchFont FONTS[] = {
+    { "dot",   5, 7, true,  font5Chars, &font5[0][0] },
+    { "block", 5, 7, false, font5Chars, &font5[0][0] },
+    { "sans",  6, 9, false, SANS_CHARS, &SANS[0][0] },
+};
+static const int FONT_COUNT = sizeof(FONTS) / sizeof(FONTS[0]);
+
+static void initFonts() {
+    int n = 0;
+    for (int c = 0; OCR_CLASS_CHARS[c]; c++, n++) {
+        memcpy(font5[n], OCR_FONT[c], 7);
+        font5Chars[n] = OCR_CLASS_CHARS[c];
+    }
+    for (int c = 0; FONT5_EXTRA_CHARS[c]; c++, n++) {
+        memcpy(font5[n], FONT5_EXTRA[c], 7);
+        font5Chars[n] = FONT5_EXTRA_CHARS[c];
+    }
+    font5Chars[n] = 0;
+}
+
+// Ink at text point (tx, ty), in font grid units from the line's top left
+static bool fontInk(const BenchFont &f, const char *text, double tx, double ty) {
+    if (ty < 0 || ty >= f.rows || tx < 0) return false;
+    int cell = (int)(tx / (f.cols + 1));
+    if (cell >= (int)strlen(text)) return false;
+    const char *pos = strchr(f.chars, text[cell]);
+    if (!pos) return false;
+    const uint8_t *g = f.bits + (pos - f.chars) * f.rows;
+    double gx = tx - cell * (f.cols + 1);
+    if (!f.dots) {
+        int col = (int)gx, row = (int)ty;
+        return col < f.cols && (g[row] >> (f.cols - 1 - col) & 1);
+    }
+    // Dot matrix: dots of radius 0.38 grid units at the bitmap's cell centres
+    for (int row = std::max(0, (int)ty - 1); row <= std::min(f.rows - 1, (int)ty + 1); row++) {
+        for (int col = std::max(0, (int)gx - 1); col <= std::min(f.cols - 1, (int)gx + 1); col++) {
+            if (!(g[row] >> (f.cols - 1 - col) & 1)) continue;
+            double dx = gx - (col + 0.5), dy = ty - (row + 0.5);
+            if (dx * dx + dy * dy < 0.38 * 0.38) return true;
+        }
+    }
+    return false;
+}
+
+// ============ LABEL RENDERING ============
+struct OcrParams {
+    double heightPx = 16;    // Date line height (cap height), px
+    double rollDeg = 0;
+    double blur = 0.6;       // Gaussian sigma, px
+    double noise = 4;
+    double paper = 200, ink = 50;
+    bool prefix = false;     // "EXP " before the date
+};
+
+struct OcrLabel {
+    char text[32];           // Printed date line
+    char expected[11];       // parseExpiryDate() form
+    OcrBox barcode;
+};
+
+// Random date in one of the formats parseExpiryDate() accepts
+static void makeDate(SynthRng &rng, bool prefix, OcrLabel &l) {
+    static const char *const FORMATS[] = { "%02d/%02d/%02d", "%02d/%02d/%04d", "%02d.%02d.%02d",
+                                           "%02d-%02d-%04d", "%02d/%02d", "%02d/%04d" };
+    static const int DAYS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    int year = 2025 + (int)(rng.next() % 6), month = 1 + (int)(rng.next() % 12);
+    int dim = DAYS[month - 1] + (month == 2 && year % 4 == 0);
+    int day = 1 + (int)(rng.next() % dim);
+    int f = (int)(rng.next() % 6);
+    char date[24];
+    if (f < 4) snprintf(date, sizeof(date), FORMATS[f], day, month, f == 1 || f == 3 ? year : year % 100);
+    else snprintf(date, sizeof(date), FORMATS[f], month, f == 5 ? year : year % 100);
+    snprintf(l.text, sizeof(l.text), "%s%s", prefix ? "EXP " : "", date);
+    snprintf(l.expected, sizeof(l.expected), "%04d-%02d-%02d", year, month, f < 4 ? day : dim);
+}
+
+// Text line with its top left at (x, y), rotated about that point
+static void drawText(std::vector<float> &img, int w, int h, const BenchFont &f, const char *text,
+                     double x, double y, double heightPx, double rollDeg, double paper, double ink) {
+    double unit = heightPx / f.rows;
+    double len = strlen(text) * (f.cols + 1) * unit;
+    double a = rollDeg * M_PI / 180, ca = cos(a), sa = sin(a);
+    int x0 = std::max(0, (int)(x - fabs(heightPx * sa)) - 2);
+    int x1 = std::min(w - 1, (int)(x + len * ca + fabs(heightPx * sa)) + 2);
+    int y0 = std::max(0, (int)(y - fabs(len * sa)) - 2);
+    int y1 = std::min(h - 1, (int)(y + heightPx * ca + fabs(len * sa)) + 2);
+    for (int py = y0; py <= y1; py++) {
+        for (int px = x0; px <= x1; px++) {
+            int cover = 0;
+            for (int s = 0; s < 9; s++) {
+                // 3x3 supersampling, inverse rotation into text space
+                double dx = px + (s % 3 + 0.5) / 3 - x, dy = py + (s / 3 + 0.5) / 3 - y;
+                double tx = (dx * ca + dy * sa) / unit, ty = (-dx * sa + dy * ca) / unit;
+                cover += fontInk(f, text, tx, ty);
+            }
+            if (cover) {
+                float &v = img[(size_t)py * w + px];
+                v -= (float)((v - ink) * cover / 9);
+            }
+        }
+    }
+    (void)paper;
+}
+
+// Label: barcode bars with their digits, a lot code and the date line either
+// below the digits, above the bars or beside them
+static void renderLabel(const BenchFont &font, const OcrParams &p, SynthRng &rng, SynthFrame &out, OcrLabel &l) {
+    const int w = out.width, h = out.height;
+    std::vector<float> img((size_t)w * h);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) img[(size_t)y * w + x] = (float)(p.paper - 25.0 * y / h + 10 * sin(x * 0.01));
+    }
+
+    makeDate(rng, p.prefix, l);
+    double unit = p.heightPx / font.rows;
+    double dateLen = strlen(l.text) * (font.cols + 1) * unit;
+
+    // Bars: 95 modules of 2 px, random widths, like an EAN-13 at scan distance
+    int bw = 190, bh = 70;
+    int placement = (int)(rng.next() % 3);
+    int bx = (int)(w / 2 - bw / 2 + rng.range(-0.1, 0.1) * w);
+    int by = (int)(h / 2 - bh / 2 + rng.range(-0.1, 0.1) * h);
+    if (placement == 2) bx = (int)std::max(10.0, w / 2 - (bw + 30 + dateLen) / 2);
+    for (int x = bx; x < bx + bw;) {
+        int bar = 2 * (1 + (int)(rng.next() % 3)), space = 2 * (1 + (int)(rng.next() % 3));
+        for (int y = by; y < by + bh; y++) {
+            for (int xx = x; xx < std::min(bx + bw, x + bar); xx++) img[(size_t)y * w + xx] = (float)p.ink;
+        }
+        x += bar + space;
+    }
+    l.barcode = { bx, by, bw, bh };
+
+    char digits[16];
+    for (int i = 0; i < 13; i++) digits[i] = (char)('0' + rng.digit());
+    digits[13] = 0;
+    drawText(img, w, h, FONTS[2], digits, bx + 4, by + bh + 3, 11, 0, p.paper, p.ink);
+
+    char lot[16];
+    snprintf(lot, sizeof(lot), "L%05d", (int)(rng.next() % 100000));
+
+    double tx, ty;
+    if (placement == 0) { tx = bx + rng.range(-20, 40); ty = by + bh + 20 + rng.range(8, 40); }
+    else if (placement == 1) { tx = bx + rng.range(-20, 40); ty = by - p.heightPx - rng.range(15, 45); }
+    else { tx = bx + bw + 30; ty = by + rng.range(0, bh - p.heightPx); }
+    drawText(img, w, h, font, l.text, tx, ty, p.heightPx, p.rollDeg, p.paper, p.ink);
+    // Lot code on the other side of the barcode
+    double ly = placement == 1 ? by + bh + 40 : std::max(4.0, by - p.heightPx - 30);
+    drawText(img, w, h, font, lot, bx, ly, p.heightPx, p.rollDeg, p.paper, p.ink);
+
+    synthGaussian(img, w, h, p.blur);
+    if (p.noise > 0) {
+        for (float &v : img) v += (float)(p.noise * rng.gauss());
+    }
+    out.pixels.resize((size_t)w * h);
+    for (size_t i = 0; i < img.size(); i++) out.pixels[i] = (uint8_t)std::max(0.0f, std::min(255.0f, img[i] + 0.5f));
+}
+
+// ============ AXES ============
+struct OcrAxis {
+    const char *name;
+    std::vector<double> values;
+    void (*apply)(OcrParams &p, double v);
+};
+
+static const OcrAxis AXES[] = {
+    { "height_px", { 8, 10, 12, 14, 16, 20, 24, 32 }, [](OcrParams &p, double v) { p.heightPx = v; } },
+    { "blur",      { 0, 0.5, 1.0, 1.5, 2.0, 2.5 },    [](OcrParams &p, double v) { p.blur = v; } },
+    { "noise",     { 0, 4, 8, 12, 16, 24 },           [](OcrParams &p, double v) { p.noise = v; } },
+    { "ink",       { 30, 60, 90, 120, 140, 160 },     [](OcrParams &p, double v) { p.ink = v; } },
+    { "roll_deg",  { 0, 1, 2, 3, 5 },                 [](OcrParams &p, double v) { p.rollDeg += v; } },
+    { "prefix",    { 0, 1 },                          [](OcrParams &p, double v) { p.prefix = v != 0; } },
+};
+static const int AXIS_COUNT = sizeof(AXES) / sizeof(AXES[0]);
+
+static bool listed(const char *list, const char *name) {
+    if (!list) return true;
+    size_t n = strlen(name);
+    for (const char *p = list; (p = strstr(p, name)); p += n) {
+        bool startOk = p == list || p[-1] == ',';
+        bool endOk = p[n] == 0 || p[n] == ',';
+        if (startOk && endOk) return true;
+    }
+    return false;
+}
+
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[(size_t)(q * (v.size() - 1) + 0.5)];
+}
+
+// One readExpiryDate() call; 1 = right date, -1 = wrong date, 0 = none
+struct OcrRun {
+    int outcome;
+    double ms;
+    OcrStats stats;
+    char date[11];
+};
+
+static OcrRun runOcr(const SynthFrame &fr, const OcrBox *barcode, const char *expected) {
+    OcrRun r;
+    r.date[0] = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    bool found = readExpiryDate(fr.pixels.data(), fr.width, fr.height, barcode, r.date, &r.stats);
+    r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    r.outcome = !found ? 0 : (expected && !strcmp(r.date, expected) ? 1 : -1);
+    if (!found) r.date[0] = 0;
+    return r;
+}
+
+// ============ LABELLED CROPS ============
+static bool readPgm(const char *path, SynthFrame &fr) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    int maxval = 0;
+    bool ok = fscanf(f, "P5 %d %d %d", &fr.width, &fr.height, &maxval) == 3 && maxval == 255 && fgetc(f) != EOF;
+    if (ok) {
+        fr.pixels.resize((size_t)fr.width * fr.height);
+        ok = fread(fr.pixels.data(), 1, fr.pixels.size(), f) == fr.pixels.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+static int runCrops(const char *dir, bool verbose) {
+    std::string manifestPath = std::string(dir) + "/manifest.txt";
+    FILE *m = fopen(manifestPath.c_str(), "r");
+    if (!m) { perror(manifestPath.c_str()); return 2; }
+    int total = 0, hits = 0, wrong = 0, falsePos = 0, dated = 0;
+    std::vector<double> times;
+    char line[512];
+    while (fgets(line, sizeof(line), m)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char name[256], expected[32];
+        OcrBox box = { 0, 0, 0, 0 };
+        int n = sscanf(line, "%255s %31s %d %d %d %d", name, expected, &box.x, &box.y, &box.w, &box.h);
+        if (n != 2 && n != 6) { fprintf(stderr, "bad manifest line: %s", line); continue; }
+        SynthFrame fr;
+        if (!readPgm((std::string(dir) + "/" + name).c_str(), fr)) { fprintf(stderr, "cannot read %s\n", name); continue; }
+
+        bool wantDate = strcmp(expected, "-") != 0;
+        OcrRun r = runOcr(fr, n == 6 ? &box : nullptr, wantDate ? expected : nullptr);
+        total++;
+        dated += wantDate;
+        times.push_back(r.ms);
+        if (r.outcome == 1) hits++;
+        else if (r.outcome == -1 && wantDate) wrong++;
+        else if (r.outcome == -1) falsePos++;
+        if (verbose || r.outcome != 1) {
+            printf("%-32s %-10s %-10s \"%s\" %d regions, %.2f ms\n", name, wantDate ? expected : "-",
+                   r.date[0] ? r.date : "-", r.stats.text, r.stats.regions, r.ms);
+        }
+    }
+    fclose(m);
+    if (!total) { fprintf(stderr, "no crops in %s\n", manifestPath.c_str()); return 2; }
+    double mean = 0;
+    for (double v : times) mean += v;
+    printf("%d crops: %d/%d dates read (%.0f%%), %d wrong, %d found without a date; "
+           "%.3f ms mean, %.3f ms p95\n", total, hits, dated, dated ? 100.0 * hits / dated : 0.0,
+           wrong, falsePos, mean / total, percentile(times, 0.95));
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -f LIST   fonts: dot,block,sans (default all)\n"
+        "  -a LIST   axes (default all):", argv0);
+    for (const OcrAxis &a : AXES) fprintf(stderr, " %s", a.name);
+    fprintf(stderr, "\n"
+        "  -r RES    frame width 640 or 800 (default 640)\n"
+        "  -n N      labels per point (default 20)\n"
+        "  -o DIR    also write each label as PGM plus DIR/manifest.txt\n"
+        "  -d DIR    read the labelled crops in DIR/manifest.txt instead\n"
+        "  -S SEED   random seed (default 1)\n"
+        "  -v        print every label with its raw text\n");
+}
+
+int main(int argc, char **argv) {
+    const char *fonts = nullptr, *axes = nullptr, *dumpDir = nullptr, *cropDir = nullptr;
+    int width = 640, trials = 20;
+    uint64_t seed = 1;
+    bool verbose = false;
+    int c;
+    while ((c = getopt(argc, argv, "f:a:r:n:o:d:S:vh")) != -1) {
+        switch (c) {
+            case 'f': fonts = optarg; break;
+            case 'a': axes = optarg; break;
+            case 'r': width = atoi(optarg) == 800 ? 800 : 640; break;
+            case 'n': trials = std::max(1, atoi(optarg)); break;
+            case 'o': dumpDir = optarg; break;
+            case 'd': cropDir = optarg; break;
+            case 'S': seed = strtoull(optarg, nullptr, 10); break;
+            case 'v': verbose = true; break;
+            default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    initFonts();
+    initExpiryOCR();
+    if (cropDir) return runCrops(cropDir, verbose);
+
+    FILE *manifest = nullptr;
+    if (dumpDir) {
+        mkdir(dumpDir, 0755);
+        std::string path = std::string(dumpDir) + "/manifest.txt";
+        manifest = fopen(path.c_str(), "w");
+        if (!manifest) { perror(path.c_str()); return 1; }
+    }
+
+    int height = width * 3 / 4;
+    SynthFrame frame{ width, height, {} };
+    int allHits = 0, allRuns = 0;
+    std::vector<double> allTimes;
+
+    for (int f = 0; f < FONT_COUNT; f++) {
+        const BenchFont &font = FONTS[f];
+        if (!listed(fonts, font.name)) continue;
+        printf("\n%s %dx%d\n%-10s %7s %6s %6s %9s %9s %8s %8s %8s\n", font.name, width, height,
+               "axis", "value", "rate", "wrong", "mean_ms", "p95_ms", "det_us", "seg_us", "cls_us");
+
+        for (int a = 0; a < AXIS_COUNT; a++) {
+            const OcrAxis &axis = AXES[a];
+            if (!listed(axes, axis.name)) continue;
+            for (size_t vi = 0; vi < axis.values.size(); vi++) {
+                double value = axis.values[vi];
+                std::vector<double> times;
+                int hits = 0, wrong = 0;
+                double detUs = 0, segUs = 0, clsUs = 0;
+
+                for (int t = 0; t < trials; t++) {
+                    // Every point is reproducible on its own
+                    SynthRng rng(seed ^ ((uint64_t)width << 48) ^ ((uint64_t)f << 40) ^
+                                 ((uint64_t)a << 32) ^ ((uint64_t)vi << 16) ^ (uint64_t)t);
+                    OcrParams p;
+                    p.rollDeg = rng.range(-0.3, 0.3);
+                    axis.apply(p, value);
+                    OcrLabel label;
+                    renderLabel(font, p, rng, frame, label);
+
+                    if (dumpDir) {
+                        char name[256], path[512];
+                        snprintf(name, sizeof(name), "%s_%d_%s_%g_%02d.pgm", font.name, width, axis.name, value, t);
+                        snprintf(path, sizeof(path), "%s/%s", dumpDir, name);
+                        if (!synthWritePgm(path, frame)) { perror(path); return 1; }
+                        fprintf(manifest, "%s %s %d %d %d %d\n", name, label.expected,
+                                label.barcode.x, label.barcode.y, label.barcode.w, label.barcode.h);
+                    }
+
+                    OcrRun r = runOcr(frame, &label.barcode, label.expected);
+                    times.push_back(r.ms);
+                    hits += r.outcome == 1;
+                    wrong += r.outcome == -1;
+                    detUs += r.stats.detectUs;
+                    segUs += r.stats.segmentUs;
+                    clsUs += r.stats.classifyUs;
+                    if (verbose) {
+                        printf("    %-22s %-10s %-10s \"%s\"\n", label.text, label.expected,
+                               r.date[0] ? r.date : "-", r.stats.text);
+                    }
+                }
+
+                double mean = 0;
+                for (double v : times) mean += v;
+                mean /= times.size();
+                printf("%-10s %7g %5.0f%% %6d %9.3f %9.3f %8.0f %8.0f %8.0f\n", axis.name, value,
+                       100.0 * hits / trials, wrong, mean, percentile(times, 0.95),
+                       detUs / trials, segUs / trials, clsUs / trials);
+                fflush(stdout);
+                allHits += hits;
+                allRuns += trials;
+                allTimes.insert(allTimes.end(), times.begin(), times.end());
+            }
+        }
+    }
+    if (manifest) fclose(manifest);
+    if (allRuns) {
+        double mean = 0;
+        for (double v : allTimes) mean += v;
+        printf("\n%d labels: %.0f%% read, %.3f ms mean, %.3f ms p95\n", allRuns, 100.0 * allHits / allRuns,
+               mean / allRuns, percentile(allTimes, 0.95));
+    }
+    return 0;
+}
@@ -0,0 +1,415 @@
+// Receipt preprocessing check: runs frames through the firmware's
+// prepareReceipt() and streamReceiptBits() (receipt_processor.h) and checks
+// the crop box, the skew angle and the 1bpp output.
+//
+// Synthetic cases (synth_receipts.h) are checked against their ground truth:
+// the box must lie between the paper's inscribed and bounding boxes, the skew
+// must be a search step next to the true angle, and the deskewed PBM must match the
+// paper's print. Saved frames (-d) are checked against a manifest of
+// reference boxes, angles and PBMs, e.g. real captures or a previous -o run.
+//
+//   ./build/receipt_check                       synthetic cases
+//   ./build/receipt_check -o receipts/          ...and save frames, PBMs, manifest
+//   ./build/receipt_check -d receipts/          saved frames vs. references
+//   ./build/receipt_check -d receipts/ -u       rewrite the references
+//
+// Manifest (DIR/manifest.txt), one frame per line:
+//   name.pgm found x y w h skew ref.pbm         ("-" = no reference PBM)
+// Exit status 1 if any frame fails.
+
+#include "receipt_processor.h"
+#include "synth_receipts.h"
+
+#include <chrono>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Saved-frame tolerances: libm differences may move a few threshold pixels
+#define CHECK_BOX_PX        4
+#define CHECK_PBM_DIFF_PCT  1.0
+// Synthetic tolerances: box slack = one sample of margin plus byte rounding
+#define CHECK_BOX_SLACK     (2 * RECEIPT_SAMPLE_STEP)
+#define CHECK_MIN_PRECISION 0.90
+#define CHECK_MIN_RECALL    0.85
+
+struct ReceiptCase {
+    const char *name;
+    int width, height;
+    int paperW, paperH;
+    double skewDeg, offsetX, offsetY;
+    double paper, falloff;
+    bool blank;
+};
+
+// Receipt profile (600x800 upright strip), scan field without PSRAM (640x480)
+// and with (800x600); straight, skewed both ways, off centre, dim paper
+static const ReceiptCase CASES[] = {
+    { "strip_0",        600, 800, 330, 640,  0.0,   0,   0, 215, 0.25, false },
+    { "strip_cw1.5",    600, 800, 330, 640,  1.5,   0,   0, 215, 0.25, false },
+    { "strip_ccw1",     600, 800, 330, 640, -1.0,   0,   0, 215, 0.25, false },
+    { "strip_ccw3",     600, 800, 330, 640, -3.0,  20, -10, 215, 0.25, false },
+    { "strip_cw4",      600, 800, 330, 640,  4.0, -25,  15, 215, 0.25, false },
+    { "strip_ccw6",     600, 800, 300, 600, -6.0,   0,   0, 215, 0.25, false },
+    { "strip_cw7",      600, 800, 300, 600,  7.0,  10,   0, 215, 0.25, false },
+    { "strip_cw2.2",    600, 800, 330, 640,  2.2,   0,   0, 215, 0.25, false },
+    { "strip_dim",      600, 800, 330, 640, -2.0,   0,   0, 170, 0.50, false },
+    { "vga_0",          640, 480, 220, 420,  0.0, -60,   0, 215, 0.25, false },
+    { "vga_ccw2",       640, 480, 220, 420, -2.0,  40,   5, 215, 0.25, false },
+    { "svga_cw2.5",     800, 600, 280, 540,  2.5,   0,   0, 215, 0.25, false },
+    { "vga_empty",      640, 480,   0,   0,  0.0,   0,   0, 215, 0.25, true  },
+};
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -d DIR    check the saved frames listed in DIR/manifest.txt\n"
+        "  -u        with -d: rewrite the manifest and reference PBMs\n"
+        "  -o DIR    save the synthetic frames, PBMs and manifest to DIR\n"
+        "  -S SEED   random seed (default 1)\n"
+        "  -v        per-frame details\n", argv0);
+}
+
+// ============ IMAGE FILES ============
+static bool readPgm(const char *path, SynthFrame &fr) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    int maxval = 0;
+    bool ok = fscanf(f, "P5 %d %d %d", &fr.width, &fr.height, &maxval) == 3 && maxval == 255 && fgetc(f) != EOF;
+    if (ok) {
+        fr.pixels.resize((size_t)fr.width * fr.height);
+        ok = fread(fr.pixels.data(), 1, fr.pixels.size(), f) == fr.pixels.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+struct Pbm {
+    int width = 0, height = 0;
+    std::vector<uint8_t> bits;      // Packed rows, 1 = ink
+    bool at(int x, int y) const { return bits[(size_t)y * (width / 8) + x / 8] & (0x80 >> (x & 7)); }
+};
+
+static bool readPbm(const char *path, Pbm &p) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    bool ok = fscanf(f, "P4 %d %d", &p.width, &p.height) == 2 && fgetc(f) != EOF && p.width % 8 == 0;
+    if (ok) {
+        p.bits.resize((size_t)p.width / 8 * p.height);
+        ok = fread(p.bits.data(), 1, p.bits.size(), f) == p.bits.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+static bool writePbm(const char *path, const Pbm &p) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P4\n%d %d\n", p.width, p.height);
+    bool ok = fwrite(p.bits.data(), 1, p.bits.size(), f) == p.bits.size();
+    return fclose(f) == 0 && ok;
+}
+
+static void collectRow(void *ctx, const uint8_t *row, size_t bytes) {
+    std::vector<uint8_t> *bits = (std::vector<uint8_t> *)ctx;
+    bits->insert(bits->end(), row, row + bytes);
+}
+
+// prepareReceipt() + streamReceiptBits(), timed separately
+static bool runReceipt(const SynthFrame &fr, ReceiptRegion &region, Pbm &out, double &prepMs, double &bitsMs) {
+    auto t0 = std::chrono::steady_clock::now();
+    bool found = prepareReceipt(fr.pixels.data(), fr.width, fr.height, &region);
+    auto t1 = std::chrono::steady_clock::now();
+    prepMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    bitsMs = 0;
+    out = Pbm();
+    if (!found) return false;
+    out.width = region.w;
+    out.height = region.h;
+    out.bits.reserve(receiptPackedSize(&region));
+    streamReceiptBits(fr.pixels.data(), fr.width, fr.height, &region, collectRow, &out.bits);
+    bitsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+    return out.bits.size() == receiptPackedSize(&region);
+}
+
+// ============ SYNTHETIC GROUND TRUTH ============
+// Output pixel -> frame point, as streamReceiptBits() walks it, then -> paper
+// point through the renderer's inverse rotation
+struct PaperMap {
+    double rc, rs, cx, cy;          // Region rotation and centre (frame)
+    int ocx, ocy;                   // Region centre (output)
+    double pc, ps, pcx, pcy, hw, hh; // Paper rotation, centre and half size
+
+    PaperMap(const ReceiptRegion &r, const ReceiptCase &c, int width, int height) {
+        double a = r.skewDeg * M_PI / 180;
+        rc = cos(a); rs = sin(a);
+        ocx = r.w / 2; ocy = r.h / 2;
+        cx = r.x + ocx; cy = r.y + ocy;
+        double b = c.skewDeg * M_PI / 180;
+        pc = cos(b); ps = sin(b);
+        pcx = width / 2.0 + c.offsetX; pcy = height / 2.0 + c.offsetY;
+        hw = c.paperW / 2.0; hh = c.paperH / 2.0;
+    }
+    void paper(int ox, int oy, float &u, float &v) const {
+        double sx = cx + (ox - ocx) * rc - (oy - ocy) * rs + 0.5 - pcx;
+        double sy = cy + (ox - ocx) * rs + (oy - ocy) * rc + 0.5 - pcy;
+        u = (float)(sx * pc + sy * ps + hw);
+        v = (float)(-sx * ps + sy * pc + hh);
+    }
+};
+
+// Ink precision/recall of the deskewed output against the print, one paper
+// pixel of tolerance, ignoring a border where the paper edge meets the shelf
+static void scorePrint(const Pbm &out, const PaperMap &map, const SynthReceiptPrint &print,
+                       const ReceiptCase &c, double &precision, double &recall) {
+    const float border = 4;
+    long outInk = 0, outHit = 0, refInk = 0, refHit = 0;
+    for (int oy = 1; oy < out.height - 1; oy++) {
+        for (int ox = 1; ox < out.width - 1; ox++) {
+            float u, v;
+            map.paper(ox, oy, u, v);
+            if (u < border || v < border || u >= c.paperW - border || v >= c.paperH - border) continue;
+            bool got = out.at(ox, oy);
+            bool want = print.ink(u, v);
+            if (got) {
+                outInk++;
+                bool near = want;
+                for (int d = 0; d < 9 && !near; d++) near = print.ink(u + d % 3 - 1, v + d / 3 - 1);
+                outHit += near;
+            }
+            if (want) {
+                refInk++;
+                bool near = false;
+                for (int d = 0; d < 9 && !near; d++) near = out.at(ox + d % 3 - 1, oy + d / 3 - 1);
+                refHit += near;
+            }
+        }
+    }
+    precision = outInk ? (double)outHit / outInk : 0;
+    recall = refInk ? (double)refHit / refInk : 0;
+}
+
+// The skew must be one of the search steps around the true angle (the step
+// itself when the angle is on the grid)
+static bool skewMatches(double got, double truth) {
+    return fabs(got - truth) < RECEIPT_SKEW_STEP_DEG - 0.01;
+}
+
+static void writeManifestLine(FILE *m, const char *name, const ReceiptRegion &r, bool found) {
+    if (found) fprintf(m, "%s.pgm 1 %d %d %d %d %.1f %s.pbm\n", name, r.x, r.y, r.w, r.h, r.skewDeg, name);
+    else fprintf(m, "%s.pgm 0 0 0 0 0 0 -\n", name);
+}
+
+static int runSynthetic(uint64_t seed, const char *outDir, bool verbose) {
+    FILE *manifest = nullptr;
+    if (outDir) {
+        mkdir(outDir, 0755);
+        std::string path = std::string(outDir) + "/manifest.txt";
+        manifest = fopen(path.c_str(), "w");
+        if (!manifest) { fprintf(stderr, "cannot write %s\n", path.c_str()); return 2; }
+    }
+
+    printf("%-12s %9s %-22s %-22s %6s %6s %6s %6s %7s %7s  %s\n", "case", "frame", "box", "x0,y0 range",
+           "skew", "want", "prec", "recall", "prep_ms", "bits_ms", "result");
+    int failed = 0, n = 0;
+    double prepTotal = 0, bitsTotal = 0;
+    for (const ReceiptCase &c : CASES) {
+        SynthRng rng(seed * 7919 + n++);
+        SynthReceiptParams p;
+        p.paperW = c.paperW;
+        p.paperH = c.paperH;
+        p.skewDeg = c.skewDeg;
+        p.offsetX = c.offsetX;
+        p.offsetY = c.offsetY;
+        p.paper = c.paper;
+        p.falloff = c.falloff;
+        p.blank = c.blank;
+
+        SynthFrame fr{ c.width, c.height, {} };
+        SynthRng printRng = rng;                     // Same print as the renderer's
+        SynthReceiptTruth truth = synthRenderReceipt(p, rng, fr);
+        SynthReceiptPrint print;
+        print.make(p, printRng);
+
+        ReceiptRegion r;
+        Pbm out;
+        double prepMs, bitsMs;
+        bool found = runReceipt(fr, r, out, prepMs, bitsMs);
+        prepTotal += prepMs;
+        bitsTotal += bitsMs;
+
+        char box[32] = "-", expected[32] = "-", why[96] = "";
+        double precision = 0, recall = 0;
+        if (c.blank) {
+            if (found) snprintf(why, sizeof(why), "receipt in an empty frame");
+        } else if (!found) {
+            snprintf(why, sizeof(why), "not found");
+        } else {
+            // Inscribed box: inside the paper's slanted edges
+            double a = fabs(c.skewDeg) * M_PI / 180;
+            double cx = c.width / 2.0 + c.offsetX, cy = c.height / 2.0 + c.offsetY;
+            double ix = c.paperW / 2.0 * cos(a) - c.paperH / 2.0 * sin(a);
+            double iy = c.paperH / 2.0 * cos(a) - c.paperW / 2.0 * sin(a);
+            int in0 = (int)ceil(cx - ix), in1 = (int)floor(cx + ix);
+            int jn0 = (int)ceil(cy - iy), jn1 = (int)floor(cy + iy);
+            snprintf(box, sizeof(box), "%d,%d %dx%d", r.x, r.y, r.w, r.h);
+            snprintf(expected, sizeof(expected), "%d..%d,%d..%d", truth.x0, in0, truth.y0, jn0);
+            int rx1 = r.x + r.w, ry1 = r.y + r.h;
+            if (r.x < truth.x0 - CHECK_BOX_SLACK || r.x > in0 + CHECK_BOX_SLACK ||
+                r.y < truth.y0 - CHECK_BOX_SLACK || r.y > jn0 + CHECK_BOX_SLACK ||
+                rx1 > truth.x1 + CHECK_BOX_SLACK || rx1 < in1 - CHECK_BOX_SLACK ||
+                ry1 > truth.y1 + CHECK_BOX_SLACK || ry1 < jn1 - CHECK_BOX_SLACK) {
+                snprintf(why, sizeof(why), "box outside %d..%d x %d..%d", truth.x0, truth.x1, truth.y0, truth.y1);
+            } else if (!skewMatches(r.skewDeg, c.skewDeg)) {
+                snprintf(why, sizeof(why), "skew %.1f, expected %.1f", r.skewDeg, c.skewDeg);
+            } else {
+                scorePrint(out, PaperMap(r, c, c.width, c.height), print, c, precision, recall);
+                if (precision < CHECK_MIN_PRECISION || recall < CHECK_MIN_RECALL) {
+                    snprintf(why, sizeof(why), "print mismatch");
+                }
+            }
+        }
+        bool ok = !why[0];
+        failed += !ok;
+        printf("%-12s %4dx%-4d %-22s %-22s %6.1f %6.1f %6.3f %6.3f %7.2f %7.2f  %s%s\n", c.name, c.width, c.height,
+               box, expected, found ? r.skewDeg : 0.0, c.skewDeg, precision, recall,
+               prepMs, bitsMs, ok ? "ok" : "FAIL: ", why);
+        if (verbose && found) {
+            printf("    Otsu %u, paper bbox %d,%d..%d,%d, %zu bytes 1bpp\n", r.paperThreshold,
+                   truth.x0, truth.y0, truth.x1, truth.y1, out.bits.size());
+        }
+
+        if (outDir) {
+            std::string base = std::string(outDir) + "/" + c.name;
+            bool saved = synthWritePgm((base + ".pgm").c_str(), fr);
+            if (found) saved &= writePbm((base + ".pbm").c_str(), out);
+            if (!saved) { fprintf(stderr, "cannot write %s.*\n", base.c_str()); return 2; }
+            writeManifestLine(manifest, c.name, r, found);
+        }
+    }
+    if (manifest) fclose(manifest);
+
+    int total = (int)(sizeof(CASES) / sizeof(CASES[0]));
+    printf("%d/%d ok, prepareReceipt %.2f ms, streamReceiptBits %.2f ms per frame\n",
+           total - failed, total, prepTotal / total, bitsTotal / total);
+    return failed ? 1 : 0;
+}
+
+// ============ SAVED FRAMES ============
+static int runSaved(const char *dir, bool update, bool verbose) {
+    std::string manifestPath = std::string(dir) + "/manifest.txt";
+    FILE *m = fopen(manifestPath.c_str(), "r");
+    if (!m) { fprintf(stderr, "cannot read %s\n", manifestPath.c_str()); return 2; }
+    std::vector<std::string> lines;
+    char line[512];
+    while (fgets(line, sizeof(line), m)) {
+        if (line[0] != '#' && line[0] != '\n') lines.push_back(line);
+    }
+    fclose(m);
+
+    FILE *rewrite = nullptr;
+    if (update) {
+        rewrite = fopen(manifestPath.c_str(), "w");
+        if (!rewrite) { fprintf(stderr, "cannot write %s\n", manifestPath.c_str()); return 2; }
+    }
+
+    int failed = 0, total = 0;
+    double prepTotal = 0, bitsTotal = 0;
+    for (const std::string &l : lines) {
+        char name[256], ref[256];
+        int found = 0, x, y, w, h;
+        float skew;
+        if (sscanf(l.c_str(), "%255s %d %d %d %d %d %f %255s", name, &found, &x, &y, &w, &h, &skew, ref) != 8) {
+            fprintf(stderr, "bad manifest line: %s", l.c_str());
+            failed++;
+            continue;
+        }
+        SynthFrame fr;
+        if (!readPgm((std::string(dir) + "/" + name).c_str(), fr)) {
+            printf("%-24s FAIL: cannot read frame\n", name);
+            failed++;
+            continue;
+        }
+        total++;
+        ReceiptRegion r;
+        Pbm out;
+        double prepMs, bitsMs;
+        bool got = runReceipt(fr, r, out, prepMs, bitsMs);
+        prepTotal += prepMs;
+        bitsTotal += bitsMs;
+
+        if (update) {
+            std::string stem(name);
+            stem = stem.substr(0, stem.rfind('.'));
+            if (got && !writePbm((std::string(dir) + "/" + stem + ".pbm").c_str(), out)) {
+                fprintf(stderr, "cannot write %s.pbm\n", stem.c_str());
+                return 2;
+            }
+            writeManifestLine(rewrite, stem.c_str(), r, got);
+            printf("%-24s %s\n", name, got ? "updated" : "updated (no receipt)");
+            continue;
+        }
+
+        char why[96] = "";
+        double diffPct = 0;
+        if (got != (found != 0)) {
+            snprintf(why, sizeof(why), got ? "receipt in an empty frame" : "not found");
+        } else if (got && (abs(r.x - x) > CHECK_BOX_PX || abs(r.y - y) > CHECK_BOX_PX ||
+                           abs(r.w - w) > CHECK_BOX_PX || abs(r.h - h) > CHECK_BOX_PX)) {
+            snprintf(why, sizeof(why), "box %d,%d %dx%d, expected %d,%d %dx%d", r.x, r.y, r.w, r.h, x, y, w, h);
+        } else if (got && fabs(r.skewDeg - skew) > 0.01) {
+            snprintf(why, sizeof(why), "skew %.1f, expected %.1f", r.skewDeg, skew);
+        } else if (got && strcmp(ref, "-")) {
+            Pbm want;
+            if (!readPbm((std::string(dir) + "/" + ref).c_str(), want)) {
+                snprintf(why, sizeof(why), "cannot read %s", ref);
+            } else {
+                // Compare over the common area; a size change counts as differing pixels
+                int cw = std::min(want.width, out.width), ch = std::min(want.height, out.height);
+                long diff = (long)want.width * want.height + (long)out.width * out.height - 2L * cw * ch;
+                for (int yy = 0; yy < ch; yy++) {
+                    for (int xx = 0; xx < cw; xx++) diff += want.at(xx, yy) != out.at(xx, yy);
+                }
+                diffPct = 100.0 * diff / ((long)std::max(want.width, out.width) * std::max(want.height, out.height));
+                if (diffPct > CHECK_PBM_DIFF_PCT) snprintf(why, sizeof(why), "PBM differs in %.2f%% of pixels", diffPct);
+            }
+        }
+        bool ok = !why[0];
+        failed += !ok;
+        if (got) {
+            printf("%-24s %d,%d %dx%d skew %.1f, PBM diff %.2f%%, %.2f + %.2f ms  %s%s\n", name, r.x, r.y, r.w, r.h,
+                   r.skewDeg, diffPct, prepMs, bitsMs, ok ? "ok" : "FAIL: ", why);
+        } else {
+            printf("%-24s no receipt, %.2f ms  %s%s\n", name, prepMs, ok ? "ok" : "FAIL: ", why);
+        }
+        if (verbose && got) printf("    Otsu %u, %zu bytes 1bpp\n", r.paperThreshold, out.bits.size());
+    }
+    if (rewrite) {
+        fclose(rewrite);
+        return 0;
+    }
+    if (total) {
+        printf("%d/%d ok, prepareReceipt %.2f ms, streamReceiptBits %.2f ms per frame\n",
+               total - failed, total, prepTotal / total, bitsTotal / total);
+    }
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *savedDir = nullptr, *outDir = nullptr;
+    bool update = false, verbose = false;
+    uint64_t seed = 1;
+    int c;
+    while ((c = getopt(argc, argv, "d:uo:S:vh")) != -1) {
+        switch (c) {
+            case 'd': savedDir = optarg; break;
+            case 'u': update = true; break;
+            case 'o': outDir = optarg; break;
+            case 'S': seed = strtoull(optarg, nullptr, 10); break;
+            case 'v': verbose = true; break;
+            default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    if (update && !savedDir) { usage(argv[0]); return 2; }
+    return savedDir ? runSaved(savedDir, update, verbose) : runSynthetic(seed, outDir, verbose);
+}
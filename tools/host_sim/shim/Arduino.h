@@ -0,0 +1,213 @@
+// Host simulator: just enough of the Arduino-ESP32 core to build the sketch.
+// Everything time related runs on the simulator's virtual clock (sim.h).
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+#include "sim.h"
+
+#if !defined(CONFIG_IDF_TARGET_ESP32S3) && !defined(CONFIG_IDF_TARGET_ESP32)
+#define CONFIG_IDF_TARGET_ESP32 1
+#endif
+#if CONFIG_IDF_TARGET_ESP32
+#define SOC_DAC_SUPPORTED 1
+#else
+#define SOC_DAC_SUPPORTED 0
+#endif
+
+#define ESP_ARDUINO_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_ARDUINO_VERSION ESP_ARDUINO_VERSION_VAL(2, 0, 14)
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_IRAM_ATTR
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define FPSTR(p) (p)
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NO_MEM 0x101
+
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ============ STRING ============
+class String {
+public:
+    String(const char *c = "") : s(c ? c : "") {}
+    String(const std::string &x) : s(x) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    const char *c_str() const { return s.c_str(); }
+    unsigned length() const { return s.size(); }
+    String &operator+=(const String &o) { s += o.s; return *this; }
+    String &operator+=(const char *o) { s += o; return *this; }
+    String &operator+=(char o) { s += o; return *this; }
+    friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+    friend String operator+(const String &a, const char *b) { return String(a.s + b); }
+    friend String operator+(const char *a, const String &b) { return String(a + b.s); }
+    bool operator==(const char *o) const { return s == o; }
+    bool operator==(const String &o) const { return s == o.s; }
+    bool isEmpty() const { return s.empty(); }
+    std::string s;
+};
+
+// ============ PRINT / STREAM ============
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return write(&c, 1); }
+    virtual size_t write(const uint8_t *buf, size_t n) = 0;
+    size_t write(const char *buf, size_t n) { return write((const uint8_t *)buf, n); }
+    size_t print(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+    size_t print(const String &str) { return print(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+    template <class T> size_t println(const T &v) { return print(v) + println(); }
+    size_t println() { return print("\r\n"); }
+    size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[512];
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        if (n < 0) return 0;
+        return write((const uint8_t *)buf, std::min((size_t)n, sizeof(buf) - 1));
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    void setTimeout(unsigned long) {}
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    void flush() { fflush(stdout); }
+    size_t write(const uint8_t *buf, size_t n) override { return simSerialWrite(buf, n); }
+    using Print::write;
+    operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+// ============ TIME / GPIO / PWM ============
+inline unsigned long millis() { return (unsigned long)(simNowUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)simNowUs(); }
+inline void delay(unsigned long ms) { simAdvance((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned us) { simAdvance(us); }
+inline void yield() {}
+
+void pinMode(int pin, int mode);
+int digitalRead(int pin);
+void digitalWrite(int pin, int level);
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int pin, void (*isr)(), int mode);
+void detachInterrupt(int pin);
+
+void ledcSetup(int channel, int freq, int bits);
+void ledcAttachPin(int pin, int channel);
+bool ledcAttach(int pin, int freq, int bits);
+void ledcWrite(int channelOrPin, int duty);
+void ledcDetachPin(int pin);
+bool ledcDetach(int pin);
+
+// Hardware timer, Arduino-ESP32 2.x API
+typedef struct SimHwTimer hw_timer_t;
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool countUp);
+void timerAttachInterrupt(hw_timer_t *timer, void (*isr)(), bool edge);
+void timerWrite(hw_timer_t *timer, uint64_t ticks);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t ticks, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
+void timerAlarmDisable(hw_timer_t *timer);
+
+// ============ HEAP ============
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+
+typedef struct {
+    size_t total_free_bytes;
+    size_t total_allocated_bytes;
+    size_t largest_free_block;
+    size_t minimum_free_bytes;
+    size_t allocated_blocks;
+    size_t free_blocks;
+    size_t total_blocks;
+} multi_heap_info_t;
+
+bool psramFound();
+void *ps_malloc(size_t size);
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *p);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps);
+
+inline uint32_t getCpuFrequencyMhz() { return 240; }
+
+class EspClass {
+public:
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getPsramSize();
+    uint32_t getFreePsram();
+    uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+    uint32_t getCycleCount();       // Host time scaled to a 240 MHz core
+    [[noreturn]] void restart();
+};
+extern EspClass ESP;
+
+// ============ SLEEP / RESET ============
+typedef int gpio_num_t;
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED, ESP_SLEEP_WAKEUP_ALL, ESP_SLEEP_WAKEUP_EXT0, ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER, ESP_SLEEP_WAKEUP_TOUCHPAD, ESP_SLEEP_WAKEUP_ULP, ESP_SLEEP_WAKEUP_GPIO
+} esp_sleep_wakeup_cause_t;
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+inline esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t, int) { return ESP_OK; }
+inline esp_err_t esp_sleep_enable_timer_wakeup(uint64_t) { return ESP_OK; }
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { return ESP_OK; }
+[[noreturn]] void esp_deep_sleep_start();
+
+typedef enum {
+    ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO
+} esp_reset_reason_t;
+inline esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
@@ -0,0 +1,51 @@
+// The debug server is compiled but never serves: its frame cache task is
+// not started by the single-threaded simulator
+#pragma once
+#include <Arduino.h>
+#include <functional>
+
+#define RESPONSE_TRY_AGAIN 0xFFFFFFFF
+enum WebRequestMethod { HTTP_GET = 1, HTTP_POST = 2 };
+typedef std::function<size_t(uint8_t *, size_t, size_t)> AwsResponseFiller;
+
+class AsyncWebServerResponse {
+public:
+    virtual ~AsyncWebServerResponse() {}
+    void addHeader(const String &, const String &) {}
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+public:
+    size_t write(const uint8_t *, size_t n) override { return n; }
+    using Print::write;
+};
+
+class AsyncWebParameter {
+public:
+    const String &value() const { return v; }
+    String v;
+};
+
+class AsyncWebServerRequest {
+public:
+    AsyncResponseStream *beginResponseStream(const String &) { return new AsyncResponseStream(); }
+    AsyncWebServerResponse *beginChunkedResponse(const String &, AwsResponseFiller) { return new AsyncWebServerResponse(); }
+    AsyncWebServerResponse *beginResponse(int, const String &, const String &) { return new AsyncWebServerResponse(); }
+    AsyncWebServerResponse *beginResponse_P(int, const String &, const uint8_t *, size_t) { return new AsyncWebServerResponse(); }
+    void send(AsyncWebServerResponse *r) { delete r; }
+    void send(int, const String & = String(), const String & = String()) {}
+    void send_P(int, const String &, const char *) {}
+    void send_P(int, const String &, const uint8_t *, size_t) {}
+    void onDisconnect(std::function<void()>) {}
+    bool hasParam(const String &) const { return false; }
+    AsyncWebParameter *getParam(const String &) const { return nullptr; }
+};
+
+typedef std::function<void(AsyncWebServerRequest *)> ArRequestHandlerFunction;
+
+class AsyncWebServer {
+public:
+    AsyncWebServer(int) {}
+    void on(const char *, int, ArRequestHandlerFunction) {}
+    void begin() {}
+};
@@ -0,0 +1,54 @@
+// Always associated; the network itself is WiFiClient -> local TCP server
+#pragma once
+#include <Arduino.h>
+
+#define WL_IDLE_STATUS 0
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+#define WIFI_OFF 0
+#define WIFI_STA 1
+
+class IPAddress {
+public:
+    String toString() const { return String("127.0.0.1"); }
+    operator String() const { return toString(); }
+};
+
+class WiFiClass {
+public:
+    int status() { return WL_CONNECTED; }
+    void reconnect() {}
+    int RSSI() { return -55; }
+    IPAddress localIP() { return IPAddress(); }
+    IPAddress softAPIP() { return IPAddress(); }
+    void disconnect(bool = false) {}
+    void mode(int) {}
+    int channel() { return 6; }
+    uint8_t *BSSID() { static uint8_t bssid[6] = { 0x02, 0, 0, 0, 0, 1 }; return bssid; }
+    void begin(const char *, const char *, int32_t = 0, const uint8_t * = nullptr, bool = true) {}
+    void setSleep(bool) {}
+    void persistent(bool) {}
+};
+extern WiFiClass WiFi;
+
+// Plain TCP to the stand-in server given on the simulator command line
+class WiFiClient : public Stream {
+public:
+    ~WiFiClient() { stop(); }
+    int connect(const char *host, uint16_t port);
+    uint8_t connected();
+    void stop();
+    int available() override;
+    int read() override;
+    size_t write(const uint8_t *buf, size_t n) override;
+    using Print::write;
+    void setTimeout(unsigned long) {}
+    operator bool() { return fd >= 0; }
+
+private:
+    int fd = -1;
+    uint8_t rx[1024];
+    size_t rxLen = 0, rxPos = 0;
+    bool eof = false;
+    int fill(int waitMs);
+};
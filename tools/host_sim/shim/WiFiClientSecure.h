@@ -0,0 +1,9 @@
+#pragma once
+#include <WiFi.h>
+
+// No TLS on the host: the stand-in server speaks plain HTTP
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() {}
+    void setHandshakeTimeout(unsigned long) {}
+};
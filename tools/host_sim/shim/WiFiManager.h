@@ -0,0 +1,11 @@
+#pragma once
+#include <WiFi.h>
+#include <functional>
+
+class WiFiManager {
+public:
+    void setConfigPortalTimeout(int) {}
+    void setAPCallback(std::function<void(WiFiManager *)>) {}
+    void setDebugOutput(bool) {}
+    bool autoConnect(const char *, const char *) { return true; }
+};
@@ -0,0 +1,15 @@
+// DAC output only feeds the simulator's I/O counters
+#pragma once
+#include <Arduino.h>
+typedef enum { DAC_CHANNEL_1, DAC_CHANNEL_2 } dac_channel_t;
+typedef enum { DAC_CHANNEL_MASK_CH0 = 1, DAC_CHANNEL_MASK_CH1 = 2 } dac_channel_mask_t;
+#define DAC_CW_SCALE_1 0
+#define DAC_CW_SCALE_2 1
+#define DAC_CW_PHASE_0 2
+typedef struct { int en_ch; int scale; int phase; uint32_t freq; int8_t offset; } dac_cw_config_t;
+inline esp_err_t dac_output_enable(dac_channel_t) { return ESP_OK; }
+inline esp_err_t dac_output_disable(dac_channel_t) { return ESP_OK; }
+esp_err_t dac_output_voltage(dac_channel_t ch, uint8_t value);
+esp_err_t dac_cw_generator_config(dac_cw_config_t *cw);
+inline esp_err_t dac_cw_generator_enable() { return ESP_OK; }
+inline esp_err_t dac_cw_generator_disable() { return ESP_OK; }
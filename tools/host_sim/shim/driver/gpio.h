@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+typedef enum {
+    GPIO_INTR_DISABLE, GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, GPIO_INTR_ANYEDGE,
+    GPIO_INTR_LOW_LEVEL, GPIO_INTR_HIGH_LEVEL
+} gpio_int_type_t;
+// One interrupt type per pin, shared by attachInterrupt() and the wake
+// (sim_runtime.cpp); a level type whose level holds fires again and again
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type);
+inline esp_err_t gpio_wakeup_disable(gpio_num_t) { return ESP_OK; }
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type);
@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+// Legacy PCNT driver, one unit: the runtime counts the sensor's VSYNC edges
+// (esp_camera_init starts them) and raises the high-limit event on each
+typedef enum { PCNT_UNIT_0 } pcnt_unit_t;
+typedef enum { PCNT_CHANNEL_0 } pcnt_channel_t;
+typedef enum { PCNT_COUNT_DIS, PCNT_COUNT_INC, PCNT_COUNT_DEC } pcnt_count_mode_t;
+typedef enum { PCNT_MODE_KEEP, PCNT_MODE_REVERSE, PCNT_MODE_DISABLE } pcnt_ctrl_mode_t;
+typedef enum { PCNT_EVT_H_LIM = 0x10 } pcnt_evt_type_t;
+#define PCNT_PIN_NOT_USED (-1)
+
+typedef struct {
+    int pulse_gpio_num;
+    int ctrl_gpio_num;
+    pcnt_ctrl_mode_t lctrl_mode;
+    pcnt_ctrl_mode_t hctrl_mode;
+    pcnt_count_mode_t pos_mode;
+    pcnt_count_mode_t neg_mode;
+    int16_t counter_h_lim;
+    int16_t counter_l_lim;
+    pcnt_unit_t unit;
+    pcnt_channel_t channel;
+} pcnt_config_t;
+
+esp_err_t pcnt_unit_config(const pcnt_config_t *config);
+esp_err_t pcnt_event_enable(pcnt_unit_t unit, pcnt_evt_type_t evt);
+esp_err_t pcnt_isr_service_install(int flags);
+esp_err_t pcnt_isr_handler_add(pcnt_unit_t unit, void (*isr)(void *), void *arg);
+esp_err_t pcnt_counter_pause(pcnt_unit_t unit);
+esp_err_t pcnt_counter_resume(pcnt_unit_t unit);
+esp_err_t pcnt_counter_clear(pcnt_unit_t unit);
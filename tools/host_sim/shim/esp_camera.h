@@ -0,0 +1,64 @@
+// Camera driver stand-in: frames come from the simulator's PGM directory
+#pragma once
+#include <Arduino.h>
+#include <sys/time.h>
+
+typedef enum { PIXFORMAT_RGB565, PIXFORMAT_YUV422, PIXFORMAT_YUV420, PIXFORMAT_GRAYSCALE, PIXFORMAT_JPEG } pixformat_t;
+typedef enum {
+    FRAMESIZE_96X96, FRAMESIZE_QQVGA, FRAMESIZE_QCIF, FRAMESIZE_HQVGA, FRAMESIZE_240X240, FRAMESIZE_QVGA,
+    FRAMESIZE_CIF, FRAMESIZE_HVGA, FRAMESIZE_VGA, FRAMESIZE_SVGA, FRAMESIZE_XGA, FRAMESIZE_HD,
+    FRAMESIZE_SXGA, FRAMESIZE_UXGA, FRAMESIZE_INVALID
+} framesize_t;
+typedef enum { CAMERA_GRAB_WHEN_EMPTY, CAMERA_GRAB_LATEST } camera_grab_mode_t;
+typedef enum { CAMERA_FB_IN_PSRAM, CAMERA_FB_IN_DRAM } camera_fb_location_t;
+typedef enum { LEDC_CHANNEL_0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3 } ledc_channel_t;
+typedef enum { LEDC_TIMER_0, LEDC_TIMER_1, LEDC_TIMER_2, LEDC_TIMER_3 } ledc_timer_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t width;
+    size_t height;
+    pixformat_t format;
+    struct timeval timestamp;
+} camera_fb_t;
+
+typedef struct {
+    int pin_pwdn, pin_reset, pin_xclk, pin_sccb_sda, pin_sccb_scl;
+    int pin_d7, pin_d6, pin_d5, pin_d4, pin_d3, pin_d2, pin_d1, pin_d0;
+    int pin_vsync, pin_href, pin_pclk;
+    int xclk_freq_hz;
+    ledc_timer_t ledc_timer;
+    ledc_channel_t ledc_channel;
+    pixformat_t pixel_format;
+    framesize_t frame_size;
+    int jpeg_quality;
+    size_t fb_count;
+    camera_fb_location_t fb_location;
+    camera_grab_mode_t grab_mode;
+} camera_config_t;
+
+#define OV2640_PID 0x26
+#define OV3660_PID 0x3660
+#define OV5640_PID 0x5640
+
+typedef struct { uint16_t PID; } sensor_id_t;
+typedef struct _sensor sensor_t;
+typedef int (*sensor_int_fn)(sensor_t *, int);
+struct _sensor {
+    sensor_id_t id;
+    sensor_int_fn set_brightness, set_contrast, set_saturation, set_sharpness, set_denoise,
+        set_special_effect, set_whitebal, set_awb_gain, set_wb_mode, set_exposure_ctrl, set_aec2,
+        set_gain_ctrl, set_agc_gain, set_bpc, set_wpc, set_raw_gma, set_lenc, set_hmirror, set_vflip,
+        set_dcw, set_aec_value;
+    int (*set_framesize)(sensor_t *, framesize_t);
+    int (*set_reg)(sensor_t *, int reg, int mask, int value);
+    int (*set_res_raw)(sensor_t *, int startX, int startY, int endX, int endY, int offsetX, int offsetY,
+                       int totalX, int totalY, int outputX, int outputY, bool scale, bool binning);
+};
+
+esp_err_t esp_camera_init(const camera_config_t *config);
+esp_err_t esp_camera_deinit();
+camera_fb_t *esp_camera_fb_get();
+void esp_camera_fb_return(camera_fb_t *fb);
+sensor_t *esp_camera_sensor_get();
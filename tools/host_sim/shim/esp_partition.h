@@ -0,0 +1,22 @@
+// Flash partitions: only the bench frame image, loaded from the file given
+// with host_sim -b, is found; mmap hands out the loaded copy
+#pragma once
+#include <Arduino.h>
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0, ESP_PARTITION_TYPE_DATA = 1 } esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+typedef uint32_t spi_flash_mmap_handle_t;
+typedef enum { SPI_FLASH_MMAP_DATA, SPI_FLASH_MMAP_INST } spi_flash_mmap_memory_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label);
+esp_err_t esp_partition_mmap(const esp_partition_t *part, size_t offset, size_t size, spi_flash_mmap_memory_t memory,
+                             const void **out, spi_flash_mmap_handle_t *handle);
+inline void spi_flash_munmap(spi_flash_mmap_handle_t) {}
@@ -0,0 +1,4 @@
+// Sleep API lives in the Arduino.h shim; the wake stub hook is never run
+#pragma once
+#include <Arduino.h>
+inline void esp_default_wake_deep_sleep() {}
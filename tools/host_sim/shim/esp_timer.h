@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include "sim.h"
+
+typedef struct SimTimer *esp_timer_handle_t;
+typedef enum { ESP_TIMER_TASK } esp_timer_dispatch_t;
+typedef struct {
+    void (*callback)(void *arg);
+    void *arg;
+    esp_timer_dispatch_t dispatch_method;
+    const char *name;
+    bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+inline int64_t esp_timer_get_time() { return (int64_t)simNowUs(); }
+int esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out);
+int esp_timer_start_once(esp_timer_handle_t t, uint64_t us);
+int esp_timer_start_periodic(esp_timer_handle_t t, uint64_t us);
+int esp_timer_stop(esp_timer_handle_t t);
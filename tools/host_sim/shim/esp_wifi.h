@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+#include <string.h>
+
+typedef enum { WIFI_IF_STA = 0, WIFI_IF_AP } wifi_interface_t;
+typedef struct { uint8_t ssid[32]; uint8_t password[64]; } wifi_sta_config_t;
+typedef union { wifi_sta_config_t sta; } wifi_config_t;
+
+inline esp_err_t esp_wifi_get_config(wifi_interface_t, wifi_config_t *conf) {
+    memset(conf, 0, sizeof(*conf));
+    memcpy(conf->sta.ssid, "host-sim", 8);
+    return ESP_OK;
+}
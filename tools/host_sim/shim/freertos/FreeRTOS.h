@@ -0,0 +1,47 @@
+// Single-threaded FreeRTOS stand-in: the sketch's loop task is the only
+// task that runs; mutexes always succeed, queues block on the virtual clock.
+#pragma once
+#include <stdint.h>
+#include "sim.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t EventBits_t;
+typedef void *TaskHandle_t;
+typedef struct SimQueue *QueueHandle_t;
+typedef struct SimQueue *SemaphoreHandle_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define portMAX_DELAY 0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(x) (void)(x)
+
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+#define portENTER_CRITICAL_ISR(mux) (void)(mux)
+#define portEXIT_CRITICAL_ISR(mux) (void)(mux)
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *out, int core);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+// Only the loop task runs, on the host's own stack: no meaningful figure
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+inline TickType_t xTaskGetTickCount() { return (TickType_t)(simNowUs() / 1000); }
+inline void vTaskDelay(TickType_t ticks) { simAdvance((uint64_t)ticks * 1000); }
+void vTaskDelayUntil(TickType_t *prev, TickType_t period);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken);
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q);
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
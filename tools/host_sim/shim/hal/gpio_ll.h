@@ -0,0 +1,8 @@
+#pragma once
+#include <driver/gpio.h>
+// Register writes from ISRs: the type changes, nothing is dispatched
+struct gpio_dev_t {};
+extern gpio_dev_t GPIO;
+void simGpioSetType(int pin, gpio_int_type_t type);
+inline void gpio_ll_set_intr_type(gpio_dev_t *, uint32_t pin, gpio_int_type_t type) { simGpioSetType(pin, type); }
+inline void gpio_ll_wakeup_disable(gpio_dev_t *, uint32_t) {}
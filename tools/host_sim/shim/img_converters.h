@@ -0,0 +1,12 @@
+// No JPEG encoder on the host: the "JPEG" handed to the callback/buffer is
+// the frame as a binary PGM, which is what the stand-in server receives
+#pragma once
+#include "esp_camera.h"
+
+typedef size_t (*jpg_out_cb)(void *arg, size_t index, const void *data, size_t len);
+bool frame2jpg(camera_fb_t *fb, uint8_t quality, uint8_t **out, size_t *outLen);
+bool frame2jpg_cb(camera_fb_t *fb, uint8_t quality, jpg_out_cb cb, void *arg);
+bool fmt2jpg(uint8_t *src, size_t len, uint16_t width, uint16_t height, pixformat_t format,
+             uint8_t quality, uint8_t **out, size_t *outLen);
+bool fmt2jpg_cb(uint8_t *src, size_t len, uint16_t width, uint16_t height, pixformat_t format,
+                uint8_t quality, jpg_out_cb cb, void *arg);
@@ -0,0 +1,218 @@
+// Fallback when the simulator is built without ARDUINOJSON_DIR: a small
+// read-only subset of ArduinoJson 6 covering what api_client.h uses
+// (StaticJsonDocument, deserializeJson, lookups, array iteration).
+// Strings are unescaped into the document's own copy of the input, so the
+// document never allocates.
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum SimJsonType : uint8_t { SJ_NULL, SJ_BOOL, SJ_NUMBER, SJ_STRING, SJ_ARRAY, SJ_OBJECT };
+
+struct SimJsonNode {
+    SimJsonType type;
+    const char *key;        // Member name inside an object
+    const char *str;
+    double num;
+    int first, next;        // Children list, -1 terminated
+};
+
+struct JsonDocument;
+
+class JsonVariant {
+public:
+    JsonVariant(const JsonDocument *doc = nullptr, int idx = -1) : doc(doc), idx(idx) {}
+    JsonVariant operator[](const char *key) const;
+    bool containsKey(const char *key) const { return !(*this)[key].isNull(); }
+    bool isNull() const { return node() == nullptr || node()->type == SJ_NULL; }
+
+    operator const char *() const { const SimJsonNode *n = node(); return n && n->type == SJ_STRING ? n->str : nullptr; }
+    operator bool() const { const SimJsonNode *n = node(); return n && (n->type == SJ_BOOL || n->type == SJ_NUMBER) && n->num != 0; }
+    operator int() const { const SimJsonNode *n = node(); return n && (n->type == SJ_NUMBER || n->type == SJ_BOOL) ? (int)n->num : 0; }
+    operator float() const { const SimJsonNode *n = node(); return n && n->type == SJ_NUMBER ? (float)n->num : 0; }
+    template <class T> T as() const { return (T)*this; }
+
+    class iterator {
+    public:
+        iterator(const JsonDocument *doc, int idx) : doc(doc), idx(idx) {}
+        JsonVariant operator*() const { return JsonVariant(doc, idx); }
+        iterator &operator++();
+        bool operator!=(const iterator &o) const { return idx != o.idx; }
+    private:
+        const JsonDocument *doc;
+        int idx;
+    };
+    iterator begin() const { const SimJsonNode *n = node(); return iterator(doc, n && n->type == SJ_ARRAY ? n->first : -1); }
+    iterator end() const { return iterator(doc, -1); }
+
+protected:
+    const SimJsonNode *node() const;
+    const JsonDocument *doc;
+    int idx;
+};
+
+typedef JsonVariant JsonObject;
+typedef JsonVariant JsonArray;
+
+class DeserializationError {
+public:
+    DeserializationError(const char *msg = nullptr) : msg(msg) {}
+    explicit operator bool() const { return msg != nullptr; }
+    const char *c_str() const { return msg ? msg : "Ok"; }
+private:
+    const char *msg;
+};
+
+struct JsonDocument {
+    SimJsonNode *nodes;
+    int capacity, count;
+    char *text;
+    size_t textSize;
+
+    JsonVariant operator[](const char *key) const { return JsonVariant(this, count ? 0 : -1)[key]; }
+    bool containsKey(const char *key) const { return !(*this)[key].isNull(); }
+
+    // Parser state
+    char *p, *w;
+
+    int add(SimJsonType type) {
+        if (count >= capacity) return -1;
+        SimJsonNode &n = nodes[count];
+        n.type = type; n.key = nullptr; n.str = nullptr; n.num = 0; n.first = n.next = -1;
+        return count++;
+    }
+    void skip() { while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++; }
+
+    // Unescape a string in place; the result never outgrows the source
+    const char *parseString() {
+        char *out = w = p;
+        for (;;) {
+            char c = *p++;
+            if (c == 0) return nullptr;
+            if (c == '"') break;
+            if (c == '\\') {
+                c = *p++;
+                switch (c) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': {
+                        unsigned cp = 0;
+                        for (int i = 0; i < 4; i++, p++) {
+                            char h = *p;
+                            if (h >= '0' && h <= '9') cp = cp * 16 + (h - '0');
+                            else if ((h | 0x20) >= 'a' && (h | 0x20) <= 'f') cp = cp * 16 + ((h | 0x20) - 'a' + 10);
+                            else return nullptr;
+                        }
+                        if (cp < 0x80) { *w++ = (char)cp; }
+                        else if (cp < 0x800) { *w++ = (char)(0xC0 | (cp >> 6)); *w++ = (char)(0x80 | (cp & 0x3F)); }
+                        else { *w++ = (char)(0xE0 | (cp >> 12)); *w++ = (char)(0x80 | ((cp >> 6) & 0x3F)); *w++ = (char)(0x80 | (cp & 0x3F)); }
+                        continue;
+                    }
+                    default: break;
+                }
+            }
+            *w++ = c;
+        }
+        *w = 0;
+        return out;
+    }
+
+    int parseValue(int depth) {
+        skip();
+        if (depth > 16) return -1;
+        if (*p == '{' || *p == '[') {
+            bool obj = *p++ == '{';
+            int idx = add(obj ? SJ_OBJECT : SJ_ARRAY);
+            if (idx < 0) return -1;
+            int last = -1;
+            skip();
+            if (*p == (obj ? '}' : ']')) { p++; return idx; }
+            for (;;) {
+                const char *key = nullptr;
+                if (obj) {
+                    skip();
+                    if (*p++ != '"' || !(key = parseString())) return -1;
+                    skip();
+                    if (*p++ != ':') return -1;
+                }
+                int child = parseValue(depth + 1);
+                if (child < 0) return -1;
+                nodes[child].key = key;
+                if (last < 0) nodes[idx].first = child; else nodes[last].next = child;
+                last = child;
+                skip();
+                if (*p == ',') { p++; continue; }
+                if (*p++ == (obj ? '}' : ']')) return idx;
+                return -1;
+            }
+        }
+        if (*p == '"') {
+            p++;
+            int idx = add(SJ_STRING);
+            if (idx < 0 || !(nodes[idx].str = parseString())) return -1;
+            return idx;
+        }
+        if (!strncmp(p, "true", 4) || !strncmp(p, "false", 5)) {
+            int idx = add(SJ_BOOL);
+            if (idx < 0) return -1;
+            nodes[idx].num = *p == 't';
+            p += *p == 't' ? 4 : 5;
+            return idx;
+        }
+        if (!strncmp(p, "null", 4)) {
+            p += 4;
+            return add(SJ_NULL);
+        }
+        char *end;
+        double num = strtod(p, &end);
+        if (end == p) return -1;
+        p = end;
+        int idx = add(SJ_NUMBER);
+        if (idx >= 0) nodes[idx].num = num;
+        return idx;
+    }
+};
+
+template <size_t N>
+struct StaticJsonDocument : JsonDocument {
+    StaticJsonDocument() { nodes = pool; capacity = N / 16 + 4; count = 0; text = buf; textSize = sizeof(buf); }
+    SimJsonNode pool[N / 16 + 4];
+    char buf[N + 1];
+};
+
+inline const SimJsonNode *JsonVariant::node() const {
+    return doc && idx >= 0 && idx < doc->count ? &doc->nodes[idx] : nullptr;
+}
+
+inline JsonVariant JsonVariant::operator[](const char *key) const {
+    const SimJsonNode *n = node();
+    if (!n || n->type != SJ_OBJECT) return JsonVariant(doc, -1);
+    for (int c = n->first; c >= 0; c = doc->nodes[c].next) {
+        if (doc->nodes[c].key && strcmp(doc->nodes[c].key, key) == 0) return JsonVariant(doc, c);
+    }
+    return JsonVariant(doc, -1);
+}
+
+inline JsonVariant::iterator &JsonVariant::iterator::operator++() {
+    idx = doc->nodes[idx].next;
+    return *this;
+}
+
+template <class Doc>
+DeserializationError deserializeJson(Doc &doc, const char *json) {
+    size_t len = strlen(json);
+    if (len >= doc.textSize) return DeserializationError("NoMemory");
+    memcpy(doc.text, json, len + 1);
+    doc.count = 0;
+    doc.p = doc.text;
+    if (doc.parseValue(0) < 0) {
+        bool full = doc.count >= doc.capacity;
+        doc.count = 0;
+        return DeserializationError(full ? "NoMemory" : "InvalidInput");
+    }
+    return DeserializationError();
+}
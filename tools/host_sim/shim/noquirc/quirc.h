@@ -0,0 +1,45 @@
+// Fallback when the simulator is built without QUIRC_DIR: same API and
+// struct sizes as quirc, but no QR code is ever found (1D decoding is
+// unaffected). Build with QUIRC_DIR=/path/to/quirc to decode QR as well.
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SIM_QUIRC_STUB 1
+
+#define QUIRC_MAX_BITMAP 3917
+#define QUIRC_MAX_PAYLOAD 8896
+
+struct quirc_point { int x, y; };
+struct quirc_code {
+    struct quirc_point corners[4];
+    int size;
+    uint8_t cell_bitmap[QUIRC_MAX_BITMAP];
+};
+struct quirc_data {
+    int version, ecc_level, mask, data_type;
+    uint8_t payload[QUIRC_MAX_PAYLOAD];
+    int payload_len;
+    uint32_t eci;
+};
+typedef enum { QUIRC_SUCCESS = 0, QUIRC_ERROR_DATA_UNDERFLOW = 7 } quirc_decode_error_t;
+
+struct quirc { uint8_t *image; int w, h; };
+
+inline struct quirc *quirc_new() { return (struct quirc *)calloc(1, sizeof(struct quirc)); }
+inline void quirc_destroy(struct quirc *q) { if (q) free(q->image); free(q); }
+inline int quirc_resize(struct quirc *q, int w, int h) {
+    uint8_t *image = (uint8_t *)realloc(q->image, (size_t)w * h);
+    if (!image) return -1;
+    q->image = image; q->w = w; q->h = h;
+    return 0;
+}
+inline uint8_t *quirc_begin(struct quirc *q, int *w, int *h) {
+    if (w) *w = q->w;
+    if (h) *h = q->h;
+    return q->image;
+}
+inline void quirc_end(struct quirc *) {}
+inline int quirc_count(const struct quirc *) { return 0; }
+inline void quirc_extract(const struct quirc *, int, struct quirc_code *) {}
+inline quirc_decode_error_t quirc_decode(const struct quirc_code *, struct quirc_data *) { return QUIRC_ERROR_DATA_UNDERFLOW; }
@@ -0,0 +1,21 @@
+// Host simulator runtime interface shared by the shims (see sim_runtime.cpp)
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Virtual clock: host CPU time spent running the sketch plus all the time
+// skipped over while it waits (delay, queue timeouts) in accelerated mode
+uint64_t simNowUs();
+
+// Let `us` of virtual time pass, firing timers and scripted input on the way
+void simAdvance(uint64_t us);
+
+// Advance until `ready()` holds or `us` have passed; false on timeout
+bool simWaitUntil(bool (*ready)(void *), void *arg, uint64_t us);
+
+size_t simSerialWrite(const uint8_t *buf, size_t n);
+
+// Start the clock with no end of run, for tools that drive sketch functions
+// directly instead of setup()/loop() (runtime built with SIM_NO_MAIN)
+void simLibraryInit(bool quiet);
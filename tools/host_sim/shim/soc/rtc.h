@@ -0,0 +1,6 @@
+// No RTC slow clock on the host: reads as 0, so the wake timing falls back
+// to app time (wake_timing.h)
+#pragma once
+#include <stdint.h>
+inline uint64_t rtc_time_get() { return 0; }
+inline uint32_t rtc_clk_slow_freq_get_hz() { return 150000; }
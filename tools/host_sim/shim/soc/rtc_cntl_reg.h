@@ -0,0 +1,13 @@
+// RTC timer registers for the deep-sleep wake stub, all reading 0
+#pragma once
+#include <stdint.h>
+#define RTC_CNTL_TIME_UPDATE_REG    0
+#define RTC_CNTL_TIME_UPDATE        (1u << 31)
+#define RTC_CNTL_TIME_VALID         (1u << 30)
+#define RTC_CNTL_TIME0_REG          0
+#define RTC_CNTL_TIME1_REG          0
+#define RTC_CNTL_TIME_LOW0_REG      0
+#define RTC_CNTL_TIME_HIGH0_REG     0
+#define SET_PERI_REG_MASK(reg, mask) ((void)(reg), (void)(mask))
+#define GET_PERI_REG_MASK(reg, mask) ((void)(reg), (mask))
+#define READ_PERI_REG(reg) ((void)(reg), 0u)
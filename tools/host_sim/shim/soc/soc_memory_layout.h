@@ -0,0 +1,7 @@
+// Host memory has no IRAM/PSRAM: program text and the bench image count as
+// flash, everything else as DRAM
+#pragma once
+bool simPtrInFlash(const void *p);
+inline bool esp_ptr_in_iram(const void *) { return false; }
+inline bool esp_ptr_in_dram(const void *p) { return !simPtrInFlash(p); }
+inline bool esp_ptr_external_ram(const void *) { return false; }
@@ -0,0 +1,1148 @@
+// Host simulator runtime: virtual clock, timers, scripted GPIO, camera
+// frames from PGM files, TCP networking and the end-of-run report.
+//
+// The sketch runs single-threaded: setup() once, then loop() forever. All
+// waiting (delay, queue timeouts) goes through simWaitUntil(), which fires
+// esp_timer callbacks and scripted input edges in time order and, in
+// accelerated mode, skips the idle time instead of sleeping through it.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_camera.h>
+#include <esp_partition.h>
+#include <soc/soc_memory_layout.h>
+#include <img_converters.h>
+#include <driver/dac.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#include <driver/pcnt.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <malloc.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+void setup();
+void loop();
+extern const int simButtonPin;
+extern const int simPirPin;
+extern const bool simPirEnabled;
+extern const uint32_t *const simAllocViolations;
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+EspClass ESP;
+
+// ============ OPTIONS ============
+struct SimOptions {
+    const char *framesDir = nullptr;
+    const char *scriptFile = nullptr;
+    const char *server = "127.0.0.1:8787";
+    uint64_t durationUs = 0;        // 0 = until the script ends
+    uint64_t everyUs = 0;           // Periodic short presses
+    uint64_t captureUs = 70000;     // Sensor frame period (fb_get latency)
+    bool realtime = false;
+    bool psram = false;
+    bool quiet = false;
+    bool traceIo = false;
+    bool failOnAlloc = false;       // Exit 1 on any alloc_check.h violation
+    uint32_t minEvents = 0;         // Exit 1 if fewer input events were handled
+    const char *benchImage = nullptr;   // "benchframes" partition contents
+    esp_sleep_wakeup_cause_t wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+};
+static SimOptions opt;
+
+// ============ HEAP ACCOUNTING ============
+// malloc and friends are interposed so every allocation of the sketch is
+// counted. The runtime's own buffers (frames, script) are allocated with
+// counting paused and never freed, so they cannot skew the totals.
+extern "C" {
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void *__libc_memalign(size_t, size_t);
+void __libc_free(void *);
+}
+
+static int64_t heapLive = 0, heapPeak = 0;
+static int64_t heapBlocks = 0;
+static int64_t heapBase = 0;            // Live bytes when setup() starts
+static int64_t heapEventPeak = 0;       // Peak during the current event
+static int heapPaused = 0;              // Runtime-internal allocations, not counted
+
+static inline void heapNote(void *p, int sign) {
+    if (!p || heapPaused) return;
+    heapLive += sign * (int64_t)malloc_usable_size(p);
+    heapBlocks += sign;
+    if (heapLive > heapPeak) heapPeak = heapLive;
+    if (heapLive > heapEventPeak) heapEventPeak = heapLive;
+}
+
+extern "C" {
+void *malloc(size_t n) { void *p = __libc_malloc(n); heapNote(p, 1); return p; }
+void *calloc(size_t a, size_t b) { void *p = __libc_calloc(a, b); heapNote(p, 1); return p; }
+void free(void *p) { heapNote(p, -1); __libc_free(p); }
+void *realloc(void *old, size_t n) {
+    heapNote(old, -1);
+    void *p = __libc_realloc(old, n);
+    heapNote(p ? p : (n ? old : nullptr), 1);
+    return p;
+}
+void *memalign(size_t align, size_t n) { void *p = __libc_memalign(align, n); heapNote(p, 1); return p; }
+void *aligned_alloc(size_t align, size_t n) { return memalign(align, n); }
+int posix_memalign(void **out, size_t align, size_t n) {
+    *out = memalign(align, n);
+    return *out ? 0 : 12;
+}
+void *valloc(size_t n) { return memalign(4096, n); }
+void *pvalloc(size_t n) { return memalign(4096, (n + 4095) & ~(size_t)4095); }
+}
+
+// Simulated capacities: internal RAM left after WiFi, optional 4 MB PSRAM
+static const int64_t SIM_HEAP_BYTES = 300 * 1024;
+static const int64_t SIM_PSRAM_BYTES = 4 * 1024 * 1024;
+static int64_t heapMinFree = SIM_HEAP_BYTES;
+
+static uint32_t heapFree() {
+    int64_t used = heapLive - heapBase;
+    int64_t avail = (opt.psram ? SIM_HEAP_BYTES + SIM_PSRAM_BYTES : SIM_HEAP_BYTES) - used;
+    if (avail < heapMinFree) heapMinFree = avail;
+    return avail > 0 ? (uint32_t)avail : 0;
+}
+
+bool psramFound() { return opt.psram; }
+void *ps_malloc(size_t size) { return malloc(size); }
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+    if ((caps & MALLOC_CAP_SPIRAM) && !opt.psram) return nullptr;
+    return malloc(size);
+}
+void heap_caps_free(void *p) { free(p); }
+size_t heap_caps_get_free_size(uint32_t) { return heapFree(); }
+size_t heap_caps_get_largest_free_block(uint32_t) { return heapFree(); }
+size_t heap_caps_get_minimum_free_size(uint32_t) { heapFree(); return heapMinFree > 0 ? heapMinFree : 0; }
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t) {
+    memset(info, 0, sizeof(*info));
+    info->total_free_bytes = heapFree();
+    info->total_allocated_bytes = heapLive - heapBase;
+    info->largest_free_block = info->total_free_bytes;
+    info->minimum_free_bytes = heapMinFree > 0 ? heapMinFree : 0;
+    info->allocated_blocks = heapBlocks;
+}
+
+uint32_t EspClass::getFreeHeap() { return heapFree(); }
+uint32_t EspClass::getMinFreeHeap() { heapFree(); return heapMinFree > 0 ? heapMinFree : 0; }
+uint32_t EspClass::getMaxAllocHeap() { return heapFree(); }
+uint32_t EspClass::getPsramSize() { return opt.psram ? SIM_PSRAM_BYTES : 0; }
+uint32_t EspClass::getFreePsram() { return opt.psram ? heapFree() : 0; }
+
+// ============ VIRTUAL CLOCK ============
+typedef std::chrono::steady_clock SteadyClock;
+static SteadyClock::time_point realStart;
+static uint64_t skippedUs = 0;
+static uint64_t endUs = 0;
+
+static uint64_t realUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - realStart).count();
+}
+
+uint64_t simNowUs() { return realUs() + skippedUs; }
+
+static void moveTo(uint64_t t) {
+    uint64_t now = simNowUs();
+    if (t <= now) return;
+    if (opt.realtime) std::this_thread::sleep_for(std::chrono::microseconds(t - now));
+    else skippedUs += t - now;
+}
+
+[[noreturn]] static void simFinish(const char *why);
+
+// ============ TIMERS ============
+struct SimTimer {
+    void (*cb)(void *);
+    void *arg;
+    const char *name;
+    uint64_t dueUs, periodUs;
+    bool armed;
+};
+static std::vector<SimTimer *> timers;
+static uint32_t timerFires = 0;
+
+int esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    SimTimer *t = new SimTimer{ args->callback, args->arg, args->name, 0, 0, false };
+    timers.push_back(t);
+    *out = t;
+    return ESP_OK;
+}
+int esp_timer_start_once(esp_timer_handle_t t, uint64_t us) {
+    t->dueUs = simNowUs() + us; t->periodUs = 0; t->armed = true;
+    return ESP_OK;
+}
+int esp_timer_start_periodic(esp_timer_handle_t t, uint64_t us) {
+    t->dueUs = simNowUs() + us; t->periodUs = us; t->armed = true;
+    return ESP_OK;
+}
+int esp_timer_stop(esp_timer_handle_t t) {
+    t->armed = false;
+    return ESP_OK;
+}
+
+// ============ GPIO ============
+// One interrupt type per pin as on the chip: attachInterrupt() sets an edge
+// type, gpio_wakeup_enable() a level type. A level interrupt runs its ISR
+// again as long as the level holds; SIM_STORM_CALLS in a row is a storm
+// (the chip would never leave the ISR), reported and fatal.
+#define SIM_PINS 64
+#define SIM_STORM_CALLS 1000
+static uint8_t pinLevel[SIM_PINS];
+static void (*pinIsr[SIM_PINS])();
+static gpio_int_type_t pinIntType[SIM_PINS];
+static uint32_t ledWrites = 0, toneChanges = 0;
+static uint32_t gpioIsrCalls = 0, gpioStorms = 0;
+gpio_dev_t GPIO;
+
+void pinMode(int pin, int mode) {
+    if (pin < 0 || pin >= SIM_PINS) return;
+    if (mode == INPUT_PULLUP) pinLevel[pin] = HIGH;
+}
+int digitalRead(int pin) { return pin >= 0 && pin < SIM_PINS ? pinLevel[pin] : LOW; }
+void digitalWrite(int pin, int level) { if (pin >= 0 && pin < SIM_PINS) pinLevel[pin] = level ? HIGH : LOW; }
+
+static bool pinLevelActive(int pin) {
+    gpio_int_type_t type = pinIntType[pin];
+    return (type == GPIO_INTR_LOW_LEVEL && !pinLevel[pin]) || (type == GPIO_INTR_HIGH_LEVEL && pinLevel[pin]);
+}
+
+static void simLevelInterrupt(int pin) {
+    for (int calls = 0; pinIsr[pin] && pinLevelActive(pin); calls++) {
+        if (calls == SIM_STORM_CALLS) {
+            gpioStorms++;
+            fprintf(stderr, "[SIM] GPIO%d: level interrupt storm, interrupt disabled\n", pin);
+            pinIntType[pin] = GPIO_INTR_DISABLE;
+            return;
+        }
+        gpioIsrCalls++;
+        pinIsr[pin]();
+    }
+}
+
+void simGpioSetType(int pin, gpio_int_type_t type) {
+    if (pin >= 0 && pin < SIM_PINS) pinIntType[pin] = type;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) {
+    if (pin < 0 || pin >= SIM_PINS) return ESP_FAIL;
+    pinIntType[pin] = type;
+    simLevelInterrupt(pin);
+    return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) {
+    if (type != GPIO_INTR_LOW_LEVEL && type != GPIO_INTR_HIGH_LEVEL) return ESP_FAIL;
+    return gpio_set_intr_type(pin, type);
+}
+
+void attachInterrupt(int pin, void (*isr)(), int mode) {
+    if (pin < 0 || pin >= SIM_PINS) return;
+    pinIsr[pin] = isr;
+    pinIntType[pin] = mode == CHANGE ? GPIO_INTR_ANYEDGE : mode == RISING ? GPIO_INTR_POSEDGE : GPIO_INTR_NEGEDGE;
+}
+void detachInterrupt(int pin) { if (pin >= 0 && pin < SIM_PINS) pinIsr[pin] = nullptr; }
+
+// Drive an input pin from the script, raising its interrupt if armed
+static void simSetPin(int pin, int level) {
+    if (pin < 0 || pin >= SIM_PINS || pinLevel[pin] == level) return;
+    pinLevel[pin] = level;
+    gpio_int_type_t type = pinIntType[pin];
+    if (pinIsr[pin] && (type == GPIO_INTR_ANYEDGE || (type == GPIO_INTR_POSEDGE && level) ||
+                        (type == GPIO_INTR_NEGEDGE && !level))) {
+        gpioIsrCalls++;
+        pinIsr[pin]();
+    }
+    simLevelInterrupt(pin);
+}
+
+void ledcSetup(int, int, int) {}
+void ledcAttachPin(int, int) {}
+bool ledcAttach(int, int, int) { return true; }
+void ledcDetachPin(int) {}
+bool ledcDetach(int) { return true; }
+void ledcWrite(int channel, int duty) {
+    ledWrites++;
+    if (opt.traceIo) fprintf(stderr, "[SIM %8.3f] ledc %d = %d\n", simNowUs() / 1e6, channel, duty);
+}
+esp_err_t dac_output_voltage(dac_channel_t, uint8_t value) {
+    if (value == 0) return ESP_OK;
+    toneChanges++;
+    return ESP_OK;
+}
+esp_err_t dac_cw_generator_config(dac_cw_config_t *cw) {
+    toneChanges++;
+    if (opt.traceIo) fprintf(stderr, "[SIM %8.3f] tone %u Hz\n", simNowUs() / 1e6, (unsigned)cw->freq);
+    return ESP_OK;
+}
+
+// ============ HW TIMER / PCNT ============
+// One-shot alarms on the virtual clock, 1 tick = 1 us (divider 80)
+struct SimHwTimer {
+    SimTimer *timer;
+    void (*isr)();
+    uint64_t zeroUs;                // Time the counter read 0
+    uint64_t alarmTicks;
+};
+
+static void hwTimerFire(void *arg) {
+    SimHwTimer *t = (SimHwTimer *)arg;
+    if (t->isr) t->isr();
+}
+
+hw_timer_t *timerBegin(uint8_t, uint16_t, bool) {
+    SimHwTimer *t = new SimHwTimer{ nullptr, nullptr, simNowUs(), 0 };
+    esp_timer_create_args_t args = { hwTimerFire, t, ESP_TIMER_TASK, "hw_timer", false };
+    esp_timer_create(&args, &t->timer);
+    return t;
+}
+void timerAttachInterrupt(hw_timer_t *t, void (*isr)(), bool) { t->isr = isr; }
+void timerWrite(hw_timer_t *t, uint64_t ticks) { t->zeroUs = simNowUs() - ticks; }
+void timerAlarmWrite(hw_timer_t *t, uint64_t ticks, bool) { t->alarmTicks = ticks; }
+void timerAlarmEnable(hw_timer_t *t) {
+    uint64_t due = t->zeroUs + t->alarmTicks, now = simNowUs();
+    esp_timer_start_once(t->timer, due > now ? due - now : 0);
+}
+void timerAlarmDisable(hw_timer_t *t) { esp_timer_stop(t->timer); }
+
+// PCNT unit 0 on VSYNC: with a high limit of 1 every edge is an event
+static void (*pcntIsr)(void *);
+static void *pcntIsrArg;
+static bool pcntRunning = false;
+static esp_timer_handle_t vsyncTimer = nullptr;
+static bool vsyncOn = false;                // Camera initialised
+static uint64_t vsyncZeroUs = 0;
+static uint32_t vsyncEvents = 0;
+
+esp_err_t pcnt_unit_config(const pcnt_config_t *) { return ESP_OK; }
+esp_err_t pcnt_event_enable(pcnt_unit_t, pcnt_evt_type_t) { return ESP_OK; }
+esp_err_t pcnt_isr_service_install(int) { return ESP_OK; }
+esp_err_t pcnt_isr_handler_add(pcnt_unit_t, void (*isr)(void *), void *arg) {
+    pcntIsr = isr;
+    pcntIsrArg = arg;
+    return ESP_OK;
+}
+static void simVsync(void *);
+
+// Edges are only simulated while something counts them, so an idle sketch
+// sees no extra timer callbacks; the phase follows the camera init
+static void simVsyncArm() {
+    if (!vsyncTimer) {
+        esp_timer_create_args_t args = { simVsync, nullptr, ESP_TIMER_TASK, "vsync", false };
+        esp_timer_create(&args, &vsyncTimer);
+    }
+    if (!vsyncOn || !pcntRunning) {
+        esp_timer_stop(vsyncTimer);
+        return;
+    }
+    uint64_t period = opt.captureUs, now = simNowUs();
+    uint64_t next = vsyncZeroUs + ((now - vsyncZeroUs) / period + 1) * period;
+    esp_timer_start_periodic(vsyncTimer, period);
+    vsyncTimer->dueUs = next;
+}
+
+esp_err_t pcnt_counter_pause(pcnt_unit_t) { pcntRunning = false; simVsyncArm(); return ESP_OK; }
+esp_err_t pcnt_counter_resume(pcnt_unit_t) { pcntRunning = true; simVsyncArm(); return ESP_OK; }
+esp_err_t pcnt_counter_clear(pcnt_unit_t) { return ESP_OK; }
+
+static void simVsync(void *) {
+    if (!pcntIsr) return;
+    vsyncEvents++;
+    if (opt.traceIo) fprintf(stderr, "[SIM %8.3f] vsync\n", simNowUs() / 1e6);
+    pcntIsr(pcntIsrArg);
+}
+
+// ============ SCRIPTED INPUT ============
+struct ScriptEvent {
+    uint64_t tUs;
+    int pin, level;
+};
+static std::vector<ScriptEvent> script;
+static size_t scriptPos = 0;
+
+static void scriptPress(uint64_t t, uint64_t holdUs) {
+    script.push_back({ t, simButtonPin, LOW });
+    script.push_back({ t + holdUs, simButtonPin, HIGH });
+}
+
+static void scriptMotion(uint64_t t) {
+    script.push_back({ t, simPirPin, HIGH });
+    script.push_back({ t + 2000000, simPirPin, LOW });    // HC-SR501 style 2 s pulse
+}
+
+// One event per line: "<ms> press <hold_ms>", "<ms> pir", "<ms> end"; # comments
+static bool loadScript(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return false; }
+    char line[256];
+    int lineNo = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        unsigned long long ms, hold = 100;
+        char what[32];
+        int n = sscanf(line, "%llu %31s %llu", &ms, what, &hold);
+        if (n < 2) continue;
+        uint64_t t = ms * 1000;
+        if (!strcmp(what, "press")) scriptPress(t, hold * 1000);
+        else if (!strcmp(what, "pir")) scriptMotion(t);
+        else if (!strcmp(what, "end")) endUs = t;
+        else { fprintf(stderr, "%s:%d: unknown event '%s'\n", path, lineNo, what); fclose(f); return false; }
+    }
+    fclose(f);
+    return true;
+}
+
+// ============ WAITING ============
+// Fire everything due up to `target` in time order; stop early once
+// ready() holds. Nested calls (a timer callback calling delay) only move
+// the clock.
+static bool inWait = false;
+
+bool simWaitUntil(bool (*ready)(void *), void *arg, uint64_t us) {
+    uint64_t target = simNowUs() + us;
+    if (us > endUs) target = endUs + 1;     // "forever"
+    if (inWait) { moveTo(target); return ready ? ready(arg) : false; }
+    inWait = true;
+
+    for (;;) {
+        if (ready && ready(arg)) { inWait = false; return true; }
+
+        SimTimer *next = nullptr;
+        for (SimTimer *t : timers) {
+            if (t->armed && (!next || t->dueUs < next->dueUs)) next = t;
+        }
+        uint64_t tTimer = next ? next->dueUs : UINT64_MAX;
+        uint64_t tScript = scriptPos < script.size() ? script[scriptPos].tUs : UINT64_MAX;
+        uint64_t tNext = std::min(tTimer, tScript);
+
+        if (tNext > target) break;
+        if (tNext > endUs) { moveTo(endUs); inWait = false; simFinish("end of run"); }
+        moveTo(tNext);
+
+        if (tScript <= tTimer) {
+            ScriptEvent &e = script[scriptPos++];
+            simSetPin(e.pin, e.level);
+        } else {
+            if (next->periodUs) next->dueUs += next->periodUs;
+            else next->armed = false;
+            timerFires++;
+            next->cb(next->arg);
+        }
+    }
+
+    if (target > endUs) { moveTo(endUs); inWait = false; simFinish("end of run"); }
+    moveTo(target);
+    inWait = false;
+    return ready ? ready(arg) : false;
+}
+
+void simAdvance(uint64_t us) {
+    if (us) simWaitUntil(nullptr, nullptr, us);
+}
+
+// ============ FREERTOS ============
+struct SimQueue {
+    uint8_t *buf;
+    size_t itemSize, cap, head, count;
+};
+
+static SimQueue mutexDummy;
+SemaphoreHandle_t xSemaphoreCreateMutex() { return &mutexDummy; }
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    SimQueue *q = new SimQueue{ (uint8_t *)malloc((size_t)length * itemSize), itemSize, length, 0, 0 };
+    return q;
+}
+
+static BaseType_t queuePush(SimQueue *q, const void *item) {
+    if (q->count == q->cap) return pdFALSE;
+    memcpy(q->buf + ((q->head + q->count) % q->cap) * q->itemSize, item, q->itemSize);
+    q->count++;
+    return pdTRUE;
+}
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t) { return queuePush(q, item); }
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) {
+    if (woken) *woken = pdFALSE;
+    return queuePush(q, item);
+}
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return q->count; }
+
+static bool queueReady(void *q) { return ((SimQueue *)q)->count > 0; }
+
+// ============ PER-EVENT STATISTICS ============
+// A blocking receive is loop() going idle: the time between two of them is
+// the handling of one event. Events that captured a frame count as scans.
+struct EventStats {
+    uint64_t realUs, virtUs;
+    int64_t heapPeakAbove;      // Bytes above the live level at event start
+};
+static std::vector<EventStats> scans;
+static uint32_t eventsHandled = 0;
+static uint32_t framesServed = 0;
+static bool inEvent = false;
+static uint64_t eventRealStart, eventVirtStart;
+static uint32_t eventFrameStart;
+static int64_t eventHeapStart;
+static uint64_t idleVirtUs = 0;
+
+static void eventEnd() {
+    if (!inEvent) return;
+    inEvent = false;
+    if (framesServed == eventFrameStart) return;
+    scans.push_back({ realUs() - eventRealStart, simNowUs() - eventVirtStart, heapEventPeak - eventHeapStart });
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    if (wait) eventEnd();
+    uint64_t idleStart = simNowUs();
+    bool got = q->count > 0 ||
+               (wait && simWaitUntil(queueReady, q, wait == portMAX_DELAY ? UINT64_MAX : (uint64_t)wait * 1000));
+    if (wait) idleVirtUs += simNowUs() - idleStart;
+    if (!got) return pdFALSE;
+
+    memcpy(item, q->buf + q->head * q->itemSize, q->itemSize);
+    q->head = (q->head + 1) % q->cap;
+    q->count--;
+    if (wait) {
+        inEvent = true;
+        eventsHandled++;
+        eventRealStart = realUs();
+        eventVirtStart = simNowUs();
+        eventFrameStart = framesServed;
+        eventHeapStart = heapEventPeak = heapLive;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *name, uint32_t, void *, UBaseType_t,
+                                   TaskHandle_t *out, int) {
+    fprintf(stderr, "[SIM] task '%s' not started (single-threaded host)\n", name);
+    if (out) *out = nullptr;
+    return pdPASS;
+}
+TaskHandle_t xTaskGetCurrentTaskHandle() { static int loopTask; return &loopTask; }
+void vTaskDelayUntil(TickType_t *prev, TickType_t period) {
+    *prev += period;
+    uint64_t due = (uint64_t)*prev * 1000;
+    if (due > simNowUs()) simAdvance(due - simNowUs());
+}
+
+// ============ CAMERA ============
+// Frames are fitted to the sensor field: the first configured size, at
+// least VGA. The output window (OV2640 set_res_raw / set_framesize) picks
+// a part of the field and scales it to the output size; the driver, like
+// the real one, drops output that does not fill its buffer exactly.
+struct SimFrame {
+    std::string name;
+    std::vector<uint8_t> pixels;    // Already fitted to the field
+};
+static std::vector<SimFrame> frames;
+static size_t frameNext = 0;
+static std::vector<camera_fb_t> simFbs;   // config.fb_count buffers
+static std::vector<bool> fbOut;
+static std::vector<void *> jpegBudget;     // What the driver would hold for JPEG buffers
+static int camWidth = 0, camHeight = 0;
+static int fieldWidth = 0, fieldHeight = 0;
+static struct { int x, y, w, h, outW, outH; } simWindow;
+static sensor_t simSensor;
+
+static const struct { framesize_t size; int w, h; } SIM_SIZES[] = {
+    { FRAMESIZE_QVGA, 320, 240 }, { FRAMESIZE_CIF, 400, 296 }, { FRAMESIZE_HVGA, 480, 320 },
+    { FRAMESIZE_VGA, 640, 480 }, { FRAMESIZE_SVGA, 800, 600 }, { FRAMESIZE_XGA, 1024, 768 },
+    { FRAMESIZE_HD, 1280, 720 }, { FRAMESIZE_SXGA, 1280, 1024 }, { FRAMESIZE_UXGA, 1600, 1200 },
+};
+
+static int sensorNoop(sensor_t *, int) { return 0; }
+static int sensorSetReg(sensor_t *, int, int, int) { return 0; }
+
+// Whole field scaled to the frame size
+static int sensorSetFramesize(sensor_t *, framesize_t size) {
+    for (auto &s : SIM_SIZES) {
+        if (s.size == size) {
+            simWindow = { 0, 0, fieldWidth, fieldHeight, s.w, s.h };
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// OV2640 semantics: startX is the readout mode (UXGA, SVGA, CIF), the window
+// is offset/total in that mode's pixels
+static int sensorSetResRaw(sensor_t *, int mode, int, int, int, int offsetX, int offsetY,
+                           int totalX, int totalY, int outputX, int outputY, bool, bool) {
+    static const int MODE_W[] = { 1600, 800, 400 };
+    if (mode < 0 || mode > 2 || outputX <= 0 || outputY <= 0) return -1;
+    double k = (double)fieldWidth / MODE_W[mode];
+    simWindow = { (int)(offsetX * k), (int)(offsetY * k), (int)(totalX * k), (int)(totalY * k), outputX, outputY };
+    if (simWindow.x + simWindow.w > fieldWidth || simWindow.y + simWindow.h > fieldHeight) return -1;
+    if (opt.traceIo) {
+        fprintf(stderr, "[SIM] window %d,%d %dx%d -> %dx%d\n", simWindow.x, simWindow.y,
+                simWindow.w, simWindow.h, outputX, outputY);
+    }
+    return 0;
+}
+
+// Binary PGM (P5, maxval 255), centre-cropped or padded with mid-grey
+static bool loadPgm(const std::string &path, int w, int h, std::vector<uint8_t> &out) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    int pw, ph, maxval;
+    char magic[3] = {};
+    bool ok = fscanf(f, "%2s", magic) == 1 && !strcmp(magic, "P5");
+    // Skip comments between header fields
+    auto field = [&](int *v) {
+        int c;
+        while ((c = fgetc(f)) != EOF) {
+            if (c == '#') { while ((c = fgetc(f)) != EOF && c != '\n') {} continue; }
+            if (!isspace(c)) { ungetc(c, f); break; }
+        }
+        return fscanf(f, "%d", v) == 1;
+    };
+    ok = ok && field(&pw) && field(&ph) && field(&maxval) && maxval == 255 && fgetc(f) != EOF;
+    std::vector<uint8_t> src;
+    if (ok) {
+        src.resize((size_t)pw * ph);
+        ok = fread(src.data(), 1, src.size(), f) == src.size();
+    }
+    fclose(f);
+    if (!ok) return false;
+
+    out.assign((size_t)w * h, 128);
+    int ox = (pw - w) / 2, oy = (ph - h) / 2;
+    for (int y = 0; y < h; y++) {
+        int sy = y + oy;
+        if (sy < 0 || sy >= ph) continue;
+        for (int x = 0; x < w; x++) {
+            int sx = x + ox;
+            if (sx >= 0 && sx < pw) out[(size_t)y * w + x] = src[(size_t)sy * pw + sx];
+        }
+    }
+    if (pw != w || ph != h) fprintf(stderr, "[SIM] %s: %dx%d fitted to %dx%d\n", path.c_str(), pw, ph, w, h);
+    return true;
+}
+
+static void loadFrames(int w, int h) {
+    if (opt.framesDir) {
+        std::vector<std::string> names;
+        if (DIR *d = opendir(opt.framesDir)) {
+            while (dirent *e = readdir(d)) {
+                const char *dot = strrchr(e->d_name, '.');
+                if (dot && !strcasecmp(dot, ".pgm")) names.push_back(e->d_name);
+            }
+            closedir(d);
+        }
+        std::sort(names.begin(), names.end());
+        for (const std::string &n : names) {
+            SimFrame fr{ n, {} };
+            if (loadPgm(std::string(opt.framesDir) + "/" + n, w, h, fr.pixels)) frames.push_back(std::move(fr));
+            else fprintf(stderr, "[SIM] %s: not a binary 8-bit PGM, skipped\n", n.c_str());
+        }
+    }
+    if (frames.empty()) {
+        fprintf(stderr, "[SIM] no frames, serving a blank grey frame\n");
+        frames.push_back({ "blank", std::vector<uint8_t>((size_t)w * h, 128) });
+    } else {
+        fprintf(stderr, "[SIM] %zu frames from %s\n", frames.size(), opt.framesDir);
+    }
+}
+
+esp_err_t esp_camera_init(const camera_config_t *config) {
+    camWidth = camHeight = 0;
+    for (auto &s : SIM_SIZES) {
+        if (s.size == config->frame_size) { camWidth = s.w; camHeight = s.h; }
+    }
+    if (!camWidth) return ESP_FAIL;
+    if (frames.empty()) {
+        // Enough scene for the largest grayscale profile (camera_config.h)
+        fieldWidth = std::max(camWidth, opt.psram ? 1024 : 640);
+        fieldHeight = std::max(camHeight, opt.psram ? 768 : 480);
+        heapPaused++;
+        loadFrames(fieldWidth, fieldHeight);
+        heapPaused--;
+    }
+    simWindow = { 0, 0, fieldWidth, fieldHeight, camWidth, camHeight };
+
+    // The driver's frame buffers live in the sketch's heap budget and init
+    // fails if they do not fit. A JPEG buffer is a fifth of the raw frame,
+    // as the driver sizes it; the stand-in below (a PGM header ahead of the
+    // pixels) is not counted.
+    int count = std::max(1, (int)config->fb_count);
+    bool jpeg = config->pixel_format == PIXFORMAT_JPEG;
+    size_t pixels = (size_t)camWidth * camHeight, budget = jpeg ? pixels / 5 : pixels;
+    if (budget * count > heapFree()) {
+        camWidth = camHeight = 0;
+        return ESP_ERR_NO_MEM;
+    }
+    simFbs.assign(count, camera_fb_t{});
+    fbOut.assign(simFbs.size(), false);
+    for (camera_fb_t &fb : simFbs) {
+        if (jpeg) {
+            jpegBudget.push_back(malloc(budget));
+            heapPaused++;
+            fb.buf = (uint8_t *)malloc(32 + pixels);
+            heapPaused--;
+        } else {
+            fb.buf = (uint8_t *)malloc(pixels);
+        }
+        fb.width = camWidth;
+        fb.height = camHeight;
+        fb.len = pixels;
+        fb.format = config->pixel_format;
+    }
+
+    simSensor.id.PID = OV2640_PID;
+    sensor_int_fn *fns[] = {
+        &simSensor.set_brightness, &simSensor.set_contrast, &simSensor.set_saturation, &simSensor.set_sharpness,
+        &simSensor.set_denoise, &simSensor.set_special_effect, &simSensor.set_whitebal, &simSensor.set_awb_gain,
+        &simSensor.set_wb_mode, &simSensor.set_exposure_ctrl, &simSensor.set_aec2, &simSensor.set_gain_ctrl,
+        &simSensor.set_agc_gain, &simSensor.set_bpc, &simSensor.set_wpc, &simSensor.set_raw_gma,
+        &simSensor.set_lenc, &simSensor.set_hmirror, &simSensor.set_vflip, &simSensor.set_dcw,
+        &simSensor.set_aec_value,
+    };
+    for (sensor_int_fn *fn : fns) *fn = sensorNoop;
+    simSensor.set_reg = sensorSetReg;
+    simSensor.set_framesize = sensorSetFramesize;
+    simSensor.set_res_raw = sensorSetResRaw;
+
+    // The sensor runs free from here: a VSYNC edge every frame period
+    vsyncZeroUs = simNowUs();
+    vsyncOn = true;
+    simVsyncArm();
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_deinit() {
+    for (camera_fb_t &fb : simFbs) {
+        if (fb.format == PIXFORMAT_JPEG) heapPaused++;
+        free(fb.buf);
+        if (fb.format == PIXFORMAT_JPEG) heapPaused--;
+    }
+    for (void *p : jpegBudget) free(p);
+    jpegBudget.clear();
+    simFbs.clear();
+    fbOut.clear();
+    camWidth = camHeight = 0;
+    vsyncOn = false;
+    simVsyncArm();
+    return ESP_OK;
+}
+
+// Window of the field scaled to the output, area average
+static void simRenderWindow(const std::vector<uint8_t> &field, uint8_t *out) {
+    const auto &wd = simWindow;
+    if (wd.x == 0 && wd.y == 0 && wd.w == fieldWidth && wd.h == fieldHeight &&
+        wd.outW == fieldWidth && wd.outH == fieldHeight) {
+        memcpy(out, field.data(), field.size());
+        return;
+    }
+    for (int oy = 0; oy < wd.outH; oy++) {
+        int y0 = wd.y + oy * wd.h / wd.outH, y1 = std::max(y0 + 1, wd.y + (oy + 1) * wd.h / wd.outH);
+        for (int ox = 0; ox < wd.outW; ox++) {
+            int x0 = wd.x + ox * wd.w / wd.outW, x1 = std::max(x0 + 1, wd.x + (ox + 1) * wd.w / wd.outW);
+            int sum = 0;
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) sum += field[(size_t)y * fieldWidth + x];
+            }
+            out[(size_t)oy * wd.outW + ox] = sum / ((y1 - y0) * (x1 - x0));
+        }
+    }
+}
+
+static int pgmHeader(char *out, size_t size, int w, int h) {
+    return snprintf(out, size, "P5\n%d %d\n255\n", w, h);
+}
+
+sensor_t *esp_camera_sensor_get() { return camWidth ? &simSensor : nullptr; }
+
+camera_fb_t *esp_camera_fb_get() {
+    // Every buffer held by the sketch: the real driver would block forever
+    size_t slot = std::find(fbOut.begin(), fbOut.end(), false) - fbOut.begin();
+    if (!camWidth || slot == fbOut.size()) return nullptr;
+    simAdvance(opt.captureUs);      // Wait for the next VSYNC
+    const SimFrame &fr = frames[frameNext++ % frames.size()];
+    camera_fb_t &fb = simFbs[slot];
+    if ((size_t)simWindow.outW * simWindow.outH != (size_t)camWidth * camHeight) {
+        fprintf(stderr, "[SIM] FB-SIZE: %dx%d window in a %dx%d buffer, frame dropped\n",
+                simWindow.outW, simWindow.outH, camWidth, camHeight);
+        return nullptr;
+    }
+    if (fb.format == PIXFORMAT_JPEG) {
+        int n = pgmHeader((char *)fb.buf, 32, camWidth, camHeight);
+        simRenderWindow(fr.pixels, fb.buf + n);
+        fb.len = n + (size_t)camWidth * camHeight;
+    } else {
+        simRenderWindow(fr.pixels, fb.buf);
+    }
+    uint64_t now = simNowUs();
+    fb.timestamp.tv_sec = now / 1000000;
+    fb.timestamp.tv_usec = now % 1000000;
+    fbOut[slot] = true;
+    framesServed++;
+    if (opt.traceIo) fprintf(stderr, "[SIM %8.3f] frame %s -> fb %zu\n", now / 1e6, fr.name.c_str(), slot);
+    return &fb;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb) {
+    for (size_t i = 0; i < simFbs.size(); i++) {
+        if (fb == &simFbs[i]) fbOut[i] = false;
+    }
+}
+
+// ============ "JPEG" ============
+
+bool fmt2jpg_cb(uint8_t *src, size_t len, uint16_t w, uint16_t h, pixformat_t, uint8_t, jpg_out_cb cb, void *arg) {
+    char hdr[32];
+    int n = pgmHeader(hdr, sizeof(hdr), w, h);
+    size_t index = 0;
+    if (cb(arg, index, hdr, n) != (size_t)n) return false;
+    index += n;
+    for (size_t off = 0; off < len; off += 4096) {
+        size_t chunk = std::min((size_t)4096, len - off);
+        if (cb(arg, index, src + off, chunk) != chunk) return false;
+        index += chunk;
+    }
+    cb(arg, index, nullptr, 0);     // End marker, as the encoder sends one
+    return true;
+}
+
+bool frame2jpg_cb(camera_fb_t *fb, uint8_t q, jpg_out_cb cb, void *arg) {
+    return fmt2jpg_cb(fb->buf, fb->len, fb->width, fb->height, fb->format, q, cb, arg);
+}
+
+bool fmt2jpg(uint8_t *src, size_t len, uint16_t w, uint16_t h, pixformat_t, uint8_t, uint8_t **out, size_t *outLen) {
+    char hdr[32];
+    int n = pgmHeader(hdr, sizeof(hdr), w, h);
+    *out = (uint8_t *)malloc(n + len);
+    if (!*out) return false;
+    memcpy(*out, hdr, n);
+    memcpy(*out + n, src, len);
+    *outLen = n + len;
+    return true;
+}
+
+bool frame2jpg(camera_fb_t *fb, uint8_t q, uint8_t **out, size_t *outLen) {
+    return fmt2jpg(fb->buf, fb->len, fb->width, fb->height, fb->format, q, out, outLen);
+}
+
+// ============ NETWORK ============
+// Every connect goes to the stand-in server; requests are tallied by path
+struct PathCount {
+    char path[48];
+    uint32_t count;
+};
+static PathCount httpPaths[16];
+static uint32_t connects = 0, connectFailures = 0;
+
+static void notePath(const char *reqLine) {
+    char method[8], path[48];
+    if (sscanf(reqLine, "%7s %47s", method, path) != 2) return;
+    char *q = strchr(path, '?');
+    if (q) *q = 0;
+    for (PathCount &p : httpPaths) {
+        if (!p.path[0]) snprintf(p.path, sizeof(p.path), "%s", path);
+        if (!strcmp(p.path, path)) { p.count++; return; }
+    }
+}
+
+static struct addrinfo *serverAddr() {
+    static struct addrinfo *res = nullptr;
+    if (res) return res;
+    char host[128];
+    snprintf(host, sizeof(host), "%s", opt.server);
+    char *colon = strrchr(host, ':');
+    const char *port = "80";
+    if (colon) { *colon = 0; port = colon + 1; }
+    struct addrinfo hints = {};
+    hints.ai_socktype = SOCK_STREAM;
+    // Cached for the whole run, like the runtime's other buffers: libc's
+    // resolver state would otherwise count as a sketch allocation on the
+    // first upload
+    heapPaused++;
+    if (getaddrinfo(host, port, &hints, &res) != 0) res = nullptr;
+    heapPaused--;
+    return res;
+}
+
+static int reqLineLen[1024];
+static char reqLine[1024][64];
+
+int WiFiClient::connect(const char *, uint16_t) {
+    stop();
+    connects++;
+    struct addrinfo *ai = serverAddr();
+    if (ai) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && ::connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) { close(fd); fd = -1; }
+    }
+    if (fd < 0) { connectFailures++; return 0; }
+    if (fd < 1024) reqLineLen[fd] = 0;
+    rxLen = rxPos = 0;
+    eof = false;
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t n) {
+    if (fd < 0) return 0;
+    // Capture the request line for the per-path tally
+    if (fd < 1024 && reqLineLen[fd] >= 0) {
+        for (size_t i = 0; i < n && reqLineLen[fd] >= 0; i++) {
+            if (buf[i] == '\r' || buf[i] == '\n' || reqLineLen[fd] == 63) {
+                reqLine[fd][reqLineLen[fd]] = 0;
+                notePath(reqLine[fd]);
+                reqLineLen[fd] = -1;
+            } else {
+                reqLine[fd][reqLineLen[fd]++] = buf[i];
+            }
+        }
+    }
+    size_t sent = 0;
+    while (sent < n) {
+        ssize_t r = send(fd, buf + sent, n - sent, MSG_NOSIGNAL);
+        if (r <= 0) { stop(); break; }
+        sent += r;
+    }
+    return sent;
+}
+
+// Wait up to waitMs of real time for data; the virtual clock includes it
+int WiFiClient::fill(int waitMs) {
+    if (fd < 0 || eof) return 0;
+    struct pollfd p = { fd, POLLIN, 0 };
+    if (poll(&p, 1, waitMs) <= 0) return 0;
+    ssize_t r = recv(fd, rx, sizeof(rx), 0);
+    if (r <= 0) { eof = true; return 0; }
+    rxLen = r;
+    rxPos = 0;
+    return r;
+}
+
+int WiFiClient::available() {
+    if (rxPos < rxLen) return rxLen - rxPos;
+    return fill(20);
+}
+
+int WiFiClient::read() {
+    if (rxPos >= rxLen && fill(0) <= 0) return -1;
+    return rx[rxPos++];
+}
+
+uint8_t WiFiClient::connected() {
+    if (fd < 0) return 0;
+    if (rxPos < rxLen) return 1;
+    if (!eof) fill(0);
+    return !eof || rxPos < rxLen;
+}
+
+void WiFiClient::stop() {
+    if (fd >= 0) close(fd);
+    fd = -1;
+    rxLen = rxPos = 0;
+}
+
+// ============ SERIAL ============
+static bool lineStart = true;
+
+size_t simSerialWrite(const uint8_t *buf, size_t n) {
+    if (opt.quiet) return n;
+    for (size_t i = 0; i < n; i++) {
+        if (buf[i] == '\r') continue;
+        if (lineStart) { printf("[%9.3f] ", simNowUs() / 1e6); lineStart = false; }
+        putchar(buf[i]);
+        if (buf[i] == '\n') lineStart = true;
+    }
+    return n;
+}
+
+// ============ FLASH ============
+static std::vector<uint8_t> benchPartition;
+static esp_partition_t benchPart = { ESP_PARTITION_TYPE_DATA, 0x40, 0x290000, 0, "benchframes" };
+
+static bool loadBenchImage(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return false; }
+    uint8_t buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) benchPartition.insert(benchPartition.end(), buf, buf + n);
+    fclose(f);
+    benchPart.size = benchPartition.size();
+    fprintf(stderr, "[SIM] benchframes partition: %zu bytes from %s\n", benchPartition.size(), path);
+    return true;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label) {
+    if (benchPartition.empty() || type != benchPart.type || subtype != benchPart.subtype) return nullptr;
+    return label && strcmp(label, benchPart.label) ? nullptr : &benchPart;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *part, size_t offset, size_t size, spi_flash_mmap_memory_t,
+                             const void **out, spi_flash_mmap_handle_t *handle) {
+    if (part != &benchPart || offset + size > benchPartition.size()) return ESP_FAIL;
+    *out = benchPartition.data() + offset;
+    *handle = 1;
+    return ESP_OK;
+}
+
+extern "C" char __executable_start, etext;
+
+bool simPtrInFlash(const void *p) {
+    const char *c = (const char *)p;
+    if (c >= &__executable_start && c < &etext) return true;
+    return !benchPartition.empty() && c >= (const char *)benchPartition.data() &&
+           c < (const char *)benchPartition.data() + benchPartition.size();
+}
+
+uint32_t EspClass::getCycleCount() {
+    return (uint32_t)(std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - realStart).count() * 24 / 100);
+}
+
+// ============ SLEEP / RESET ============
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return opt.wakeCause; }
+void esp_deep_sleep_start() { simFinish("deep sleep"); }
+void EspClass::restart() { simFinish("ESP.restart()"); }
+
+// ============ REPORT ============
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(q * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+static void simFinish(const char *why) {
+    fflush(stdout);
+    double virtS = simNowUs() / 1e6, realS = realUs() / 1e6;
+    std::vector<double> wall, virt;
+    int64_t heapScanPeak = 0;
+    for (const EventStats &s : scans) {
+        wall.push_back(s.realUs / 1e3);
+        virt.push_back(s.virtUs / 1e3);
+        heapScanPeak = std::max(heapScanPeak, s.heapPeakAbove);
+    }
+
+    fprintf(stderr, "\n=== HOST SIM REPORT (%s) ===\n", why);
+    fprintf(stderr, "virtual time   %.1f s, host time %.2f s (x%.0f)\n", virtS, realS, realS > 0 ? virtS / realS : 0);
+    fprintf(stderr, "events         %u handled, %u frames served, %u timer callbacks\n", eventsHandled, framesServed, timerFires);
+    fprintf(stderr, "scans          %zu (%.2f / min virtual), loop idle %.1f%%\n", scans.size(),
+            virtS > 0 ? scans.size() * 60.0 / virtS : 0, virtS > 0 ? 100.0 * idleVirtUs / 1e6 / virtS : 0);
+    if (!scans.empty()) {
+        fprintf(stderr, "scan host ms   p50 %.1f  p95 %.1f  max %.1f\n",
+                percentile(wall, 0.5), percentile(wall, 0.95), percentile(wall, 1.0));
+        fprintf(stderr, "scan virt ms   p50 %.1f  p95 %.1f  max %.1f\n",
+                percentile(virt, 0.5), percentile(virt, 0.95), percentile(virt, 1.0));
+    }
+    fprintf(stderr, "heap           peak %lld B above boot, %lld B live now, scan peak +%lld B, min free %lld B%s\n",
+            (long long)(heapPeak - heapBase), (long long)(heapLive - heapBase), (long long)heapScanPeak,
+            (long long)heapMinFree, heapMinFree < 0 ? " (OVER the simulated budget)" : "");
+    fprintf(stderr, "network        %u connects (%u failed)", connects, connectFailures);
+    for (const PathCount &p : httpPaths) {
+        if (p.path[0]) fprintf(stderr, ", %s x%u", p.path, p.count);
+    }
+    fprintf(stderr, "\nfeedback       %u LED writes, %u tone changes\n", ledWrites, toneChanges);
+    if (vsyncEvents) fprintf(stderr, "strobe         %u VSYNC interrupts\n", vsyncEvents);
+    fprintf(stderr, "gpio           %u interrupts, %u level storms%s\n", gpioIsrCalls, gpioStorms,
+            gpioStorms ? " (FAIL)" : "");
+    bool fewEvents = eventsHandled < opt.minEvents;
+    if (opt.minEvents) fprintf(stderr, "input          %u of %u expected events handled%s\n", eventsHandled,
+                               opt.minEvents, fewEvents ? " (FAIL)" : "");
+    fprintf(stderr, "alloc checks   %u scan phases allocated%s\n", *simAllocViolations,
+            *simAllocViolations && opt.failOnAlloc ? " (FAIL)" : "");
+    exit((*simAllocViolations && opt.failOnAlloc) || gpioStorms || fewEvents ? 1 : 0);
+}
+
+// ============ MAIN ============
+// Tools that call sketch functions directly link the runtime built with
+// SIM_NO_MAIN and call this instead of running setup()/loop()
+void simLibraryInit(bool quiet) {
+    realStart = SteadyClock::now();
+    endUs = UINT64_MAX - 1;
+    opt.quiet = quiet;
+}
+
+#ifndef SIM_NO_MAIN
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -f DIR      serve frames from DIR/*.pgm (8-bit binary PGM), round robin\n"
+        "  -s FILE     input script: '<ms> press <hold_ms>', '<ms> pir', '<ms> end'\n"
+        "  -e MS       short button press every MS (soak test)\n"
+        "  -d MS       run for MS of virtual time (default: script end, or 10 min with -e)\n"
+        "  -S HOST:PORT stand-in server (default 127.0.0.1:8787)\n"
+        "  -c MS       sensor frame period seen by esp_camera_fb_get (default 70)\n"
+        "  -b FILE     benchframes partition image (tools/bench_partition.py)\n"
+        "  -w          boot as a PIR (EXT0) wake from deep sleep\n"
+        "  -p          board has PSRAM\n"
+        "  -a          exit 1 if any scan phase allocated (alloc_check.h)\n"
+        "  -x N        exit 1 if fewer than N input events were handled\n"
+        "  -r          real time instead of accelerated\n"
+        "  -q          hide the sketch's serial output\n"
+        "  -v          trace frames, LED and tone changes\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    int c;
+    while ((c = getopt(argc, argv, "f:s:e:d:S:c:b:x:wpaqrvh")) != -1) {
+        switch (c) {
+            case 'f': opt.framesDir = optarg; break;
+            case 's': opt.scriptFile = optarg; break;
+            case 'e': opt.everyUs = strtoull(optarg, nullptr, 10) * 1000; break;
+            case 'd': opt.durationUs = strtoull(optarg, nullptr, 10) * 1000; break;
+            case 'S': opt.server = optarg; break;
+            case 'c': opt.captureUs = strtoull(optarg, nullptr, 10) * 1000; break;
+            case 'b': opt.benchImage = optarg; break;
+            case 'w': opt.wakeCause = ESP_SLEEP_WAKEUP_EXT0; break;
+            case 'p': opt.psram = true; break;
+            case 'a': opt.failOnAlloc = true; break;
+            case 'x': opt.minEvents = strtoul(optarg, nullptr, 10); break;
+            case 'r': opt.realtime = true; break;
+            case 'q': opt.quiet = true; break;
+            case 'v': opt.traceIo = true; break;
+            default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    // Scripted times are relative to power-on
+    realStart = SteadyClock::now();
+    heapPaused++;
+    if (opt.scriptFile && !loadScript(opt.scriptFile)) return 2;
+    if (opt.benchImage && !loadBenchImage(opt.benchImage)) return 2;
+    if (opt.everyUs) {
+        uint64_t until = opt.durationUs ? opt.durationUs : 600000000ULL;
+        for (uint64_t t = opt.everyUs; t + 200000 < until; t += opt.everyUs) scriptPress(t, 100000);
+    }
+    std::stable_sort(script.begin(), script.end(),
+                     [](const ScriptEvent &a, const ScriptEvent &b) { return a.tUs < b.tUs; });
+    if (!simPirEnabled) {
+        for (const ScriptEvent &e : script) {
+            if (e.pin == simPirPin) { fprintf(stderr, "[SIM] script has PIR events but ENABLE_PIR is off\n"); break; }
+        }
+    }
+
+    if (opt.durationUs) endUs = opt.durationUs;
+    else if (!endUs) endUs = (script.empty() ? 0 : script.back().tUs) + 10000000ULL;
+
+    heapPaused--;
+    heapBase = heapLive;
+    setup();
+    fprintf(stderr, "[SIM] setup() done at %.3f s, heap %lld B\n", simNowUs() / 1e6, (long long)(heapLive - heapBase));
+    for (;;) loop();
+}
+#endif
@@ -0,0 +1,17 @@
+// The whole firmware as one host translation unit, exactly as the Arduino
+// build sees it (the .ino first, its headers pulled in from there)
+#include <Arduino.h>
+
+#include "../../SmartFridgeScanner/SmartFridgeScanner.ino"
+
+// Pin numbers the runtime needs for scripted input
+extern const int simButtonPin = BOOT_BTN;
+extern const int simPirPin = PIR_PIN;
+#ifdef ENABLE_PIR
+extern const bool simPirEnabled = true;
+#else
+extern const bool simPirEnabled = false;
+#endif
+
+// Scan phases that allocated (alloc_check.h), for the report and -a
+extern const uint32_t *const simAllocViolations = &allocViolations;
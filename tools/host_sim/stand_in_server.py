@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Stand-in for the product server when running the host simulator.
+
+Accepts the firmware's requests on plain HTTP (the simulator's
+WiFiClientSecure is a TCP socket), drains chunked or fixed-length bodies
+and answers with canned JSON in the shape server/server.js returns.
+
+    python3 stand_in_server.py [--port 8787] [--delay-ms 150]
+"""
+import argparse
+import json
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+RESPONSES = {
+    "/api/product": {"success": True, "id": 1},
+    "/api/ocr": {"expiry_date": "2026-12-31", "confidence": 0.7},
+    "/api/receipt": {
+        "success": True,
+        "products_found": 2,
+        "products": [{"name": "Latte intero", "weight": "1 L"}, {"name": "Yogurt", "weight": None}],
+    },
+    "/api/telemetry": {"success": True},
+}
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    delay = 0.0
+    counts = {}
+
+    def read_body(self):
+        if self.headers.get("Transfer-Encoding", "").lower() == "chunked":
+            total = 0
+            while True:
+                size = int(self.rfile.readline().split(b";")[0], 16)
+                if size == 0:
+                    self.rfile.readline()
+                    return total
+                self.rfile.read(size + 2)
+                total += size
+        length = int(self.headers.get("Content-Length", 0))
+        self.rfile.read(length)
+        return length
+
+    def do_POST(self):
+        size = self.read_body()
+        path = self.path.split("?")[0]
+        self.counts[path] = self.counts.get(path, 0) + 1
+        if self.delay:
+            time.sleep(self.delay)
+        body = RESPONSES.get(path)
+        status = 200 if body is not None else 404
+        data = json.dumps(body if body is not None else {"error": "not found"}).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(data)
+        self.close_connection = True
+        self.log_message("%s %d bytes -> %d", path, size, status)
+
+    do_GET = do_POST
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--port", type=int, default=8787)
+    ap.add_argument("--delay-ms", type=int, default=0, help="server think time per request")
+    args = ap.parse_args()
+    Handler.delay = args.delay_ms / 1000.0
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), Handler)
+    print(f"stand-in server on 127.0.0.1:{args.port}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        print(json.dumps(Handler.counts))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,457 @@
+// Synthetic barcode frames: EAN-13, EAN-8, UPC-A and QR symbols rendered
+// into grayscale camera frames with controlled degradations.
+//
+// The label is a flat or cylindrical surface (curvature) posed in front of a
+// pinhole camera (module size = distance, roll, tilt). Each pixel is
+// supersampled 2x2 by ray casting onto the surface, then the frame goes
+// through the sensor chain in capture order: blur, exposure, flash hotspot, noise,
+// JPEG-like 8x8 DCT quantisation.
+#pragma once
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+enum SynthSymbology { SYNTH_EAN13, SYNTH_EAN8, SYNTH_UPCA, SYNTH_QR, SYNTH_SYMBOLOGIES };
+
+static const char *const SYNTH_SYMBOLOGY_NAMES[SYNTH_SYMBOLOGIES] = { "ean13", "ean8", "upca", "qr" };
+
+struct SynthParams {
+    double modulePx = 2.5;      // Module size at the label centre (distance)
+    double rollDeg = 0;         // In-plane rotation
+    double tiltDeg = 0;         // Rotation about the vertical axis (perspective)
+    double curveDeg = 0;        // Arc of a vertical cylinder the symbol covers
+    double defocus = 0;         // Gaussian sigma, px
+    double motionPx = 0;        // Horizontal box blur length, px
+    double noise = 0;           // Gaussian sensor noise sigma, gray levels
+    double exposure = 1;        // Scene light, < 1 = flash not reaching the label
+    double hotspot = 0;         // Specular peak added on the label, gray levels
+    int jpegQuality = 100;      // 100 = no compression artifacts
+    double offsetX = 0, offsetY = 0;    // Label centre offset from frame centre, px
+};
+
+// ============ RANDOM ============
+struct SynthRng {
+    uint64_t s;
+    explicit SynthRng(uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+    uint64_t next() { s ^= s << 13; s ^= s >> 7; s ^= s << 17; return s; }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    double range(double a, double b) { return a + (b - a) * uniform(); }
+    double gauss() {
+        double u = uniform() + 1e-12, v = uniform();
+        return sqrt(-2.0 * log(u)) * cos(2 * M_PI * v);
+    }
+    int digit() { return (int)(next() % 10); }
+};
+
+// ============ EAN / UPC ============
+// R codes; L = bitwise complement of R, G = R mirrored
+static const uint8_t SYNTH_EAN_R[10] = { 0x72, 0x66, 0x6C, 0x42, 0x5C, 0x4E, 0x50, 0x44, 0x48, 0x74 };
+static const uint8_t SYNTH_EAN_PARITY[10] = { 0x00, 0x0B, 0x0D, 0x0E, 0x13, 0x19, 0x1C, 0x15, 0x16, 0x1A };
+
+static void synthPush(std::vector<uint8_t> &bits, uint32_t code, int n) {
+    for (int i = n - 1; i >= 0; i--) bits.push_back((code >> i) & 1);
+}
+
+static uint8_t synthMirror7(uint8_t c) {
+    uint8_t r = 0;
+    for (int i = 0; i < 7; i++) if (c & (1 << i)) r |= 1 << (6 - i);
+    return r;
+}
+
+// Random digits with a valid check digit; EAN-13 weights 1,3 from the left,
+// EAN-8 and UPC-A 3,1
+static void synthDigits(SynthRng &rng, SynthSymbology sym, char *out) {
+    int n = sym == SYNTH_EAN13 ? 13 : sym == SYNTH_EAN8 ? 8 : 12;
+    int sum = 0;
+    for (int i = 0; i < n - 1; i++) {
+        int d = rng.digit();
+        out[i] = '0' + d;
+        bool heavy = sym == SYNTH_EAN13 ? (i % 2 == 1) : (i % 2 == 0);
+        sum += heavy ? d * 3 : d;
+    }
+    out[n - 1] = '0' + (10 - sum % 10) % 10;
+    out[n] = 0;
+}
+
+// Module sequence, 1 = bar
+static std::vector<uint8_t> synthEanModules(SynthSymbology sym, const char *digits) {
+    std::vector<uint8_t> bits;
+    int half = sym == SYNTH_EAN8 ? 4 : 6;
+    const char *left = sym == SYNTH_EAN13 ? digits + 1 : digits;
+    uint8_t parity = sym == SYNTH_EAN13 ? SYNTH_EAN_PARITY[digits[0] - '0'] : 0;
+    synthPush(bits, 0x5, 3);
+    for (int i = 0; i < half; i++) {
+        uint8_t r = SYNTH_EAN_R[left[i] - '0'];
+        bool g = parity & (1 << (half - 1 - i));
+        synthPush(bits, g ? synthMirror7(r) : (~r & 0x7F), 7);
+    }
+    synthPush(bits, 0x0A, 5);
+    for (int i = 0; i < half; i++) synthPush(bits, SYNTH_EAN_R[left[half + i] - '0'], 7);
+    synthPush(bits, 0x5, 3);
+    return bits;
+}
+
+// ============ QR (byte mode, level M, versions 1-3) ============
+// Single RS block per version keeps the encoder small; 42 bytes max.
+static uint8_t synthGfMul(uint8_t a, uint8_t b) {
+    int r = 0;
+    for (int i = 7; i >= 0; i--) {
+        r = (r << 1) ^ ((r >> 7) * 0x11D);
+        r ^= ((b >> i) & 1) * a;
+    }
+    return (uint8_t)r;
+}
+
+struct SynthQr {
+    int size = 0;
+    std::vector<uint8_t> dark, function;
+
+    bool get(int x, int y) const { return dark[y * size + x]; }
+    void set(int x, int y, bool d, bool fn = true) {
+        dark[y * size + x] = d;
+        if (fn) function[y * size + x] = 1;
+    }
+
+    void finder(int cx, int cy) {
+        for (int dy = -4; dy <= 4; dy++) {
+            for (int dx = -4; dx <= 4; dx++) {
+                int x = cx + dx, y = cy + dy;
+                if (x < 0 || y < 0 || x >= size || y >= size) continue;
+                int d = std::max(abs(dx), abs(dy));
+                set(x, y, d != 2 && d != 4);
+            }
+        }
+    }
+
+    void formatBits(int mask) {
+        int data = (0 << 3) | mask;     // Level M = 00
+        int rem = data;
+        for (int i = 0; i < 10; i++) rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+        int bits = ((data << 10) | rem) ^ 0x5412;
+        auto bit = [&](int i) { return ((bits >> i) & 1) != 0; };
+        for (int i = 0; i <= 5; i++) set(8, i, bit(i));
+        set(8, 7, bit(6)); set(8, 8, bit(7)); set(7, 8, bit(8));
+        for (int i = 9; i < 15; i++) set(14 - i, 8, bit(i));
+        for (int i = 0; i < 8; i++) set(size - 1 - i, 8, bit(i));
+        for (int i = 8; i < 15; i++) set(8, size - 15 + i, bit(i));
+        set(8, size - 8, true);
+    }
+
+    bool encode(const char *text) {
+        static const int dataCw[4] = { 0, 16, 28, 44 };
+        static const int eccCw[4] = { 0, 10, 16, 26 };
+        int len = (int)strlen(text);
+        int ver = 1;
+        while (ver <= 3 && len + 2 > dataCw[ver]) ver++;
+        if (ver > 3) return false;
+        size = 17 + 4 * ver;
+        dark.assign(size * size, 0);
+        function.assign(size * size, 0);
+
+        // Function patterns
+        for (int i = 0; i < size; i++) { set(6, i, i % 2 == 0); set(i, 6, i % 2 == 0); }
+        finder(3, 3); finder(size - 4, 3); finder(3, size - 4);
+        if (ver > 1) {
+            int a = size - 7;
+            for (int dy = -2; dy <= 2; dy++)
+                for (int dx = -2; dx <= 2; dx++) set(a + dx, a + dy, std::max(abs(dx), abs(dy)) != 1);
+        }
+        formatBits(0);
+
+        // Data codewords: mode 0100, 8-bit count, bytes, terminator, pad
+        std::vector<uint8_t> cw;
+        uint32_t acc = 0;
+        int nbits = 0;
+        auto put = [&](uint32_t v, int n) {
+            for (int i = n - 1; i >= 0; i--) {
+                acc = (acc << 1) | ((v >> i) & 1);
+                if (++nbits == 8) { cw.push_back((uint8_t)acc); acc = 0; nbits = 0; }
+            }
+        };
+        put(4, 4);
+        put(len, 8);
+        for (int i = 0; i < len; i++) put((uint8_t)text[i], 8);
+        put(0, std::min(4, dataCw[ver] * 8 - ((int)cw.size() * 8 + nbits)));
+        if (nbits) put(0, 8 - nbits);
+        for (int pad = 0xEC; (int)cw.size() < dataCw[ver]; pad ^= 0xEC ^ 0x11) cw.push_back(pad);
+
+        // Reed-Solomon ECC
+        int deg = eccCw[ver];
+        std::vector<uint8_t> div(deg, 0), rem(deg, 0);
+        div[deg - 1] = 1;
+        uint8_t root = 1;
+        for (int i = 0; i < deg; i++) {
+            for (int j = 0; j < deg; j++) {
+                div[j] = synthGfMul(div[j], root);
+                if (j + 1 < deg) div[j] ^= div[j + 1];
+            }
+            root = synthGfMul(root, 2);
+        }
+        for (uint8_t b : cw) {
+            uint8_t f = b ^ rem[0];
+            rem.erase(rem.begin());
+            rem.push_back(0);
+            for (int i = 0; i < deg; i++) rem[i] ^= synthGfMul(div[i], f);
+        }
+        cw.insert(cw.end(), rem.begin(), rem.end());
+
+        // Zig-zag placement, mask 0 ((x + y) % 2 == 0)
+        size_t i = 0;
+        for (int right = size - 1; right >= 1; right -= 2) {
+            if (right == 6) right = 5;
+            for (int vert = 0; vert < size; vert++) {
+                for (int j = 0; j < 2; j++) {
+                    int x = right - j;
+                    bool upward = ((right + 1) & 2) == 0;
+                    int y = upward ? size - 1 - vert : vert;
+                    if (function[y * size + x]) continue;
+                    bool d = i < cw.size() * 8 && ((cw[i >> 3] >> (7 - (i & 7))) & 1);
+                    i++;
+                    set(x, y, d != ((x + y) % 2 == 0), false);
+                }
+            }
+        }
+        return true;
+    }
+};
+
+// ============ SYMBOL ============
+struct SynthSymbol {
+    SynthSymbology sym;
+    char text[48];
+    std::vector<uint8_t> modules;   // 1D modules
+    SynthQr qr;
+    double width, height;           // Symbol size in modules, without quiet zone
+    double quiet;                   // Quiet zone, modules
+
+    void make(SynthSymbology s, SynthRng &rng) {
+        sym = s;
+        if (s == SYNTH_QR) {
+            snprintf(text, sizeof(text), "https://frigo.xamad.net/p/%06u", (unsigned)(rng.next() % 1000000));
+            qr.encode(text);
+            width = height = qr.size;
+            quiet = 4;
+        } else {
+            synthDigits(rng, s, text);
+            modules = synthEanModules(s, text);
+            width = (double)modules.size();
+            height = width * 0.7;
+            quiet = s == SYNTH_EAN8 ? 7 : 11;
+        }
+    }
+
+    // Reflectance at symbol coordinates (modules, origin at the centre):
+    // 1 label paper, 0 ink, -1 outside the label
+    double sample(double u, double v) const {
+        double lw = width / 2 + quiet + 2, lh = height / 2 + quiet + 2;
+        if (fabs(u) > lw || fabs(v) > lh) return -1;
+        double x = u + width / 2, y = v + height / 2;
+        if (x < 0 || y < 0 || x >= width || y >= height) return 1;
+        if (sym == SYNTH_QR) return qr.get((int)x, (int)y) ? 0 : 1;
+        return modules[(int)x] ? 0 : 1;
+    }
+};
+
+// Text the decoder is expected to report; UPC-A may also come back as the
+// equivalent EAN-13 with a leading 0
+static bool synthMatches(const SynthSymbol &s, const char *decoded) {
+    if (!strcmp(decoded, s.text)) return true;
+    return s.sym == SYNTH_UPCA && decoded[0] == '0' && !strcmp(decoded + 1, s.text);
+}
+
+// ============ RENDER ============
+#define SYNTH_INK     30.0
+#define SYNTH_PAPER   205.0
+#define SYNTH_BACKGROUND 95.0
+
+struct SynthFrame {
+    int width, height;
+    std::vector<uint8_t> pixels;
+};
+
+// Gaussian blur of a float image, separable, clamped edges
+static void synthGaussian(std::vector<float> &img, int w, int h, double sigma) {
+    if (sigma <= 0.05) return;
+    int r = (int)ceil(sigma * 3);
+    std::vector<float> k(2 * r + 1), tmp(img.size());
+    double sum = 0;
+    for (int i = -r; i <= r; i++) sum += k[i + r] = (float)exp(-i * i / (2 * sigma * sigma));
+    for (float &v : k) v /= (float)sum;
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            float a = 0;
+            for (int i = -r; i <= r; i++) a += k[i + r] * img[y * w + std::min(w - 1, std::max(0, x + i))];
+            tmp[y * w + x] = a;
+        }
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++) {
+            float a = 0;
+            for (int i = -r; i <= r; i++) a += k[i + r] * tmp[std::min(h - 1, std::max(0, y + i)) * w + x];
+            img[y * w + x] = a;
+        }
+}
+
+static void synthMotion(std::vector<float> &img, int w, int h, double length) {
+    int n = (int)lround(length);
+    if (n < 2) return;
+    std::vector<double> pre(w + 1);
+    for (int y = 0; y < h; y++) {
+        float *p = &img[(size_t)y * w];
+        for (int x = 0; x < w; x++) pre[x + 1] = pre[x] + p[x];
+        for (int x = 0; x < w; x++) {
+            int lo = std::max(0, x - n / 2), hi = std::min(w, x - n / 2 + n);
+            p[x] = (float)((pre[hi] - pre[lo]) / (hi - lo));
+        }
+    }
+}
+
+// Baseline-JPEG-like round trip: 8x8 DCT, IJG-scaled luma table, rounding
+static void synthJpeg(std::vector<float> &img, int w, int h, int quality) {
+    if (quality >= 100) return;
+    static const int LUMA[64] = {
+        16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55,
+        14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+        18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92,
+        49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99 };
+    int scale = quality < 50 ? 5000 / std::max(1, quality) : 200 - quality * 2;
+    double q[64], c[8][8];
+    for (int i = 0; i < 64; i++) q[i] = std::max(1, std::min(255, (LUMA[i] * scale + 50) / 100));
+    for (int u = 0; u < 8; u++)
+        for (int x = 0; x < 8; x++) c[u][x] = (u ? 0.5 : sqrt(0.125)) * cos((2 * x + 1) * u * M_PI / 16);
+
+    for (int by = 0; by + 8 <= h; by += 8) {
+        for (int bx = 0; bx + 8 <= w; bx += 8) {
+            double blk[8][8], tmp[8][8];
+            for (int y = 0; y < 8; y++)
+                for (int x = 0; x < 8; x++) blk[y][x] = img[(by + y) * w + bx + x] - 128;
+            for (int y = 0; y < 8; y++)
+                for (int u = 0; u < 8; u++) {
+                    double a = 0;
+                    for (int x = 0; x < 8; x++) a += c[u][x] * blk[y][x];
+                    tmp[y][u] = a;
+                }
+            for (int v = 0; v < 8; v++)
+                for (int u = 0; u < 8; u++) {
+                    double a = 0;
+                    for (int y = 0; y < 8; y++) a += c[v][y] * tmp[y][u];
+                    blk[v][u] = round(a / q[v * 8 + u]) * q[v * 8 + u];
+                }
+            for (int v = 0; v < 8; v++)
+                for (int x = 0; x < 8; x++) {
+                    double a = 0;
+                    for (int u = 0; u < 8; u++) a += c[u][x] * blk[v][u];
+                    tmp[v][x] = a;
+                }
+            for (int y = 0; y < 8; y++)
+                for (int x = 0; x < 8; x++) {
+                    double a = 0;
+                    for (int v = 0; v < 8; v++) a += c[v][y] * tmp[v][x];
+                    img[(by + y) * w + bx + x] = (float)(a + 128);
+                }
+        }
+    }
+}
+
+static void synthRender(const SynthSymbol &s, const SynthParams &p, SynthRng &rng, SynthFrame &out) {
+    int w = out.width, h = out.height;
+    double f = 0.98 * w;                        // ~54 deg horizontal field of view
+    double z0 = f / p.modulePx;                 // Distance in modules
+    double roll = p.rollDeg * M_PI / 180, tilt = p.tiltDeg * M_PI / 180;
+    double radius = p.curveDeg > 0 ? s.width / (p.curveDeg * M_PI / 180) : 0;
+
+    // Object pose: R = Rz(roll) * Ry(tilt), centre at T; rays go to object space via R^T
+    double cr = cos(roll), sr = sin(roll), ct = cos(tilt), st = sin(tilt);
+    double R[3][3] = { { cr * ct, -sr, cr * st }, { sr * ct, cr, sr * st }, { -st, 0, ct } };
+    double T[3] = { p.offsetX / p.modulePx, p.offsetY / p.modulePx, z0 };
+    double O[3];
+    for (int i = 0; i < 3; i++) O[i] = -(R[0][i] * T[0] + R[1][i] * T[1] + R[2][i] * T[2]);
+
+    // Soft room illumination on the background
+    std::vector<float> img((size_t)w * h);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            double dx = (x - w / 2.0) / w, dy = (y - h / 2.0) / h;
+            double shade = 1.0 - 0.6 * (dx * dx + dy * dy) + 0.08 * sin(x * 0.013 + y * 0.007);
+            double acc = 0;
+            for (int sy = 0; sy < 2; sy++) {
+                for (int sx = 0; sx < 2; sx++) {
+                    double d[3] = { (x + 0.25 + 0.5 * sx - w / 2.0) / f, (y + 0.25 + 0.5 * sy - h / 2.0) / f, 1 };
+                    double dd[3];
+                    for (int i = 0; i < 3; i++) dd[i] = R[0][i] * d[0] + R[1][i] * d[1] + R[2][i] * d[2];
+                    double u, v, light = 1, refl = -1;
+                    if (radius == 0) {
+                        if (fabs(dd[2]) > 1e-9) {
+                            double t = -O[2] / dd[2];
+                            u = O[0] + t * dd[0];
+                            v = O[1] + t * dd[1];
+                            if (t > 0) refl = s.sample(u, v);
+                        }
+                    } else {
+                        // Cylinder x^2 + (z - r)^2 = r^2 bulging towards the camera
+                        double ox = O[0], oz = O[2] - radius;
+                        double a = dd[0] * dd[0] + dd[2] * dd[2];
+                        double b = 2 * (ox * dd[0] + oz * dd[2]);
+                        double c = ox * ox + oz * oz - radius * radius;
+                        double disc = b * b - 4 * a * c;
+                        if (disc >= 0 && a > 0) {
+                            double t = (-b - sqrt(disc)) / (2 * a);
+                            double px = O[0] + t * dd[0], pz = O[2] + t * dd[2];
+                            double theta = atan2(px, radius - pz);
+                            if (t > 0 && fabs(theta) < M_PI / 2) {
+                                u = radius * theta;
+                                v = O[1] + t * dd[1];
+                                light = 0.55 + 0.45 * cos(theta);
+                                refl = s.sample(u, v);
+                            }
+                        }
+                    }
+                    acc += refl < 0 ? SYNTH_BACKGROUND * shade
+                                    : light * shade * (SYNTH_INK + (SYNTH_PAPER - SYNTH_INK) * refl);
+                }
+            }
+            img[(size_t)y * w + x] = (float)(acc / 4);
+        }
+    }
+
+    synthGaussian(img, w, h, p.defocus);
+    synthMotion(img, w, h, p.motionPx);
+    if (p.exposure != 1) {
+        for (float &v : img) v *= (float)p.exposure;
+    }
+
+    // Specular flash reflection somewhere on the symbol, clipping at white
+    if (p.hotspot > 0) {
+        double sigma = s.width * p.modulePx * 0.12;
+        double hx = w / 2.0 + p.offsetX + rng.range(-0.3, 0.3) * s.width * p.modulePx;
+        double hy = h / 2.0 + p.offsetY + rng.range(-0.2, 0.2) * s.height * p.modulePx;
+        int r = (int)(sigma * 3);
+        for (int y = std::max(0, (int)hy - r); y < std::min(h, (int)hy + r); y++)
+            for (int x = std::max(0, (int)hx - r); x < std::min(w, (int)hx + r); x++) {
+                double d2 = (x - hx) * (x - hx) + (y - hy) * (y - hy);
+                img[(size_t)y * w + x] += (float)(p.hotspot * exp(-d2 / (2 * sigma * sigma)));
+            }
+        for (float &v : img) v = std::min(v, 255.0f);
+    }
+
+    if (p.noise > 0) {
+        for (float &v : img) v += (float)(p.noise * rng.gauss());
+    }
+
+    synthJpeg(img, w, h, p.jpegQuality);
+
+    out.pixels.resize((size_t)w * h);
+    for (size_t i = 0; i < img.size(); i++) out.pixels[i] = (uint8_t)std::max(0.0f, std::min(255.0f, img[i] + 0.5f));
+}
+
+static bool synthWritePgm(const char *path, const SynthFrame &fr) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P5\n%d %d\n255\n", fr.width, fr.height);
+    bool ok = fwrite(fr.pixels.data(), 1, fr.pixels.size(), f) == fr.pixels.size();
+    return fclose(f) == 0 && ok;
+}
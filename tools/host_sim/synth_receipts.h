@@ -0,0 +1,121 @@
+// Synthetic receipt frames: a sheet of paper with lines of print, rotated
+// in the image plane, on a dim fridge background, for receipt_check.
+//
+// The ground truth is the paper's axis-aligned bounding box and its
+// rotation (positive = clockwise on screen, as receipt_processor.h).
+#pragma once
+
+#include "synth_frames.h"
+
+struct SynthReceiptParams {
+    int paperW = 300, paperH = 600;     // Paper size in frame pixels
+    double skewDeg = 0;                 // In-plane rotation, clockwise
+    double offsetX = 0, offsetY = 0;    // Paper centre offset from frame centre
+    double lineH = 18;                  // Text line pitch, px
+    double paper = 215, ink = 45;       // Gray levels before lighting
+    double background = 60;
+    double falloff = 0.25;              // Flash falloff towards the frame corners
+    double blur = 0.7;                  // Gaussian sigma, px
+    double noise = 4;                   // Sensor noise sigma, gray levels
+    bool blank = false;                 // No paper at all
+};
+
+struct SynthReceiptTruth {
+    int x0, y0, x1, y1;                 // Paper bounding box, exclusive end
+    double skewDeg;
+};
+
+// Print layout in paper coordinates: per line a run of words, each word a
+// run of glyph cells with a few vertical/horizontal strokes (enough texture
+// for the projection profile, not meant to be read)
+struct SynthReceiptPrint {
+    struct Word { float u0, u1; uint32_t seed; };
+    struct Line { float v0, v1; std::vector<Word> words; };
+    std::vector<Line> lines;
+    float glyphW;
+
+    void make(const SynthReceiptParams &p, SynthRng &rng) {
+        float margin = (float)std::max(12.0, p.paperW * 0.06);
+        glyphW = (float)(p.lineH * 0.55);
+        for (float v = margin; v + p.lineH < p.paperH - margin; v += (float)p.lineH) {
+            if (rng.uniform() < 0.15) continue;                 // Blank line
+            Line line{ v, v + (float)(p.lineH * 0.62), {} };
+            float u = margin + (rng.uniform() < 0.2 ? (float)(p.paperW * 0.3) : 0);
+            float end = p.paperW - margin - (float)(rng.uniform() * p.paperW * 0.3);
+            while (u < end) {
+                float len = glyphW * (float)(2 + rng.next() % 7);
+                line.words.push_back({ u, std::min(end, u + len), (uint32_t)rng.next() });
+                u += len + glyphW;
+            }
+            lines.push_back(line);
+        }
+    }
+
+    // Ink at paper point (u, v)?
+    bool ink(float u, float v) const {
+        for (const Line &l : lines) {
+            if (v < l.v0 || v >= l.v1) continue;
+            for (const Word &w : l.words) {
+                if (u < w.u0 || u >= w.u1) continue;
+                int cell = (int)((u - w.u0) / glyphW);
+                float gu = (u - w.u0) / glyphW - cell, gv = (v - l.v0) / (l.v1 - l.v0);
+                uint32_t bits = (w.seed >> (cell % 4) * 8) | 0x11;     // Never an empty glyph
+                if (gu > 0.8f) return false;                            // Gap between glyphs
+                if ((bits & 1) && gu < 0.2f) return true;               // Left stem
+                if ((bits & 2) && gu > 0.6f) return true;               // Right stem
+                if ((bits & 4) && gv < 0.15f) return true;              // Top bar
+                if ((bits & 8) && gv > 0.85f) return true;              // Bottom bar
+                if ((bits & 16) && gv > 0.45f && gv < 0.6f) return true; // Middle bar
+                return false;
+            }
+            return false;
+        }
+        return false;
+    }
+};
+
+static SynthReceiptTruth synthRenderReceipt(const SynthReceiptParams &p, SynthRng &rng, SynthFrame &out) {
+    const int w = out.width, h = out.height;
+    SynthReceiptPrint print;
+    print.make(p, rng);
+
+    double a = p.skewDeg * M_PI / 180, ca = cos(a), sa = sin(a);
+    double cx = w / 2.0 + p.offsetX, cy = h / 2.0 + p.offsetY;
+    double hw = p.paperW / 2.0, hh = p.paperH / 2.0;
+
+    SynthReceiptTruth truth;
+    double ex = fabs(hw * ca) + fabs(hh * sa), ey = fabs(hw * sa) + fabs(hh * ca);
+    truth.x0 = std::max(0, (int)floor(cx - ex));
+    truth.y0 = std::max(0, (int)floor(cy - ey));
+    truth.x1 = std::min(w, (int)ceil(cx + ex));
+    truth.y1 = std::min(h, (int)ceil(cy + ey));
+    truth.skewDeg = p.skewDeg;
+
+    std::vector<float> img((size_t)w * h);
+    double diag = sqrt((double)w * w + (double)h * h) / 2;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            double light = 1 - p.falloff * (((x - w / 2.0) * (x - w / 2.0) + (y - h / 2.0) * (y - h / 2.0)) / (diag * diag));
+            double acc = 0;
+            for (int s = 0; s < 4; s++) {
+                // 2x2 supersampling; frame -> paper is the inverse rotation
+                double px = x + 0.25 + 0.5 * (s & 1) - cx, py = y + 0.25 + 0.5 * (s >> 1) - cy;
+                double u = px * ca + py * sa + hw, v = -px * sa + py * ca + hh;
+                if (p.blank || u < 0 || v < 0 || u >= p.paperW || v >= p.paperH) {
+                    // Shelf-like bands so the background is not flat
+                    acc += p.background + 12 * sin(y * 0.021) + 6 * sin(x * 0.013);
+                } else {
+                    acc += print.ink((float)u, (float)v) ? p.ink : p.paper;
+                }
+            }
+            img[(size_t)y * w + x] = (float)(acc / 4 * light);
+        }
+    }
+    synthGaussian(img, w, h, p.blur);
+    if (p.noise > 0) {
+        for (float &v : img) v += (float)(p.noise * rng.gauss());
+    }
+    out.pixels.resize((size_t)w * h);
+    for (size_t i = 0; i < img.size(); i++) out.pixels[i] = (uint8_t)std::max(0.0f, std::min(255.0f, img[i] + 0.5f));
+    return truth;
+}
@@ -0,0 +1,243 @@
+// Decode rate vs. time sweep: renders synthetic frames (synth_frames.h) and
+// runs them through the firmware's own scanBarcode(), varying one
+// degradation at a time around a benign baseline.
+//
+//   ./build/synth_sweep                        all symbologies, axes, resolutions
+//   ./build/synth_sweep -s ean13 -a defocus,noise -r 640 -n 40 -o sweep.csv
+//   ./build/synth_sweep -d frames/             also write every frame as PGM,
+//                                              listed with its text in manifest.txt
+//
+// QR at 640x480 is also run as "qr 320x240": the same frames halved, as the
+// sensor delivers the whole field to the QR pass in band mode (no PSRAM).
+
+#include "sketch.cpp"
+#include "synth_frames.h"
+
+#include <chrono>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============ AXES ============
+struct SweepAxis {
+    const char *name;
+    std::vector<double> values;
+    void (*apply)(SynthParams &p, double v);
+};
+
+static const SweepAxis AXES[] = {
+    { "module_px", { 1.0, 1.5, 2.0, 2.5, 3.0, 4.0, 5.0 }, [](SynthParams &p, double v) { p.modulePx = v; } },
+    { "roll_deg",  { 0, 3, 6, 10, 15, 20, 30 },       [](SynthParams &p, double v) { p.rollDeg += v; } },
+    { "tilt_deg",  { 0, 15, 30, 45, 60 },             [](SynthParams &p, double v) { p.tiltDeg += v; } },
+    { "curve_deg", { 0, 30, 60, 90, 120, 150 },       [](SynthParams &p, double v) { p.curveDeg = v; } },
+    { "defocus",   { 0, 0.5, 1.0, 1.5, 2.0, 3.0 },    [](SynthParams &p, double v) { p.defocus = v; } },
+    { "motion_px", { 0, 2, 4, 6, 8, 12 },             [](SynthParams &p, double v) { p.motionPx = v; } },
+    { "noise",     { 0, 4, 8, 12, 16, 24 },           [](SynthParams &p, double v) { p.noise = v; } },
+    { "exposure",  { 1, 0.6, 0.4, 0.3, 0.2, 0.1 },    [](SynthParams &p, double v) { p.exposure = v; } },
+    { "hotspot",   { 0, 64, 128, 192, 255 },          [](SynthParams &p, double v) { p.hotspot = v; } },
+    { "jpeg_q",    { 100, 80, 60, 40, 20, 10 },       [](SynthParams &p, double v) { p.jpegQuality = (int)v; } },
+};
+static const int AXIS_COUNT = sizeof(AXES) / sizeof(AXES[0]);
+
+static const struct { int w, h; } RESOLUTIONS[] = { { 640, 480 }, { 1024, 768 } };
+
+// Baseline: in focus, clean, facing the camera at a whole-pixel module
+// size (the 1D decoder only locks onto integer module widths). Position and
+// a small roll are jittered so results do not hinge on one pixel phase.
+static SynthParams baseline(SynthSymbology sym, int w, int h, SynthRng &rng) {
+    SynthParams p;
+    p.modulePx = sym == SYNTH_QR ? 4.0 : 3.0;
+    p.rollDeg = rng.range(-0.5, 0.5);
+    p.offsetX = rng.range(-0.08, 0.08) * w;
+    p.offsetY = rng.range(-0.08, 0.08) * h;
+    return p;
+}
+
+static bool listed(const char *list, const char *name) {
+    if (!list) return true;
+    size_t n = strlen(name);
+    for (const char *p = list; (p = strstr(p, name)); p += n) {
+        bool startOk = p == list || p[-1] == ',';
+        bool endOk = p[n] == 0 || p[n] == ',';
+        if (startOk && endOk) return true;
+    }
+    return false;
+}
+
+// 2x2 box average, about what the OV2640 DSP scaler does for the whole field
+static void halveFrame(const SynthFrame &in, SynthFrame &out) {
+    out.width = in.width / 2;
+    out.height = in.height / 2;
+    out.pixels.resize((size_t)out.width * out.height);
+    for (int y = 0; y < out.height; y++) {
+        const uint8_t *a = &in.pixels[(size_t)2 * y * in.width], *b = a + in.width;
+        for (int x = 0; x < out.width; x++) {
+            out.pixels[(size_t)y * out.width + x] = (uint8_t)((a[2 * x] + a[2 * x + 1] + b[2 * x] + b[2 * x + 1] + 2) / 4);
+        }
+    }
+}
+
+static double percentile(std::vector<double> v, double q) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[(size_t)(q * (v.size() - 1) + 0.5)];
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -s LIST   symbologies: ean13,ean8,upca,qr (default all)\n"
+        "  -a LIST   axes (default all):", argv0);
+    for (const SweepAxis &a : AXES) fprintf(stderr, " %s", a.name);
+    fprintf(stderr, "\n"
+        "  -r RES    640 or 1024 (default both); 640 adds QR at 320x240 (band mode field)\n"
+        "  -n N      trials per point (default 10)\n"
+        "  -o FILE   CSV output\n"
+        "  -d DIR    write each rendered frame as DIR/<sym>_<w>_<axis>_<value>_<trial>.pgm\n"
+        "            plus DIR/manifest.txt for tools/bench_partition.py\n"
+        "  -S SEED   random seed (default 1)\n"
+        "  -v        show the scanner's serial output\n");
+}
+
+int main(int argc, char **argv) {
+    const char *syms = nullptr, *axes = nullptr, *csvPath = nullptr, *dumpDir = nullptr;
+    int onlyWidth = 0, trials = 10;
+    uint64_t seed = 1;
+    bool verbose = false;
+    int c;
+    while ((c = getopt(argc, argv, "s:a:r:n:o:d:S:vh")) != -1) {
+        switch (c) {
+            case 's': syms = optarg; break;
+            case 'a': axes = optarg; break;
+            case 'r': onlyWidth = atoi(optarg); break;
+            case 'n': trials = std::max(1, atoi(optarg)); break;
+            case 'o': csvPath = optarg; break;
+            case 'd': dumpDir = optarg; break;
+            case 'S': seed = strtoull(optarg, nullptr, 10); break;
+            case 'v': verbose = true; break;
+            default: usage(argv[0]); return c == 'h' ? 0 : 2;
+        }
+    }
+    simLibraryInit(!verbose);
+
+    FILE *csv = nullptr;
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) { perror(csvPath); return 1; }
+        fprintf(csv, "symbology,width,height,axis,value,trials,decoded,wrong,mean_ms,hit_ms,p95_ms\n");
+    }
+    FILE *manifest = nullptr;
+    if (dumpDir) {
+        mkdir(dumpDir, 0755);
+        std::string path = std::string(dumpDir) + "/manifest.txt";
+        manifest = fopen(path.c_str(), "w");
+        if (!manifest) { perror(path.c_str()); return 1; }
+    }
+
+    #ifdef SIM_QUIRC_STUB
+        if (!syms || listed(syms, "qr")) {
+            fprintf(stderr, "[SWEEP] built without QUIRC_DIR: QR frames are rendered but never decode\n");
+        }
+    #endif
+
+    for (auto res : RESOLUTIONS) {
+        if (onlyWidth && onlyWidth != res.w) continue;
+
+        // Same init path as the firmware, for this frame size (and the
+        // halved field at 640, one quirc per size like the camera profiles)
+        cleanupBarcodeScanner();
+        cameraFrameWidth = res.w;
+        cameraFrameHeight = res.h;
+        cameraInPsram = true;
+        cameraQrSizeCount = 0;
+        if (res.w == 640) {
+            cameraQrSizes[0][0] = res.w;     cameraQrSizes[0][1] = res.h;
+            cameraQrSizes[1][0] = res.w / 2; cameraQrSizes[1][1] = res.h / 2;
+            cameraQrSizeCount = 2;
+        }
+        initBarcodeScanner();
+
+        SynthFrame frame{ res.w, res.h, {} }, field{ res.w / 2, res.h / 2, {} };
+
+        // Symbology, and whether the frame is halved before decoding
+        std::vector<std::pair<int, bool>> targets;
+        for (int s = 0; s < SYNTH_SYMBOLOGIES; s++) {
+            if (!listed(syms, SYNTH_SYMBOLOGY_NAMES[s])) continue;
+            targets.push_back({ s, false });
+            if (s == SYNTH_QR && res.w == 640) targets.push_back({ s, true });
+        }
+
+        for (auto target : targets) {
+            int s = target.first;
+            bool half = target.second;
+            SynthSymbology sym = (SynthSymbology)s;
+            const SynthFrame &input = half ? field : frame;
+            camera_fb_t fb = {};
+            fb.width = input.width;
+            fb.height = input.height;
+            fb.len = (size_t)input.width * input.height;
+            fb.format = PIXFORMAT_GRAYSCALE;
+            printf("\n%s %dx%d%s\n%-10s %7s %6s %6s %9s %9s %9s\n", SYNTH_SYMBOLOGY_NAMES[s],
+                   input.width, input.height, half ? " (640x480 halved, band mode field)" : "",
+                   "axis", "value", "rate", "wrong", "mean_ms", "hit_ms", "p95_ms");
+
+            for (int a = 0; a < AXIS_COUNT; a++) {
+                const SweepAxis &axis = AXES[a];
+                if (!listed(axes, axis.name)) continue;
+                for (size_t vi = 0; vi < axis.values.size(); vi++) {
+                    double value = axis.values[vi];
+                    std::vector<double> times, hitTimes;
+                    int decoded = 0, wrong = 0;
+
+                    for (int t = 0; t < trials; t++) {
+                        // Every point is reproducible on its own
+                        SynthRng rng(seed ^ ((uint64_t)res.w << 48) ^ ((uint64_t)s << 40) ^
+                                     ((uint64_t)a << 32) ^ ((uint64_t)vi << 16) ^ (uint64_t)t);
+                        SynthSymbol symbol;
+                        symbol.make(sym, rng);
+                        SynthParams p = baseline(sym, res.w, res.h, rng);
+                        axis.apply(p, value);
+                        synthRender(symbol, p, rng, frame);
+                        if (half) halveFrame(frame, field);
+
+                        if (dumpDir) {
+                            char name[256], path[512];
+                            snprintf(name, sizeof(name), "%s_%d_%s_%g_%02d.pgm",
+                                     SYNTH_SYMBOLOGY_NAMES[s], input.width, axis.name, value, t);
+                            snprintf(path, sizeof(path), "%s/%s", dumpDir, name);
+                            if (!synthWritePgm(path, input)) { perror(path); return 1; }
+                            fprintf(manifest, "%s %s\n", name, symbol.text);
+                        }
+
+                        fb.buf = (uint8_t *)input.pixels.data();
+                        auto t0 = std::chrono::steady_clock::now();
+                        BarcodeResult r = scanBarcode(&fb);
+                        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                        times.push_back(ms);
+                        if (r.found) {
+                            if (synthMatches(symbol, r.data)) { decoded++; hitTimes.push_back(ms); }
+                            else wrong++;
+                        }
+                    }
+
+                    double mean = 0, hitMean = 0;
+                    for (double v : times) mean += v;
+                    for (double v : hitTimes) hitMean += v;
+                    mean /= times.size();
+                    if (!hitTimes.empty()) hitMean /= hitTimes.size();
+                    double p95 = percentile(times, 0.95);
+                    printf("%-10s %7g %5.0f%% %6d %9.3f %9.3f %9.3f\n", axis.name, value,
+                           100.0 * decoded / trials, wrong, mean, hitMean, p95);
+                    fflush(stdout);
+                    if (csv) {
+                        fprintf(csv, "%s,%d,%d,%s,%g,%d,%d,%d,%.4f,%.4f,%.4f\n", SYNTH_SYMBOLOGY_NAMES[s],
+                                fb.width, fb.height, axis.name, value, trials, decoded, wrong, mean, hitMean, p95);
+                    }
+                }
+            }
+        }
+    }
+    if (csv) fclose(csv);
+    if (manifest) fclose(manifest);
+    return 0;
+}